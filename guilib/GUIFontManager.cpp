@@ -25,6 +25,7 @@
 #include "SkinInfo.h"
 #include "GUIFontTTF.h"
 #include "GUIFont.h"
+#include "GUITextLayout.h"
 #include "XMLUtils.h"
 #include "GuiControlFactory.h"
 #include "../xbmc/Util.h"
@@ -217,6 +218,9 @@ void GUIFontManager::ReloadTTFFonts(void)
 {
    g_graphicsContext.SetScalingResolution(m_skinResolution, 0, 0, true);
 
+   // laid out text was measured with the old font sizes
+   CGUITextLayout::ClearCache();
+
    for (unsigned int i = 0; i < m_vecFonts.size(); i++)
    {
       CGUIFont* font = m_vecFonts[i];
@@ -268,6 +272,7 @@ void GUIFontManager::Unload(const CStdString& strFontName)
   {
     if ((*iFont)->GetFontName() == strFontName)
     {
+      CGUITextLayout::ClearCache();
       delete (*iFont);
       m_vecFonts.erase(iFont);
       return;
@@ -315,6 +320,8 @@ CGUIFont* GUIFontManager::GetFont(const CStdString& strFontName, bool fallback /
 
 void GUIFontManager::Clear()
 {
+  CGUITextLayout::ClearCache();
+
   for (int i = 0; i < (int)m_vecFonts.size(); ++i)
   {
     CGUIFont* pFont = m_vecFonts[i];
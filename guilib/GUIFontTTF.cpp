@@ -87,7 +87,11 @@ namespace MathUtils {
 DWORD PadPow2(DWORD x);
 
 #define CHARS_PER_TEXTURE_LINE 20 // number of characters to cache per texture line
-#define CHAR_CHUNK    64      // 64 chars allocated at a time (1024 bytes)
+#define CHAR_CHUNK    64      // initial size of the character array, doubled as needed
+#define CHAR_FREE     0xffffffff  // letterAndStyle of an evicted character slot
+#define MAX_TEXTURE_HEIGHT 4096
+
+#define CHAR_HASH(letterAndStyle) (((letterAndStyle) * 2654435761U) >> 8)
 
 int CGUIFontTTF::justification_word_weight = 6;   // weight of word spacing over letter spacing when justifying.
                                                   // A larger number means more of the "dead space" is placed between
@@ -189,6 +193,10 @@ CGUIFontTTF::CGUIFontTTF(const CStdString& strFileName)
   m_glTextureLoaded = false;
 #endif
   m_face = NULL;
+  m_charHash = NULL;
+  m_charHashMask = 0;
+  m_useCount = 0;
+  m_textureFull = false;
   memset(m_charquick, 0, sizeof(m_charquick));
   m_strFileName = strFileName;
   m_referenceCount = 0;
@@ -237,17 +245,28 @@ void CGUIFontTTF::ClearCharacterCache()
 #endif
     
   m_texture = NULL;
-  if (m_char)
-    delete[] m_char;
-  m_char = new Character[CHAR_CHUNK];
-  memset(m_charquick, 0, sizeof(m_charquick));
-  m_numChars = 0;
-  m_maxChars = CHAR_CHUNK;
+  ResetCharacters();
   // set the posX and posY so that our texture will be created on first character write.
   m_posX = m_textureWidth;
   m_posY = -(int)m_cellHeight;
 }
 
+void CGUIFontTTF::ResetCharacters()
+{
+  delete[] m_char;
+  m_char = NULL;
+  delete[] m_charHash;
+  m_charHash = NULL;
+  m_charHashMask = 0;
+  memset(m_charquick, 0, sizeof(m_charquick));
+  m_numChars = 0;
+  m_maxChars = 0;
+  m_freeChars.clear();
+  m_rowUsed.clear();
+  m_useCount = 0;
+  m_textureFull = false;
+}
+
 void CGUIFontTTF::Clear()
 {
   if (m_texture)
@@ -257,12 +276,7 @@ void CGUIFontTTF::Clear()
     SDL_FreeSurface(m_texture);
 #endif
   m_texture = NULL;
-  if (m_char)
-    delete[] m_char;
-  memset(m_charquick, 0, sizeof(m_charquick));
-  m_char = NULL;
-  m_maxChars = 0;
-  m_numChars = 0;
+  ResetCharacters();
   m_posX = 0;
   m_posY = 0;
   m_dwNestedBeginCount = 0;
@@ -328,12 +342,7 @@ bool CGUIFontTTF::Load(const CStdString& strFile, float height, float aspect, fl
     SDL_FreeSurface(m_texture);
 #endif
   m_texture = NULL;
-  if (m_char)
-    delete[] m_char;
-  m_char = NULL;
-
-  m_maxChars = 0;
-  m_numChars = 0;
+  ResetCharacters();
 
   m_strFilename = strFilename;
 
@@ -509,56 +518,45 @@ CGUIFontTTF::Character* CGUIFontTTF::GetCharacter(DWORD chr)
   {
     DWORD ch = (style << 8) | letter;
     if (m_charquick[ch])
+    {
+      m_rowUsed[m_charquick[ch]->row] = ++m_useCount;
       return m_charquick[ch];
+    }
   }
 
   // letters are stored based on style and letter
   DWORD ch = (style << 16) | letter;
 
-  int low = 0;
-  int high = m_numChars - 1;
-  int mid;
-  while (low <= high)
+  int index = FindCharacter(ch);
+  if (index >= 0)
   {
-    mid = (low + high) >> 1;
-    if (ch > m_char[mid].letterAndStyle)
-      low = mid + 1;
-    else if (ch < m_char[mid].letterAndStyle)
-      high = mid - 1;
-    else
-      return &m_char[mid];
+    m_rowUsed[m_char[index].row] = ++m_useCount;
+    return &m_char[index];
   }
-  // if we get to here, then low is where we should insert the new character
-
-  // increase the size of the buffer if we need it
-  if (m_numChars >= m_maxChars)
-  { // need to increase the size of the buffer
-    Character *newTable = new Character[m_maxChars + CHAR_CHUNK];
-    if (m_char)
-    {
-      memcpy(newTable, m_char, low * sizeof(Character));
-      memcpy(newTable + low + 1, m_char + low, (m_numChars - low) * sizeof(Character));
-      delete[] m_char;
-    }
-    m_char = newTable;
-    m_maxChars += CHAR_CHUNK;
 
-  }
+  // if we get to here, we need a slot for the new character
+  if (m_freeChars.empty() && m_numChars >= m_maxChars)
+    GrowCharacters();
+  if (m_freeChars.empty())
+    index = m_numChars;
   else
-  { // just move the data along as necessary
-    memmove(m_char + low + 1, m_char + low, (m_numChars - low) * sizeof(Character));
+  {
+    index = m_freeChars.back();
+    m_freeChars.pop_back();
   }
+
   // render the character to our texture
   // must End() as we can't render text to our texture during a Begin(), End() block
   DWORD dwNestedBeginCount = m_dwNestedBeginCount;
   m_dwNestedBeginCount = 1;
   if (dwNestedBeginCount) End();
-  if (!CacheCharacter(letter, style, m_char + low))
+  if (!CacheCharacter(letter, style, m_char + index))
   { // unable to cache character - try clearing them all out and starting over
     CLog::Log(LOGDEBUG, "GUIFontTTF::GetCharacter: Unable to cache character.  Clearing character cache of %i characters", m_numChars);
     ClearCharacterCache();
-    low = 0;
-    if (!CacheCharacter(letter, style, m_char + low))
+    GrowCharacters();
+    index = 0;
+    if (!CacheCharacter(letter, style, m_char + index))
     {
       CLog::Log(LOGERROR, "GUIFontTTF::GetCharacter: Unable to cache character (out of memory?)");
       if (dwNestedBeginCount) Begin();
@@ -569,18 +567,131 @@ CGUIFontTTF::Character* CGUIFontTTF::GetCharacter(DWORD chr)
   if (dwNestedBeginCount) Begin();
   m_dwNestedBeginCount = dwNestedBeginCount;
 
-  // fixup quick access
+  if (index == m_numChars)
+    m_numChars++;
+  InsertCharacter(index);
+  m_rowUsed[m_char[index].row] = ++m_useCount;
+
+  return m_char + index;
+}
+
+void CGUIFontTTF::GrowCharacters()
+{
+  int maxChars = m_maxChars ? m_maxChars * 2 : CHAR_CHUNK;
+  Character *newTable = new Character[maxChars];
+  if (m_char)
+  {
+    memcpy(newTable, m_char, m_numChars * sizeof(Character));
+    delete[] m_char;
+  }
+  m_char = newTable;
+  m_maxChars = maxChars;
+
+  // rebuild the hash and quick access for the new table
+  delete[] m_charHash;
+  m_charHash = new int[m_maxChars * 2];
+  m_charHashMask = m_maxChars * 2 - 1;
+  memset(m_charHash, 0xff, m_maxChars * 2 * sizeof(int));
   memset(m_charquick, 0, sizeof(m_charquick));
-  for(int i=0;i<m_numChars;i++)
+  for (int i = 0; i < m_numChars; i++)
+  {
+    if (m_char[i].letterAndStyle != CHAR_FREE)
+      InsertCharacter(i);
+  }
+}
+
+int CGUIFontTTF::FindCharacter(DWORD letterAndStyle) const
+{
+  if (!m_charHash)
+    return -1;
+
+  for (unsigned int slot = CHAR_HASH(letterAndStyle) & m_charHashMask; m_charHash[slot] >= 0; slot = (slot + 1) & m_charHashMask)
+  {
+    if (m_char[m_charHash[slot]].letterAndStyle == letterAndStyle)
+      return m_charHash[slot];
+  }
+  return -1;
+}
+
+void CGUIFontTTF::InsertCharacter(int index)
+{
+  DWORD letterAndStyle = m_char[index].letterAndStyle;
+
+  unsigned int slot = CHAR_HASH(letterAndStyle) & m_charHashMask;
+  while (m_charHash[slot] >= 0)
+    slot = (slot + 1) & m_charHashMask;
+  m_charHash[slot] = index;
+
+  if ((letterAndStyle & 0xffff) < 255)
+    m_charquick[((letterAndStyle & 0xffff0000) >> 8) | (letterAndStyle & 0xff)] = m_char + index;
+}
+
+void CGUIFontTTF::RemoveCharacter(int index)
+{
+  DWORD letterAndStyle = m_char[index].letterAndStyle;
+
+  unsigned int slot = CHAR_HASH(letterAndStyle) & m_charHashMask;
+  while (m_charHash[slot] != index)
   {
-    if ((m_char[i].letterAndStyle & 0xffff) < 255)
+    if (m_charHash[slot] < 0)
+      return;
+    slot = (slot + 1) & m_charHashMask;
+  }
+
+  // move following entries of the probe sequence into the gap, as lookups stop at the first empty slot
+  unsigned int next = (slot + 1) & m_charHashMask;
+  while (m_charHash[next] >= 0)
+  {
+    unsigned int ideal = CHAR_HASH(m_char[m_charHash[next]].letterAndStyle) & m_charHashMask;
+    if (((next - ideal) & m_charHashMask) >= ((next - slot) & m_charHashMask))
     {
-      DWORD ch = ((m_char[i].letterAndStyle & 0xffff0000) >> 8) | (m_char[i].letterAndStyle & 0xff);
-      m_charquick[ch] = m_char+i;
+      m_charHash[slot] = m_charHash[next];
+      slot = next;
     }
+    next = (next + 1) & m_charHashMask;
+  }
+  m_charHash[slot] = -1;
+
+  if ((letterAndStyle & 0xffff) < 255)
+    m_charquick[((letterAndStyle & 0xffff0000) >> 8) | (letterAndStyle & 0xff)] = NULL;
+
+  m_char[index].letterAndStyle = CHAR_FREE;
+  m_freeChars.push_back(index);
+}
+
+// drops the characters of the texture row that was used the longest time ago, and
+// makes it the current row
+bool CGUIFontTTF::EvictRow()
+{
+  int current = m_posY / (int)m_cellHeight;
+  int oldest = -1;
+  for (int i = 0; i < (int)m_rowUsed.size(); i++)
+  {
+    if (i != current && (oldest < 0 || m_useCount - m_rowUsed[i] > m_useCount - m_rowUsed[oldest]))
+      oldest = i;
+  }
+  if (oldest < 0 || !m_texture)
+    return false;
+
+  for (int i = 0; i < m_numChars; i++)
+  {
+    if (m_char[i].letterAndStyle != CHAR_FREE && m_char[i].row == oldest)
+      RemoveCharacter(i);
   }
 
-  return m_char + low;
+  m_posY = oldest * m_cellHeight;
+#ifndef HAS_SDL
+  D3DLOCKED_RECT rect;
+  m_texture->LockRect(0, &rect, NULL, 0);
+  memset((BYTE *)rect.pBits + m_posY * rect.Pitch, 0, rect.Pitch * m_cellHeight);
+  m_texture->UnlockRect(0);
+#else
+  SDL_LockSurface(m_texture);
+  memset((unsigned char *)m_texture->pixels + m_posY * m_texture->pitch, 0, m_texture->pitch * m_cellHeight);
+  SDL_UnlockSurface(m_texture);
+#endif
+  m_rowUsed[oldest] = m_useCount;
+  return true;
 }
 
 bool CGUIFontTTF::CacheCharacter(WCHAR letter, DWORD style, Character *ch)
@@ -617,13 +728,29 @@ bool CGUIFontTTF::CacheCharacter(WCHAR letter, DWORD style, Character *ch)
     m_posX += -bitGlyph->left;
 
   // check we have enough room for the character
-  if (m_posX + bitGlyph->left + bitmap.width > (int)m_textureWidth)
+  if (m_posY < 0 || m_posX + bitGlyph->left + bitmap.width > (int)m_textureWidth)
   { // no space - gotta drop to the next line (which means creating a new texture and copying it across)
     m_posX = 0;
-    m_posY += m_cellHeight;
     if (bitGlyph->left < 0)
       m_posX += -bitGlyph->left;
 
+    // check for max height (can't be more than 4096 texels), once there reuse the least recently used line
+    if (m_textureFull || m_posY + 2 * m_cellHeight > MAX_TEXTURE_HEIGHT)
+    {
+      if (!EvictRow())
+      {
+        CLog::Log(LOGDEBUG, "GUIFontTTF::CacheCharacter: New cache texture is too large (%i > %i pixels long)", m_posY + 2 * m_cellHeight, MAX_TEXTURE_HEIGHT);
+        FT_Done_Glyph(glyph);
+        return false;
+      }
+      m_textureFull = true;
+    }
+    else
+    {
+      m_posY += m_cellHeight;
+      m_rowUsed.push_back(m_useCount);
+    }
+
     if(m_posY + m_cellHeight >= m_textureHeight)
     {
       // create the new larger texture
@@ -631,14 +758,6 @@ bool CGUIFontTTF::CacheCharacter(WCHAR letter, DWORD style, Character *ch)
 #ifdef HAS_XBOX
       LPDIRECT3DTEXTURE8 newTexture;
 #endif
-      // check for max height (can't be more than 4096 texels)
-      if (newHeight > 4096)
-      {
-        CLog::Log(LOGDEBUG, "GUIFontTTF::CacheCharacter: New cache texture is too large (%i > 4096 pixels long)", newHeight);
-        FT_Done_Glyph(glyph);
-        return false;
-      }
-            
 #ifndef HAS_SDL      
       LPDIRECT3DTEXTURE8 newTexture;
       if (D3D_OK != D3DXCreateTexture(m_pD3DDevice, m_textureWidth, newHeight, 1, 0, D3DFMT_LIN_A8, D3DPOOL_MANAGED, &newTexture))
@@ -719,6 +838,7 @@ bool CGUIFontTTF::CacheCharacter(WCHAR letter, DWORD style, Character *ch)
 
   // set the character in our table
   ch->letterAndStyle = (style << 16) | letter;
+  ch->row = (unsigned short)(m_posY / m_cellHeight);
   ch->offsetX = (short)bitGlyph->left;
   ch->offsetY = (short)max((short)m_cellBaseLine - bitGlyph->top, 0);
   ch->left = (float)m_posX + ch->offsetX;
@@ -791,7 +911,6 @@ bool CGUIFontTTF::CacheCharacter(WCHAR letter, DWORD style, Character *ch)
 #endif    
   }
   m_posX += (unsigned short)max(ch->right - ch->left + ch->offsetX, ch->advance + 1);
-  m_numChars++;
 
   // free the glyph
   FT_Done_Glyph(glyph);
@@ -63,6 +63,7 @@ class CGUIFontTTF
     float left, top, right, bottom;
     float advance;
     DWORD letterAndStyle;
+    unsigned short row;   // texture row holding the glyph
   };
 public:
 
@@ -107,6 +108,14 @@ protected:
   bool CacheCharacter(WCHAR letter, DWORD style, Character *ch);
   inline void RenderCharacter(float posX, float posY, const Character *ch, D3DCOLOR dwColor, bool roundX);
   void ClearCharacterCache();
+  bool EvictRow();
+
+  // hash of letterAndStyle -> index in m_char
+  inline int FindCharacter(DWORD letterAndStyle) const;
+  void InsertCharacter(int index);
+  void RemoveCharacter(int index);
+  void GrowCharacters();
+  void ResetCharacters();
   
   // modifying glyphs
   void EmboldenGlyph(FT_GlyphSlot slot);
@@ -126,7 +135,14 @@ protected:
   Character *m_char;                 // our characters
   Character *m_charquick[256*4];     // ascii chars (4 styles) here
   int m_maxChars;                    // size of character array (can be incremented)
-  int m_numChars;                    // the current number of cached characters
+  int m_numChars;                    // the number of slots used in the character array
+  std::vector<int> m_freeChars;      // slots of characters that were evicted
+  int *m_charHash;                   // open addressed, 2 * m_maxChars entries, -1 if empty
+  unsigned int m_charHashMask;
+
+  std::vector<unsigned int> m_rowUsed; // last use of each texture row, for evicting once the texture is full
+  unsigned int m_useCount;
+  bool m_textureFull;                // the texture is at its maximum size
 
   float m_ellipsesWidth;               // this is used every character (width of '.')
 
@@ -22,6 +22,7 @@
 #include "include.h"
 #include "GUIIncludes.h"
 #include "SkinInfo.h"
+#include "GUIXMLCache.h"
 #include "utils/GUIInfoManager.h"
 
 using namespace std;
@@ -49,7 +50,7 @@ bool CGUIIncludes::LoadIncludes(const CStdString &includeFile)
     return true;
 
   TiXmlDocument doc;
-  if (!doc.LoadFile(includeFile.c_str()))
+  if (!CGUIXMLCache::Load(includeFile, doc))
   {
     CLog::Log(LOGINFO, "Error loading includes.xml file (%s): %s (row=%i, col=%i)", includeFile.c_str(), doc.ErrorDesc(), doc.ErrorRow(), doc.ErrorCol());
     return false;
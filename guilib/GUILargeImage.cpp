@@ -100,7 +100,11 @@ void CGUILargeImage::AllocResources()
 #else
     CGLTexture * texture;
 #endif
-    texture = g_largeTextureManager.GetImage(m_strFileName, m_iTextureWidth, m_iTextureHeight, m_orientation, !m_texturesAllocated);
+    // when the image is kept inside our bounds there's no point in decoding it any bigger
+    int maxSize = 0;
+    if (m_aspect.ratio == CAspectRatio::AR_KEEP)
+      maxSize = (int)(std::max(m_width * g_graphicsContext.GetGUIScaleX(), m_height * g_graphicsContext.GetGUIScaleY()) + 0.5f);
+    texture = g_largeTextureManager.GetImage(m_strFileName, m_iTextureWidth, m_iTextureHeight, m_orientation, !m_texturesAllocated, maxSize);
     m_texturesAllocated = true;
 
     if (!texture)
@@ -26,12 +26,120 @@
 #include "GUIControl.h"
 #include "GUIColorManager.h"
 #include "utils/CharsetConverter.h"
+#include "utils/CriticalSection.h"
+#include "utils/SingleLock.h"
 #include "StringUtils.h"
 
+#include <list>
+#include <map>
+
 using namespace std;
 
 #define WORK_AROUND_NEEDED_FOR_LINE_BREAKS
 
+#define TEXTLAYOUT_CACHE_SIZE 1000   // number of laid out strings we keep
+
+// Laid out text shared by all layouts, so labels showing text we've seen before (such as list items
+// scrolling back into view) don't parse, wrap and measure it again. Entries are only valid for the
+// fonts they were made with, so GUIFontManager clears the cache whenever fonts are reloaded or freed.
+class CTextLayoutCache
+{
+public:
+  struct Key
+  {
+    CGUIFont  *font;
+    float      maxWidth;    // 0 unless wrapping
+    float      maxHeight;   // 0 unless wrapping
+    CStdString text;
+
+    bool operator<(const Key &right) const
+    {
+      if (font != right.font) return font < right.font;
+      if (maxWidth != right.maxWidth) return maxWidth < right.maxWidth;
+      if (maxHeight != right.maxHeight) return maxHeight < right.maxHeight;
+      return text < right.text;
+    }
+  };
+
+  CTextLayoutCache()
+  {
+    m_generation = 0;
+    m_hits = 0;
+    m_misses = 0;
+  }
+
+  bool Get(const Key &key, vector<CGUIString> &lines, vector<DWORD> &colors, float &width)
+  {
+    CSingleLock lock(m_critSection);
+    map<Key, Entry>::iterator it = m_entries.find(key);
+    if (it == m_entries.end())
+    {
+      m_misses++;
+      return false;
+    }
+    m_hits++;
+    m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+    lines = it->second.lines;
+    colors = it->second.colors;
+    width = it->second.width;
+    return true;
+  }
+
+  void Add(const Key &key, const vector<CGUIString> &lines, const vector<DWORD> &colors, float width)
+  {
+    CSingleLock lock(m_critSection);
+    if (m_entries.find(key) != m_entries.end())
+      return;
+
+    while (m_entries.size() >= TEXTLAYOUT_CACHE_SIZE)
+    {
+      m_entries.erase(m_lru.back());
+      m_lru.pop_back();
+    }
+
+    m_lru.push_front(key);
+    Entry &entry = m_entries[key];
+    entry.lines = lines;
+    entry.colors = colors;
+    entry.width = width;
+    entry.lru = m_lru.begin();
+  }
+
+  void Clear()
+  {
+    CSingleLock lock(m_critSection);
+    if (m_hits + m_misses)
+      CLog::Log(LOGDEBUG, "%s - %u hits, %u misses (%u%% hit rate), %u entries", __FUNCTION__,
+                m_hits, m_misses, m_hits * 100 / (m_hits + m_misses), (unsigned int)m_entries.size());
+    m_entries.clear();
+    m_lru.clear();
+    m_hits = 0;
+    m_misses = 0;
+    m_generation++;
+  }
+
+  // changes each time the cache is cleared, ie. whenever measured widths may have changed
+  unsigned int GetGeneration() const { return m_generation; }
+
+private:
+  struct Entry
+  {
+    vector<CGUIString> lines;
+    vector<DWORD>      colors;
+    float              width;
+    list<Key>::iterator lru;
+  };
+
+  map<Key, Entry>  m_entries;
+  list<Key>        m_lru;        // most recently used first
+  unsigned int     m_generation;
+  unsigned int     m_hits;
+  unsigned int     m_misses;
+  CCriticalSection m_critSection;
+};
+
+static CTextLayoutCache g_textLayoutCache;
+
 CGUIString::CGUIString(iString start, iString end, bool carriageReturn)
 {
   m_text.assign(start, end);
@@ -52,6 +160,8 @@ CGUITextLayout::CGUITextLayout(CGUIFont *font, bool wrap, float fHeight)
   m_textColor = 0;
   m_wrap = wrap;
   m_maxHeight = fHeight;
+  m_textWidth = -1.0f;
+  m_textWidthGeneration = 0;
 }
 
 void CGUITextLayout::SetWrap(bool bWrap)
@@ -175,12 +285,27 @@ bool CGUITextLayout::Update(const CStdString &text, float maxWidth)
   if (text == m_lastText)
     return false;
 
-  // convert to utf16
-  CStdStringW utf16;
-  utf8ToW(text, utf16);
+  CTextLayoutCache::Key key;
+  key.font = m_font;
+  key.maxWidth = (m_wrap && maxWidth > 0) ? maxWidth : 0;
+  key.maxHeight = (m_wrap && maxWidth > 0) ? m_maxHeight : 0;
+  key.text = text;
 
-  // update
-  SetText(utf16, maxWidth);
+  unsigned int generation = g_textLayoutCache.GetGeneration();
+  if (m_font && g_textLayoutCache.Get(key, m_lines, m_colors, m_textWidth))
+    m_textWidthGeneration = generation;
+  else
+  {
+    // convert to utf16
+    CStdStringW utf16;
+    utf8ToW(text, utf16);
+
+    // update
+    SetText(utf16, maxWidth);
+
+    if (m_font)
+      g_textLayoutCache.Add(key, m_lines, m_colors, GetTextWidth());
+  }
 
   // and set our parameters to indicate no further update is required
   m_lastText = text;
@@ -194,6 +319,7 @@ void CGUITextLayout::SetText(const CStdStringW &text, float maxWidth)
   // empty out our previous string
   m_lines.clear();
   m_colors.clear();
+  m_textWidth = -1.0f;
   m_colors.push_back(m_textColor);
 
   // parse the text into our string objects
@@ -437,14 +563,19 @@ void CGUITextLayout::LineBreakText(const vector<DWORD> &text, vector<CGUIString>
 void CGUITextLayout::GetTextExtent(float &width, float &height)
 {
   if (!m_font) return;
-  width = 0;
-  for (vector<CGUIString>::iterator i = m_lines.begin(); i != m_lines.end(); i++)
+  if (m_textWidth < 0 || m_textWidthGeneration != g_textLayoutCache.GetGeneration())
   {
-    const CGUIString &string = *i;
-    float w = m_font->GetTextWidth(string.m_text);
-    if (w > width)
-      width = w;
+    m_textWidth = 0;
+    m_textWidthGeneration = g_textLayoutCache.GetGeneration();
+    for (vector<CGUIString>::iterator i = m_lines.begin(); i != m_lines.end(); i++)
+    {
+      const CGUIString &string = *i;
+      float w = m_font->GetTextWidth(string.m_text);
+      if (w > m_textWidth)
+        m_textWidth = w;
+    }
   }
+  width = m_textWidth;
   height = m_font->GetTextHeight(m_lines.size());
 }
 
@@ -554,4 +685,10 @@ void CGUITextLayout::Reset()
 {
   m_lines.clear();
   m_lastText.Empty();
+  m_textWidth = -1.0f;
+}
+
+void CGUITextLayout::ClearCache()
+{
+  g_textLayoutCache.Clear();
 }
@@ -75,6 +75,9 @@ public:
   static void DrawOutlineText(CGUIFont *font, float x, float y, DWORD color, DWORD outlineColor, DWORD outlineWidth, const CStdString &text);
   static void Filter(CStdString &text);
 
+  // drops the laid out text shared between layouts, must be called when fonts are reloaded or freed
+  static void ClearCache();
+
 protected:
   void ParseText(const CStdStringW &text, std::vector<DWORD> &parsedText);
   void LineBreakText(const std::vector<DWORD> &text, std::vector<CGUIString> &lines);
@@ -93,6 +96,8 @@ protected:
   DWORD m_textColor;
 
   CStdString m_lastText;
+  float m_textWidth;                      // width of the widest line, < 0 if not measured yet
+  unsigned int m_textWidthGeneration;     // cache generation the width was measured in
 private:
   static void AppendToUTF32(const CStdString &utf8, DWORD colStyle, std::vector<DWORD> &utf32);
   static void AppendToUTF32(const CStdStringW &utf16, DWORD colStyle, std::vector<DWORD> &utf32);
@@ -37,6 +37,7 @@
 #include "utils/SingleLock.h"
 #include "ButtonTranslator.h"
 #include "XMLUtils.h"
+#include "GUIXMLCache.h"
 
 #ifdef HAS_PERFORMANCE_SAMPLE
 #include "utils/PerformanceSample.h"
@@ -91,7 +92,7 @@ bool CGUIWindow::LoadReferences()
     return true;
 
   // nope - time to load it in
-  if ( !xmlDoc.LoadFile(strReferenceFile.c_str()) )
+  if ( !CGUIXMLCache::Load(strReferenceFile, xmlDoc) )
   {
 //    CLog::Log(LOGERROR, "unable to load:%s, Line %d\n%s", strReferenceFile.c_str(), xmlDoc.ErrorRow(), xmlDoc.ErrorDesc());
     return false;
@@ -167,7 +168,7 @@ bool CGUIWindow::Load(const CStdString& strFileName, bool bContainsPath)
     strPath = g_SkinInfo.GetSkinPath(strFileName, &resToUse);
   }
 
-  if ( !xmlDoc.LoadFile(strPath.c_str()) && !xmlDoc.LoadFile(strPath.ToLower().c_str()) && !xmlDoc.LoadFile(strLowerPath.c_str()))
+  if ( !CGUIXMLCache::Load(strPath, xmlDoc) && !xmlDoc.LoadFile(strPath.ToLower().c_str()) && !xmlDoc.LoadFile(strLowerPath.c_str()))
   {
     CLog::Log(LOGERROR, "unable to load:%s, Line %d\n%s", strPath.c_str(), xmlDoc.ErrorRow(), xmlDoc.ErrorDesc());
 #ifdef PRE_SKIN_VERSION_2_1_COMPATIBILITY
@@ -0,0 +1,286 @@
+/*
+ *      Copyright (C) 2005-2008 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+
+#include "include.h"
+#include "GUIXMLCache.h"
+#include "tinyXML/tinyxml.h"
+#include "Crc32.h"
+#include "FileSystem/File.h"
+
+#include <map>
+
+using namespace std;
+using namespace XFILE;
+
+#define XMLCACHE_MAGIC    "XSXC"
+#define XMLCACHE_VERSION  1
+
+// node types, each node is a run of unsigned ints:
+//   element: XMLCACHE_ELEMENT, name, attribute count, child count, (name, value) per attribute, children
+//   text:    XMLCACHE_TEXT, value, cdata
+// names and values are offsets into the string table
+#define XMLCACHE_ELEMENT  1
+#define XMLCACHE_TEXT     2
+
+struct SXMLCacheHeader
+{
+  char         magic[4];
+  unsigned int version;
+  __int64      mtime;       // of the XML file
+  __int64      size;
+  unsigned int stringSize;  // bytes of the string table
+  unsigned int nodeCount;   // unsigned ints of node data following it
+};
+
+class CXMLCacheWriter
+{
+public:
+  unsigned int AddString(const char *str)
+  {
+    map<string, unsigned int>::iterator it = m_offsets.find(str);
+    if (it != m_offsets.end())
+      return it->second;
+    unsigned int offset = m_strings.size();
+    m_strings.append(str);
+    m_strings.push_back('\0');
+    m_offsets.insert(make_pair(string(str), offset));
+    return offset;
+  }
+
+  void AddElement(const TiXmlElement *element)
+  {
+    m_nodes.push_back(XMLCACHE_ELEMENT);
+    m_nodes.push_back(AddString(element->Value()));
+    unsigned int attributes = m_nodes.size();
+    m_nodes.push_back(0);
+    unsigned int children = m_nodes.size();
+    m_nodes.push_back(0);
+
+    for (const TiXmlAttribute *attribute = element->FirstAttribute(); attribute; attribute = attribute->Next())
+    {
+      m_nodes.push_back(AddString(attribute->Name()));
+      m_nodes.push_back(AddString(attribute->Value()));
+      m_nodes[attributes]++;
+    }
+
+    // comments, declarations and the like aren't needed by the skin engine
+    for (const TiXmlNode *child = element->FirstChild(); child; child = child->NextSibling())
+    {
+      if (child->ToElement())
+        AddElement(child->ToElement());
+      else if (child->ToText())
+      {
+        m_nodes.push_back(XMLCACHE_TEXT);
+        m_nodes.push_back(AddString(child->Value()));
+        m_nodes.push_back(child->ToText()->CDATA() ? 1 : 0);
+      }
+      else
+        continue;
+      m_nodes[children]++;
+    }
+  }
+
+  string               m_strings;
+  vector<unsigned int> m_nodes;
+
+private:
+  map<string, unsigned int> m_offsets;
+};
+
+class CXMLCacheReader
+{
+public:
+  CXMLCacheReader(const char *strings, unsigned int stringSize, const unsigned int *nodes, unsigned int nodeCount)
+    : m_strings(strings), m_stringSize(stringSize), m_nodes(nodes), m_nodeCount(nodeCount), m_pos(0)
+  {
+  }
+
+  // reads the next node and appends it to parent
+  bool ReadNode(TiXmlNode *parent)
+  {
+    const char *value;
+    if (m_pos + 2 > m_nodeCount || !GetString(m_nodes[m_pos + 1], value))
+      return false;
+
+    if (m_nodes[m_pos] == XMLCACHE_TEXT)
+    {
+      if (m_pos + 3 > m_nodeCount)
+        return false;
+      TiXmlText *text = new TiXmlText(value);
+      text->SetCDATA(m_nodes[m_pos + 2] != 0);
+      parent->LinkEndChild(text);
+      m_pos += 3;
+      return true;
+    }
+    if (m_nodes[m_pos] != XMLCACHE_ELEMENT || m_pos + 4 > m_nodeCount)
+      return false;
+
+    unsigned int attributes = m_nodes[m_pos + 2];
+    unsigned int children = m_nodes[m_pos + 3];
+    m_pos += 4;
+
+    TiXmlElement *element = new TiXmlElement(value);
+    parent->LinkEndChild(element);
+    if (attributes > (m_nodeCount - m_pos) / 2)
+      return false;
+    for (unsigned int i = 0; i < attributes; i++, m_pos += 2)
+    {
+      const char *name;
+      if (!GetString(m_nodes[m_pos], name) || !GetString(m_nodes[m_pos + 1], value))
+        return false;
+      element->SetAttribute(name, value);
+    }
+    for (unsigned int i = 0; i < children; i++)
+    {
+      if (!ReadNode(element))
+        return false;
+    }
+    return true;
+  }
+
+  bool AtEnd() const { return m_pos == m_nodeCount; }
+
+private:
+  bool GetString(unsigned int offset, const char *&str) const
+  {
+    if (offset >= m_stringSize)
+      return false;
+    str = m_strings + offset;
+    return true;
+  }
+
+  const char         *m_strings;
+  unsigned int        m_stringSize;
+  const unsigned int *m_nodes;
+  unsigned int        m_nodeCount;
+  unsigned int        m_pos;
+};
+
+bool CGUIXMLCache::Load(const CStdString &strFile, TiXmlDocument &doc)
+{
+  struct __stat64 stat;
+  if (CFile::Stat(strFile, &stat) != 0)
+    return doc.LoadFile(strFile.c_str());
+
+#ifndef _LINUX
+  __int64 mtime = stat.st_mtime;
+#else
+  __int64 mtime = stat._st_mtime;
+#endif
+
+  CStdString strCacheFile = GetCacheFile(strFile);
+  if (LoadCache(strCacheFile, mtime, stat.st_size, doc))
+    return true;
+
+  doc.Clear();
+  if (!doc.LoadFile(strFile.c_str()))
+    return false;
+
+  if (doc.RootElement() && !SaveCache(strCacheFile, mtime, stat.st_size, doc.RootElement()))
+    CLog::Log(LOGDEBUG, "%s - unable to write %s for %s", __FUNCTION__, strCacheFile.c_str(), strFile.c_str());
+  return true;
+}
+
+CStdString CGUIXMLCache::GetCacheFile(const CStdString &strFile)
+{
+  Crc32 crc;
+  crc.ComputeFromLowerCase(strFile);
+
+  CStdString strCacheFile;
+  strCacheFile.Format("Z:\\skin-%08x.xsc", (unsigned __int32)crc);
+  return strCacheFile;
+}
+
+bool CGUIXMLCache::LoadCache(const CStdString &strCacheFile, __int64 mtime, __int64 size, TiXmlDocument &doc)
+{
+  CFile file;
+  if (!file.Open(strCacheFile))
+    return false;
+
+  __int64 length = file.GetLength();
+  if (length < (__int64)sizeof(SXMLCacheHeader) || length > 16 * 1024 * 1024)
+    return false;
+
+  vector<char> buffer((unsigned int)length);
+  if (file.Read(&buffer[0], length) != length)
+    return false;
+  file.Close();
+
+  SXMLCacheHeader header;
+  memcpy(&header, &buffer[0], sizeof(header));
+  if (memcmp(header.magic, XMLCACHE_MAGIC, 4) || header.version != XMLCACHE_VERSION ||
+      header.mtime != mtime || header.size != size)
+    return false;
+
+  // string table, then the nodes aligned to 4 bytes
+  unsigned int nodeStart = (sizeof(header) + header.stringSize + 3) & ~3;
+  if (header.stringSize == 0 || header.stringSize > length || nodeStart > length || (length - nodeStart) / sizeof(unsigned int) < header.nodeCount ||
+      buffer[sizeof(header) + header.stringSize - 1] != '\0')
+    return false;
+
+  CXMLCacheReader reader(&buffer[sizeof(header)], header.stringSize, (const unsigned int *)&buffer[nodeStart], header.nodeCount);
+  if (!reader.ReadNode(&doc) || !reader.AtEnd() || !doc.RootElement())
+  {
+    CLog::Log(LOGWARNING, "%s - %s is corrupt", __FUNCTION__, strCacheFile.c_str());
+    doc.Clear();
+    CFile::Delete(strCacheFile);
+    return false;
+  }
+  return true;
+}
+
+bool CGUIXMLCache::SaveCache(const CStdString &strCacheFile, __int64 mtime, __int64 size, const TiXmlElement *root)
+{
+  CXMLCacheWriter writer;
+  writer.AddElement(root);
+
+  SXMLCacheHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, XMLCACHE_MAGIC, 4);
+  header.version = XMLCACHE_VERSION;
+  header.mtime = mtime;
+  header.size = size;
+  header.stringSize = writer.m_strings.size();
+  header.nodeCount = writer.m_nodes.size();
+
+  string data((const char *)&header, sizeof(header));
+  data.append(writer.m_strings);
+  data.resize((data.size() + 3) & ~3, '\0');
+  data.append((const char *)&writer.m_nodes[0], writer.m_nodes.size() * sizeof(unsigned int));
+
+  // write to a temporary file first, so a partly written cache is never picked up
+  CStdString strTempFile = strCacheFile + ".tmp";
+  CFile file;
+  if (!file.OpenForWrite(strTempFile, true, true))
+    return false;
+  bool written = file.Write(data.c_str(), data.size()) == (int)data.size();
+  file.Close();
+
+  if (written)
+    CFile::Delete(strCacheFile);
+  if (!written || !CFile::Rename(strTempFile, strCacheFile))
+  {
+    CFile::Delete(strTempFile);
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2005-2008 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "StdString.h"
+#include <vector>
+
+class TiXmlDocument;
+class TiXmlElement;
+class TiXmlNode;
+
+/*
+ * Keeps parsed skin XML files (windows, includes, references) in a compact
+ * binary form in the temp folder, so later loads rebuild the tree without
+ * parsing the text again. A cache file is only used while the size and
+ * modification time of the XML file match the ones it was made from.
+ *
+ * The tree is stored as parsed, before includes are resolved, as include
+ * conditions depend on the state at load time. This only saves the XML parse
+ * (the "xml load" part of the time CGUIWindow::Load logs), include resolution
+ * and control creation still run on every load.
+ */
+class CGUIXMLCache
+{
+public:
+  // same as doc.LoadFile(), on failure the error of the XML parse is left in doc
+  static bool Load(const CStdString &strFile, TiXmlDocument &doc);
+
+private:
+  static CStdString GetCacheFile(const CStdString &strFile);
+  static bool LoadCache(const CStdString &strCacheFile, __int64 mtime, __int64 size, TiXmlDocument &doc);
+  static bool SaveCache(const CStdString &strCacheFile, __int64 mtime, __int64 size, const TiXmlElement *root);
+};
@@ -4330,6 +4330,8 @@ void CApplication::Stop()
     m_defaultSystemDevice->setDefault();
   }
 #endif
+
+  CLog::StopAsync();
 }
 
 bool CApplication::PlayMedia(const CFileItem& item, int iPlaylist)
@@ -216,11 +216,13 @@ void CDatabase::Close()
   m_bOpen = false;
 
   if (NULL == m_pDB.get() ) return ;
+  // datasets hand their statements back to the connection, so they go first
   if (NULL != m_pDS.get()) m_pDS->close();
-  m_pDB->disconnect();
-  m_pDB.reset();
+  if (NULL != m_pDS2.get()) m_pDS2->close();
   m_pDS.reset();
   m_pDS2.reset();
+  m_pDB->disconnect();
+  m_pDB.reset();
 }
 
 bool CDatabase::Compress(bool bForce /* =true */)
@@ -21,6 +21,7 @@
 
 #include "stdafx.h"
 #include "FileItem.h"
+#include "FileItemDiscCache.h"
 #include "Util.h"
 #include "Picture.h"
 #include "PlayListFactory.h"
@@ -41,6 +42,10 @@
 #include "utils/TuxBoxUtil.h"
 #include "VideoInfoTag.h"
 #include "utils/SingleLock.h"
+#include "utils/Thread.h"
+#ifdef _LINUX
+#include "utils/CPUInfo.h"
+#endif
 #include "MusicInfoTag.h"
 #include "PictureInfoTag.h"
 #include "Artist.h"
@@ -1506,6 +1511,130 @@ void CFileItemList::Sort(FILEITEMLISTCOMPARISONFUNC func)
   CLog::Log(LOGDEBUG,"%s, sorting took %u millis", __FUNCTION__, dwElapsed);
 }
 
+// one entry per item, sorted instead of the items themselves
+struct SSortKeyEntry
+{
+  const unsigned char* key;
+  unsigned int         length;
+  int                  group;   // 0 for folders and 1 for files, unless folders are ignored
+  unsigned int         index;   // position in m_items, also used as the final tie break
+};
+
+struct SSortKeyCompare
+{
+  SSortKeyCompare(bool ascending) : m_ascending(ascending) {}
+
+  bool operator()(const SSortKeyEntry &left, const SSortKeyEntry &right) const
+  {
+    if (left.group != right.group)
+      return left.group < right.group;
+
+    int result = memcmp(left.key, right.key, left.length < right.length ? left.length : right.length);
+    if (result == 0 && left.length != right.length)
+      result = left.length < right.length ? -1 : 1;
+    if (result != 0)
+      return m_ascending ? result < 0 : result > 0;
+    return left.index < right.index;
+  }
+
+  bool m_ascending;
+};
+
+// sorts a range of the key entries on its own thread
+class CSortKeyJob : public IRunnable
+{
+public:
+  CSortKeyJob(SSortKeyEntry* first, SSortKeyEntry* last, bool ascending)
+    : m_first(first), m_last(last), m_compare(ascending) {}
+
+  virtual void Run()
+  {
+    std::sort(m_first, m_last, m_compare);
+  }
+
+private:
+  SSortKeyEntry* m_first;
+  SSortKeyEntry* m_last;
+  SSortKeyCompare m_compare;
+};
+
+// lists of at least this many items are split over two threads when there is more than one core
+#define PARALLEL_SORT_MIN_ITEMS 8192
+
+void CFileItemList::SortBySortLabel(bool ignoreFolders, bool ascending)
+{
+  CSingleLock lock(m_lock);
+  DWORD dwStart = GetTickCount();
+
+  // ".." items stay on top in their current order
+  VECFILEITEMS sorted;
+  sorted.reserve(m_items.size());
+  for (unsigned int i = 0; i < m_items.size(); i++)
+  {
+    if (m_items[i] && m_items[i]->IsParentFolder())
+      sorted.push_back(m_items[i]);
+  }
+
+  // build all keys into one buffer, once per item, so comparisons are plain memcmp()s
+  std::string keys;
+  std::vector<unsigned int> offsets;
+  std::vector<SSortKeyEntry> entries;
+  offsets.reserve(m_items.size());
+  entries.reserve(m_items.size());
+  for (unsigned int i = 0; i < m_items.size(); i++)
+  {
+    const CFileItemPtr &item = m_items[i];
+    if (!item || item->IsParentFolder())
+      continue;
+
+    SSortKeyEntry entry;
+    entry.group = (ignoreFolders || item->m_bIsFolder) ? 0 : 1;
+    entry.index = i;
+    offsets.push_back(keys.size());
+    SSortFileItem::AppendSortKey(item->GetSortLabel(), keys);
+    entry.length = keys.size() - offsets.back();
+    entries.push_back(entry);
+  }
+  for (unsigned int i = 0; i < entries.size(); i++)
+    entries[i].key = (const unsigned char*)keys.data() + offsets[i];
+
+  SSortKeyCompare compare(ascending);
+  if (!entries.empty())
+  {
+    SSortKeyEntry* first = &entries[0];
+    SSortKeyEntry* last = first + entries.size();
+    bool parallel = false;
+#ifdef _LINUX
+    parallel = entries.size() >= PARALLEL_SORT_MIN_ITEMS && g_cpuInfo.getCPUCount() > 1;
+#endif
+    if (parallel)
+    {
+      SSortKeyEntry* middle = first + entries.size() / 2;
+      CSortKeyJob job(middle, last, ascending);
+      CThread thread(&job);
+      thread.Create();
+      std::sort(first, middle, compare);
+      thread.WaitForThreadExit(INFINITE);
+      std::inplace_merge(first, middle, last, compare);
+    }
+    else
+      std::sort(first, last, compare);
+  }
+
+  // items without a valid pointer go last, as there is nothing to sort them by
+  for (unsigned int i = 0; i < entries.size(); i++)
+    sorted.push_back(m_items[entries[i].index]);
+  for (unsigned int i = 0; i < m_items.size(); i++)
+  {
+    if (!m_items[i])
+      sorted.push_back(m_items[i]);
+  }
+  m_items.swap(sorted);
+
+  DWORD dwElapsed = GetTickCount() - dwStart;
+  CLog::Log(LOGDEBUG,"%s, sorting %u items took %u millis", __FUNCTION__, (unsigned int)m_items.size(), dwElapsed);
+}
+
 void CFileItemList::FillSortFields(FILEITEMFILLFUNC func)
 {
   CSingleLock lock(m_lock);
@@ -1604,9 +1733,9 @@ void CFileItemList::Sort(SORT_METHOD sortMethod, SORT_ORDER sortOrder)
     break;
   }
   if (sortMethod == SORT_METHOD_FILE)
-    Sort(sortOrder==SORT_ORDER_ASC ? SSortFileItem::IgnoreFoldersAscending : SSortFileItem::IgnoreFoldersDescending);
+    SortBySortLabel(true, sortOrder==SORT_ORDER_ASC);
   else if (sortMethod != SORT_METHOD_NONE)
-    Sort(sortOrder==SORT_ORDER_ASC ? SSortFileItem::Ascending : SSortFileItem::Descending);
+    SortBySortLabel(false, sortOrder==SORT_ORDER_ASC);
 
   m_sortMethod=sortMethod;
   m_sortOrder=sortOrder;
@@ -2176,9 +2305,28 @@ void CFileItemList::Stack()
 
 bool CFileItemList::Load()
 {
+  DWORD dwStart = timeGetTime();
+  if (CFileItemDiscCache::Load(GetDiscCacheFile(), *this))
+  {
+    CLog::Log(LOGDEBUG,"Loaded fileitems [%s] in %u ms",m_strPath.c_str(), (unsigned int)(timeGetTime() - dwStart));
+    CLog::Log(LOGDEBUG,"  -- items: %i, directory: %s sort method: %i, ascending: %s",Size(),m_strPath.c_str(), m_sortMethod, m_sortOrder ? "true" : "false");
+    return true;
+  }
+
+  // caches written before the binary format went through CArchive directly
   CFile file;
   if (file.Open(GetDiscCacheFile()))
   {
+    char magic[4];
+    if (file.Read(magic, sizeof(magic)) == sizeof(magic) && memcmp(magic, FILEITEMCACHE_MAGIC, sizeof(magic)) == 0)
+    {
+      // ours, but a different version or damaged
+      file.Close();
+      RemoveDiscCache();
+      return false;
+    }
+    file.Seek(0, SEEK_SET);
+
     CLog::Log(LOGDEBUG,"Loading fileitems [%s]",m_strPath.c_str());
     CArchive ar(&file, CArchive::load);
     ar >> *this;
@@ -2199,14 +2347,9 @@ bool CFileItemList::Save()
 
   CLog::Log(LOGDEBUG,"Saving fileitems [%s]",m_strPath.c_str());
 
-  CFile file;
-  if (file.OpenForWrite(GetDiscCacheFile(), true, true)) // overwrite always
+  if (CFileItemDiscCache::Save(GetDiscCacheFile(), *this))
   {
-    CArchive ar(&file, CArchive::store);
-    ar << *this;
     CLog::Log(LOGDEBUG,"  -- items: %i, sort method: %i, ascending: %s",iSize,m_sortMethod, m_sortOrder ? "true" : "false");
-    ar.Close();
-    file.Close();
     return true;
   }
 
@@ -235,6 +235,8 @@ public:
   const CStdString& GetQuickFanart() const { return m_strFanartUrl; }
   
 private:
+  friend class CFileItemDiscCache;
+
   // Gets the .tbn file associated with this item
   CStdString GetTBNFile() const;
   // Gets the previously cached thumb file (with existence checks)
@@ -405,7 +407,10 @@ public:
   
   void ClearSortState();
 private:
+  friend class CFileItemDiscCache;
+
   void Sort(FILEITEMLISTCOMPARISONFUNC func);
+  void SortBySortLabel(bool ignoreFolders, bool ascending);
   void FillSortFields(FILEITEMFILLFUNC func);
   CStdString GetDiscCacheFile() const;
 
@@ -0,0 +1,518 @@
+/*
+ *      Copyright (C) 2005-2008 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "stdafx.h"
+#include "FileItemDiscCache.h"
+#include "FileItem.h"
+#include "FileSystem/File.h"
+#include "utils/Archive.h"
+#include "MusicInfoTag.h"
+#include "VideoInfoTag.h"
+#include "PictureInfoTag.h"
+
+#include <map>
+
+using namespace std;
+using namespace XFILE;
+
+// record flags
+#define FIC_FOLDER          0x0001
+#define FIC_SELECTED        0x0002
+#define FIC_PARENT_FOLDER   0x0004
+#define FIC_PREFORMATED     0x0008
+#define FIC_SHARE_OR_DRIVE  0x0010
+#define FIC_CAN_QUEUE       0x0020
+#define FIC_DATE_VALID      0x0040
+#define FIC_MUSIC_TAG       0x0100
+#define FIC_VIDEO_TAG       0x0200
+#define FIC_PICTURE_TAG     0x0400
+
+// indices into SRecord::strings
+enum
+{
+  FIC_STR_LABEL = 0,
+  FIC_STR_LABEL2,
+  FIC_STR_SORTLABEL,
+  FIC_STR_THUMB,
+  FIC_STR_ICON,
+  FIC_STR_PATH,
+  FIC_STR_DVDLABEL,
+  FIC_STR_TITLE,
+  FIC_STR_LOCKCODE,
+  FIC_STR_FANART,
+  FIC_STR_CONTENTTYPE,
+  FIC_STR_EXTRAINFO,
+  FIC_STR_COUNT
+};
+
+// all fields are naturally aligned, so the layout is the same for every compiler we build with
+struct CFileItemDiscCache::SHeader
+{
+  char         magic[4];
+  unsigned int version;
+  unsigned int headerSize;
+  unsigned int recordSize;
+  unsigned int itemCount;          // records following the list record
+  unsigned int sortDetailsOffset;
+  unsigned int sortDetailsCount;
+  unsigned int propertiesOffset;
+  unsigned int propertiesCount;    // key/value pairs
+  unsigned int stringsOffset;
+  unsigned int stringsSize;
+  unsigned int tagsOffset;
+  int          sortMethod;
+  int          sortOrder;
+  int          cacheToDisc;
+  unsigned int fastLookup;
+  unsigned int content;
+  unsigned int firstTitle;
+  unsigned int secondTitle;
+};
+
+struct CFileItemDiscCache::SRecord
+{
+  __int64      size;
+  unsigned int flags;
+  unsigned int strings[FIC_STR_COUNT];
+  int          overlayIcon;
+  int          driveType;
+  int          programCount;
+  int          depth;
+  int          startOffset;
+  int          endOffset;
+  int          lockMode;
+  int          badPwdCount;
+  unsigned int dateLow;
+  unsigned int dateHigh;
+  unsigned int firstProperty;
+  unsigned int propertyCount;
+  unsigned int reserved;
+};
+
+struct SSortDetailsRecord
+{
+  int          sortMethod;
+  int          buttonLabel;
+  unsigned int labelFile;
+  unsigned int labelFolder;
+  unsigned int label2File;
+  unsigned int label2Folder;
+};
+
+// each string is stored once as its length followed by the characters. offset 0 is the empty string.
+class CFileItemDiscCache::CStringTable
+{
+public:
+  CStringTable()
+  {
+    Add("");
+  }
+
+  unsigned int Add(const CStdString& str)
+  {
+    map<CStdString, unsigned int>::const_iterator it = m_offsets.find(str);
+    if (it != m_offsets.end())
+      return it->second;
+
+    unsigned int iOffset = m_data.size();
+    unsigned int iLength = str.size();
+    m_data.append((const char*)&iLength, sizeof(iLength));
+    m_data.append(str.c_str(), iLength);
+    m_offsets.insert(make_pair(str, iOffset));
+    return iOffset;
+  }
+
+  const string& GetData() const { return m_data; }
+
+private:
+  map<CStdString, unsigned int> m_offsets;
+  string m_data;
+};
+
+void CFileItemDiscCache::WriteRecord(const CFileItem& item, SRecord& record, CStringTable& strings,
+                                     vector<unsigned int>& properties)
+{
+  memset(&record, 0, sizeof(record));
+
+  if (item.m_bIsFolder)         record.flags |= FIC_FOLDER;
+  if (item.IsSelected())        record.flags |= FIC_SELECTED;
+  if (item.m_bIsParentFolder)   record.flags |= FIC_PARENT_FOLDER;
+  if (item.m_bLabelPreformated) record.flags |= FIC_PREFORMATED;
+  if (item.m_bIsShareOrDrive)   record.flags |= FIC_SHARE_OR_DRIVE;
+  if (item.m_bCanQueue)         record.flags |= FIC_CAN_QUEUE;
+  if (item.m_dateTime.IsValid()) record.flags |= FIC_DATE_VALID;
+  if (item.m_musicInfoTag)      record.flags |= FIC_MUSIC_TAG;
+  if (item.m_videoInfoTag)      record.flags |= FIC_VIDEO_TAG;
+  if (item.m_pictureInfoTag)    record.flags |= FIC_PICTURE_TAG;
+
+  record.strings[FIC_STR_LABEL]       = strings.Add(item.GetLabel());
+  record.strings[FIC_STR_LABEL2]      = strings.Add(item.GetLabel2());
+  record.strings[FIC_STR_SORTLABEL]   = strings.Add(item.GetSortLabel());
+  record.strings[FIC_STR_THUMB]       = strings.Add(item.GetThumbnailImage());
+  record.strings[FIC_STR_ICON]        = strings.Add(item.GetIconImage());
+  record.strings[FIC_STR_PATH]        = strings.Add(item.m_strPath);
+  record.strings[FIC_STR_DVDLABEL]    = strings.Add(item.m_strDVDLabel);
+  record.strings[FIC_STR_TITLE]       = strings.Add(item.m_strTitle);
+  record.strings[FIC_STR_LOCKCODE]    = strings.Add(item.m_strLockCode);
+  record.strings[FIC_STR_FANART]      = strings.Add(item.m_strFanartUrl);
+  record.strings[FIC_STR_CONTENTTYPE] = strings.Add(item.m_contenttype);
+  record.strings[FIC_STR_EXTRAINFO]   = strings.Add(item.m_extrainfo);
+
+  record.size         = item.m_dwSize;
+  record.overlayIcon  = (int)item.m_overlayIcon;
+  record.driveType    = item.m_iDriveType;
+  record.programCount = item.m_iprogramCount;
+  record.depth        = item.m_idepth;
+  record.startOffset  = (int)item.m_lStartOffset;
+  record.endOffset    = (int)item.m_lEndOffset;
+  record.lockMode     = (int)item.m_iLockMode;
+  record.badPwdCount  = item.m_iBadPwdCount;
+
+  if (item.m_dateTime.IsValid())
+  {
+    FILETIME time = item.m_dateTime;
+    record.dateLow  = time.dwLowDateTime;
+    record.dateHigh = time.dwHighDateTime;
+  }
+
+  record.firstProperty = properties.size() / 2;
+  for (map<CStdString, CStdString, CGUIListItem::icompare>::const_iterator it = item.m_mapProperties.begin(); it != item.m_mapProperties.end(); ++it)
+  {
+    properties.push_back(strings.Add(it->first));
+    properties.push_back(strings.Add(it->second));
+  }
+  record.propertyCount = properties.size() / 2 - record.firstProperty;
+}
+
+bool CFileItemDiscCache::GetString(const BYTE* pData, const SHeader& header, unsigned int iOffset, CStdString& str)
+{
+  if (iOffset > header.stringsSize - sizeof(unsigned int))
+    return false;
+
+  const BYTE* pString = pData + header.stringsOffset + iOffset;
+  unsigned int iLength;
+  memcpy(&iLength, pString, sizeof(iLength));
+  if (iLength > header.stringsSize - iOffset - sizeof(unsigned int))
+    return false;
+
+  str.assign((const char*)pString + sizeof(unsigned int), iLength);
+  return true;
+}
+
+bool CFileItemDiscCache::ReadRecord(CFileItem& item, const SRecord& record, const BYTE* pData, const SHeader& header)
+{
+  CStdString strings[FIC_STR_COUNT];
+  for (int i = 0; i < FIC_STR_COUNT; i++)
+  {
+    if (!GetString(pData, header, record.strings[i], strings[i]))
+      return false;
+  }
+
+  item.m_bIsFolder = (record.flags & FIC_FOLDER) != 0;
+  item.Select((record.flags & FIC_SELECTED) != 0);
+  item.CGUIListItem::SetLabel(strings[FIC_STR_LABEL]);
+  item.SetSortLabel(strings[FIC_STR_SORTLABEL]); // after SetLabel(), which fills in an empty sort label
+  item.SetLabel2(strings[FIC_STR_LABEL2]);
+  item.SetThumbnailImage(strings[FIC_STR_THUMB]);
+  item.SetIconImage(strings[FIC_STR_ICON]);
+  item.m_overlayIcon = (CGUIListItem::GUIIconOverlay)record.overlayIcon;
+
+  if (record.propertyCount > header.propertiesCount || record.firstProperty > header.propertiesCount - record.propertyCount)
+    return false;
+
+  const unsigned int* pProperties = (const unsigned int*)(pData + header.propertiesOffset) + record.firstProperty * 2;
+  for (unsigned int i = 0; i < record.propertyCount; i++)
+  {
+    CStdString key, value;
+    if (!GetString(pData, header, pProperties[i * 2], key) || !GetString(pData, header, pProperties[i * 2 + 1], value))
+      return false;
+    item.SetProperty(key, value);
+  }
+
+  item.m_bIsParentFolder   = (record.flags & FIC_PARENT_FOLDER) != 0;
+  item.m_bLabelPreformated = (record.flags & FIC_PREFORMATED) != 0;
+  item.m_bIsShareOrDrive   = (record.flags & FIC_SHARE_OR_DRIVE) != 0;
+  item.m_bCanQueue         = (record.flags & FIC_CAN_QUEUE) != 0;
+  item.m_strPath      = strings[FIC_STR_PATH];
+  item.m_strDVDLabel  = strings[FIC_STR_DVDLABEL];
+  item.m_strTitle     = strings[FIC_STR_TITLE];
+  item.m_strLockCode  = strings[FIC_STR_LOCKCODE];
+  item.m_strFanartUrl = strings[FIC_STR_FANART];
+  item.m_contenttype  = strings[FIC_STR_CONTENTTYPE];
+  item.m_extrainfo    = strings[FIC_STR_EXTRAINFO];
+
+  item.m_dwSize        = record.size;
+  item.m_iDriveType    = record.driveType;
+  item.m_iprogramCount = record.programCount;
+  item.m_idepth        = record.depth;
+  item.m_lStartOffset  = record.startOffset;
+  item.m_lEndOffset    = record.endOffset;
+  item.m_iLockMode     = (LockType)record.lockMode;
+  item.m_iBadPwdCount  = record.badPwdCount;
+
+  if (record.flags & FIC_DATE_VALID)
+  {
+    FILETIME time;
+    time.dwLowDateTime  = record.dateLow;
+    time.dwHighDateTime = record.dateHigh;
+    item.m_dateTime = time;
+  }
+  else
+    item.m_dateTime.Reset();
+
+  item.SetInvalid();
+  return true;
+}
+
+bool CFileItemDiscCache::IsValid(const BYTE* pData, unsigned int iSize)
+{
+  if (iSize < sizeof(SHeader))
+    return false;
+
+  SHeader header;
+  memcpy(&header, pData, sizeof(header));
+  if (memcmp(header.magic, FILEITEMCACHE_MAGIC, 4) != 0 || header.version != FILEITEMCACHE_VERSION)
+    return false;
+
+  if (header.headerSize != sizeof(SHeader) || header.recordSize != sizeof(SRecord))
+    return false;
+
+  // every section has to lie within the file, in order
+  if (header.sortDetailsOffset > iSize || header.propertiesOffset > iSize || header.stringsOffset > iSize)
+    return false;
+  unsigned int iRecordsEnd = sizeof(SHeader) + (header.itemCount + 1) * sizeof(SRecord);
+  if (header.itemCount > iSize / sizeof(SRecord) || iRecordsEnd > header.sortDetailsOffset)
+    return false;
+  if (header.sortDetailsCount > iSize / sizeof(SSortDetailsRecord)
+   || header.sortDetailsOffset + header.sortDetailsCount * sizeof(SSortDetailsRecord) > header.propertiesOffset)
+    return false;
+  if (header.propertiesCount > iSize / (2 * sizeof(unsigned int))
+   || header.propertiesOffset + header.propertiesCount * 2 * sizeof(unsigned int) > header.stringsOffset)
+    return false;
+  if (header.stringsSize < sizeof(unsigned int) || header.stringsSize > iSize
+   || header.stringsOffset + header.stringsSize > header.tagsOffset || header.tagsOffset > iSize)
+    return false;
+
+  return true;
+}
+
+bool CFileItemDiscCache::Save(const CStdString& strFile, CFileItemList& items)
+{
+  CSingleLock lock(items.m_lock);
+
+  int iFirst = 0;
+  if (items.m_items.size() > 0 && items.m_items[0]->IsParentFolder())
+    iFirst = 1;
+
+  unsigned int iCount = items.m_items.size() - iFirst;
+
+  SHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, FILEITEMCACHE_MAGIC, 4);
+  header.version     = FILEITEMCACHE_VERSION;
+  header.headerSize  = sizeof(SHeader);
+  header.recordSize  = sizeof(SRecord);
+  header.itemCount   = iCount;
+  header.sortMethod  = (int)items.m_sortMethod;
+  header.sortOrder   = (int)items.m_sortOrder;
+  header.cacheToDisc = (int)items.m_cacheToDisc;
+  header.fastLookup  = items.m_fastLookup ? 1 : 0;
+
+  CStringTable strings;
+  vector<unsigned int> properties;
+  vector<SRecord> records(iCount + 1);
+
+  WriteRecord(items, records[0], strings, properties);
+  for (unsigned int i = 0; i < iCount; i++)
+    WriteRecord(*items.m_items[i + iFirst], records[i + 1], strings, properties);
+
+  vector<SSortDetailsRecord> sortDetails(items.m_sortDetails.size());
+  for (unsigned int i = 0; i < items.m_sortDetails.size(); i++)
+  {
+    const SORT_METHOD_DETAILS &details = items.m_sortDetails[i];
+    sortDetails[i].sortMethod   = (int)details.m_sortMethod;
+    sortDetails[i].buttonLabel  = details.m_buttonLabel;
+    sortDetails[i].labelFile    = strings.Add(details.m_labelMasks.m_strLabelFile);
+    sortDetails[i].labelFolder  = strings.Add(details.m_labelMasks.m_strLabelFolder);
+    sortDetails[i].label2File   = strings.Add(details.m_labelMasks.m_strLabel2File);
+    sortDetails[i].label2Folder = strings.Add(details.m_labelMasks.m_strLabel2Folder);
+  }
+
+  header.content     = strings.Add(items.m_content);
+  header.firstTitle  = strings.Add(items.m_firstTitle);
+  header.secondTitle = strings.Add(items.m_secondTitle);
+
+  header.sortDetailsOffset = sizeof(SHeader) + records.size() * sizeof(SRecord);
+  header.sortDetailsCount  = sortDetails.size();
+  header.propertiesOffset  = header.sortDetailsOffset + sortDetails.size() * sizeof(SSortDetailsRecord);
+  header.propertiesCount   = properties.size() / 2;
+  header.stringsOffset     = header.propertiesOffset + properties.size() * sizeof(unsigned int);
+  header.stringsSize       = strings.GetData().size();
+  header.tagsOffset        = header.stringsOffset + header.stringsSize;
+
+  // written to a temporary file first, so a partially written cache is never picked up
+  CStdString strTemp = strFile + ".tmp";
+  CFile file;
+  if (!file.OpenForWrite(strTemp, true, true))
+    return false;
+
+  file.Write(&header, sizeof(header));
+  file.Write(&records[0], records.size() * sizeof(SRecord));
+  if (sortDetails.size())
+    file.Write(&sortDetails[0], sortDetails.size() * sizeof(SSortDetailsRecord));
+  if (properties.size())
+    file.Write(&properties[0], properties.size() * sizeof(unsigned int));
+  file.Write(strings.GetData().c_str(), strings.GetData().size());
+
+  // the info tags follow in record order, serialised the same way as before
+  {
+    CArchive ar(&file, CArchive::store);
+    for (unsigned int i = 0; i <= iCount; i++)
+    {
+      CFileItem* pItem = i ? items.m_items[i - 1 + iFirst].get() : &items;
+      if (pItem->m_musicInfoTag)
+        ar << *pItem->m_musicInfoTag;
+      if (pItem->m_videoInfoTag)
+        ar << *pItem->m_videoInfoTag;
+      if (pItem->m_pictureInfoTag)
+        ar << *pItem->m_pictureInfoTag;
+    }
+    ar.Close();
+  }
+
+  file.Close();
+
+  CFile::Delete(strFile);
+  return CFile::Rename(strTemp, strFile);
+}
+
+bool CFileItemDiscCache::Load(const CStdString& strFile, CFileItemList& items)
+{
+  CFile file;
+  if (!file.Open(strFile))
+    return false;
+
+  __int64 iLength = file.GetLength();
+  if (iLength < (__int64)sizeof(SHeader) || iLength > 0x7fffffff)
+    return false;
+
+  // one read for the whole cache, everything after this is memory only
+  unsigned int iSize = (unsigned int)iLength;
+  BYTE* pData = new BYTE[iSize];
+  if (!pData)
+    return false;
+
+  bool bResult = file.Read(pData, iSize) == iSize && IsValid(pData, iSize);
+  file.Close();
+  if (!bResult)
+  {
+    delete [] pData;
+    return false;
+  }
+
+  SHeader header;
+  memcpy(&header, pData, sizeof(header));
+
+  CSingleLock lock(items.m_lock);
+
+  // keep the parent folder item, as CFileItemList::Serialize() does
+  CFileItemPtr pParent;
+  if (!items.IsEmpty() && items.m_items[0]->IsParentFolder())
+    pParent.reset(new CFileItem(*items.m_items[0]));
+
+  items.SetFastLookup(false);
+  items.Clear();
+
+  vector<CFileItemPtr> loaded;
+  loaded.reserve(header.itemCount);
+
+  const SRecord* pRecords = (const SRecord*)(pData + sizeof(SHeader));
+  bResult = ReadRecord(items, pRecords[0], pData, header);
+  for (unsigned int i = 1; bResult && i <= header.itemCount; i++)
+  {
+    CFileItemPtr pItem(new CFileItem);
+    bResult = ReadRecord(*pItem, pRecords[i], pData, header);
+    loaded.push_back(pItem);
+  }
+
+  if (bResult)
+  {
+    CArchive ar(pData + header.tagsOffset, iSize - header.tagsOffset);
+    for (unsigned int i = 0; i <= header.itemCount; i++)
+    {
+      CFileItem* pItem = i ? loaded[i - 1].get() : &items;
+      unsigned int flags = pRecords[i].flags;
+      if (flags & FIC_MUSIC_TAG)
+        ar >> *pItem->GetMusicInfoTag();
+      if (flags & FIC_VIDEO_TAG)
+        ar >> *pItem->GetVideoInfoTag();
+      if (flags & FIC_PICTURE_TAG)
+        ar >> *pItem->GetPictureInfoTag();
+    }
+
+    const SSortDetailsRecord* pSortDetails = (const SSortDetailsRecord*)(pData + header.sortDetailsOffset);
+    for (unsigned int i = 0; bResult && i < header.sortDetailsCount; i++)
+    {
+      SORT_METHOD_DETAILS details;
+      details.m_sortMethod  = (SORT_METHOD)pSortDetails[i].sortMethod;
+      details.m_buttonLabel = pSortDetails[i].buttonLabel;
+      bResult = GetString(pData, header, pSortDetails[i].labelFile, details.m_labelMasks.m_strLabelFile)
+             && GetString(pData, header, pSortDetails[i].labelFolder, details.m_labelMasks.m_strLabelFolder)
+             && GetString(pData, header, pSortDetails[i].label2File, details.m_labelMasks.m_strLabel2File)
+             && GetString(pData, header, pSortDetails[i].label2Folder, details.m_labelMasks.m_strLabel2Folder);
+      items.m_sortDetails.push_back(details);
+    }
+
+    bResult = bResult
+           && GetString(pData, header, header.content, items.m_content)
+           && GetString(pData, header, header.firstTitle, items.m_firstTitle)
+           && GetString(pData, header, header.secondTitle, items.m_secondTitle);
+  }
+
+  delete [] pData;
+
+  if (!bResult)
+  {
+    CLog::Log(LOGERROR, "%s - corrupt cache %s", __FUNCTION__, strFile.c_str());
+    items.Clear();
+    if (pParent)
+      items.Add(pParent);
+    return false;
+  }
+
+  items.m_sortMethod  = (SORT_METHOD)header.sortMethod;
+  items.m_sortOrder   = (SORT_ORDER)header.sortOrder;
+  items.m_cacheToDisc = (CFileItemList::CACHE_TYPE)header.cacheToDisc;
+
+  if (pParent)
+  {
+    items.m_items.reserve(loaded.size() + 1);
+    items.m_items.push_back(pParent);
+  }
+  else
+    items.m_items.reserve(loaded.size());
+
+  for (unsigned int i = 0; i < loaded.size(); i++)
+    items.Add(loaded[i]);
+
+  items.SetFastLookup(header.fastLookup != 0);
+  return true;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2005-2008 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "StdString.h"
+#include <vector>
+
+class CFileItem;
+class CFileItemList;
+
+/*
+ * Binary on disk format of the CFileItemList disc caches (the .fi files on Z:).
+ *
+ *   header | records | sort details | properties | string table | info tags
+ *
+ * Every item, with the list itself as record 0, is a fixed size record. All
+ * strings live once in the string table and are referenced by offset, so a
+ * load is one read of the file followed by plain memory copies. Music, video
+ * and picture tags are too varied for a fixed record, they follow as a CArchive
+ * stream in record order and are decoded from the same buffer.
+ */
+#define FILEITEMCACHE_MAGIC     "XFIC"
+#define FILEITEMCACHE_VERSION   1
+
+class CFileItemDiscCache
+{
+public:
+  static bool Save(const CStdString& strFile, CFileItemList& items);
+
+  /*
+   * returns false if the file is missing or not in this format (older caches
+   * were written straight through CArchive), the caller should then fall back
+   */
+  static bool Load(const CStdString& strFile, CFileItemList& items);
+
+  // true if the buffer starts with a header of the current version
+  static bool IsValid(const BYTE* pData, unsigned int iSize);
+
+private:
+  class CStringTable;
+  struct SHeader;
+  struct SRecord;
+
+  static void WriteRecord(const CFileItem& item, SRecord& record, CStringTable& strings,
+                          std::vector<unsigned int>& properties);
+  static bool ReadRecord(CFileItem& item, const SRecord& record, const BYTE* pData, const SHeader& header);
+  static bool GetString(const BYTE* pData, const SHeader& header, unsigned int iOffset, CStdString& str);
+};
@@ -28,19 +28,18 @@
 
 #include <math.h>
 
-#define CACHE_BUFFER_SIZE (1048576 * 5)
+#define CACHE_BUFFER_SIZE  (1048576 * 8)
+#define CACHE_HISTORY_SIZE (1048576 * 4)
 
 using namespace XFILE;
 
-#define SEEK_CHECK_RET(x) if (!(x)) return -1;
-
 CacheMemBuffer::CacheMemBuffer()
  : CCacheStrategy()
 {
   m_nStartPosition = 0;
-  m_buffer.Create(CACHE_BUFFER_SIZE + 1);
-  m_HistoryBuffer.Create(CACHE_BUFFER_SIZE + 1);
-  m_forwardBuffer.Create(CACHE_BUFFER_SIZE + 1);
+  m_buffer.Create(CACHE_BUFFER_SIZE);
+  m_HistoryBuffer.Create(CACHE_HISTORY_SIZE);
+  m_forwardBuffer.Create(CACHE_HISTORY_SIZE);
 }
 
 
@@ -70,56 +69,77 @@ int CacheMemBuffer::Close()
 
 int CacheMemBuffer::WriteToCache(const char *pBuffer, size_t iSize) 
 {
+  // the lock is only contended while the reader rearranges the buffer after a seek
   CSingleLock lock(m_sync);
-  unsigned int nToWrite = m_buffer.GetMaxWriteSize() ;
 
   // must also check the forward buffer.
   // if we have leftovers from the previous seek - we need not read anymore until they are utilized
-  if (nToWrite == 0 || m_forwardBuffer.GetMaxReadSize() > 0)
+  if (m_forwardBuffer.GetMaxReadSize() > 0)
     return 0;
 
+  unsigned int nToWrite = m_buffer.GetMaxWriteSize();
   if (nToWrite > iSize) 
     nToWrite = iSize;
- 
-  if (!m_buffer.WriteBinary(pBuffer, nToWrite))
+
+  unsigned int nWritten = 0;
+  while (nWritten < nToWrite)
   {
-    CLog::Log(LOGWARNING,"%s, failed to write %d bytes to buffer. max buffer size: %d", __FUNCTION__, nToWrite, m_buffer.GetMaxWriteSize());
-    nToWrite = 0;
+    unsigned int iContiguous;
+    char *pDest = m_buffer.GetWriteBuffer(iContiguous);
+    if (iContiguous > nToWrite - nWritten)
+      iContiguous = nToWrite - nWritten;
+
+    memcpy(pDest, pBuffer + nWritten, iContiguous);
+    m_buffer.CommitWrite(iContiguous);
+    nWritten += iContiguous;
   }
 
-  return nToWrite;
+  return nWritten;
 }
 
 int CacheMemBuffer::ReadFromCache(char *pBuffer, size_t iMaxSize) 
 {
-  CSingleLock lock(m_sync);
-  if ( m_buffer.GetMaxReadSize() == 0 ) {
+  unsigned int nAvail = m_buffer.GetMaxReadSize();
+  if (nAvail == 0)
     return m_bEndOfInput?CACHE_RC_EOF : CACHE_RC_WOULD_BLOCK;
-  }
 
-  int nRead = iMaxSize;
-  if ((size_t) m_buffer.GetMaxReadSize() < iMaxSize)
-    nRead = m_buffer.GetMaxReadSize();
+  unsigned int nRead = nAvail;
+  if (iMaxSize < nRead)
+    nRead = iMaxSize;
 
-  if (nRead > 0)
+  // copy straight out of the ring, and to history so we can seek back
+  unsigned int nDone = 0;
+  while (nDone < nRead)
   {
-    if (!m_buffer.ReadBinary(pBuffer, nRead))
+    unsigned int iContiguous;
+    const char *pSrc = m_buffer.GetReadBuffer(iContiguous);
+    if (iContiguous > nRead - nDone)
+      iContiguous = nRead - nDone;
+
+    memcpy(pBuffer + nDone, pSrc, iContiguous);
+
+    // history only keeps the newest bytes
+    const char *pHistory = pSrc;
+    unsigned int nHistory = iContiguous;
+    if (nHistory > m_HistoryBuffer.Size())
     {
-      CLog::Log(LOGWARNING, "%s, failed to read %d bytes from buffer. max read size: %d", __FUNCTION__, nRead, m_buffer.GetMaxReadSize());
-      return 0;
+      pHistory += nHistory - m_HistoryBuffer.Size();
+      nHistory  = m_HistoryBuffer.Size();
     }
+    if (nHistory > m_HistoryBuffer.GetMaxWriteSize())
+      m_HistoryBuffer.SkipBytes(nHistory - m_HistoryBuffer.GetMaxWriteSize());
+    m_HistoryBuffer.WriteBinary(pHistory, nHistory);
 
-    // copy to history so we can seek back
-    if ((int) m_HistoryBuffer.GetMaxWriteSize() < nRead)
-      m_HistoryBuffer.SkipBytes(nRead);
-    m_HistoryBuffer.WriteBinary(pBuffer, nRead);
-
-    m_nStartPosition += nRead;
+    m_buffer.CommitRead(iContiguous);
+    nDone += iContiguous;
   }
 
+  m_nStartPosition += nRead;
+
   // check forward buffer and copy it when enough space is available
   if (m_forwardBuffer.GetMaxReadSize() > 0 && m_buffer.GetMaxWriteSize() >= m_forwardBuffer.GetMaxReadSize())
   {
+    CSingleLock lock(m_sync);
     m_buffer.Append(m_forwardBuffer);
     m_forwardBuffer.Clear();
   }
@@ -133,7 +153,7 @@ __int64 CacheMemBuffer::WaitForData(unsigned int iMinAvail, unsigned int iMillis
     return m_buffer.GetMaxReadSize();
 
   DWORD dwTime = GetTickCount() + iMillis;
-  while (!IsEndOfInput() && (unsigned int) m_buffer.GetMaxReadSize() < iMinAvail && GetTickCount() < dwTime )
+  while (!IsEndOfInput() && m_buffer.GetMaxReadSize() < iMinAvail && GetTickCount() < dwTime )
     Sleep(50); // may miss the deadline. shouldn't be a problem.
 
   return m_buffer.GetMaxReadSize();
@@ -148,26 +168,28 @@ __int64 CacheMemBuffer::Seek(__int64 iFilePosition, int iWhence)
     return CACHE_RC_ERROR;
   }
 
-  CSingleLock lock(m_sync);
-
   // if seek is a bit over what we have, try to wait a few seconds for the data to be available.
   // we try to avoid a (heavy) seek on the source 
   if (iFilePosition > m_nStartPosition + m_buffer.GetMaxReadSize() && 
       iFilePosition < m_nStartPosition + m_buffer.GetMaxReadSize() + 100000)
   {
     int nRequired = (int)(iFilePosition - (m_nStartPosition + m_buffer.GetMaxReadSize()));
-    lock.Leave();
     WaitForData(nRequired + 1, 5000);
-    lock.Enter();
   }
 
-  // check if seek is inside the current buffer
+  // check if seek is inside the current buffer. this only consumes data, so the writer can carry on
   if (iFilePosition >= m_nStartPosition && iFilePosition < m_nStartPosition + m_buffer.GetMaxReadSize())
   {
-    int nOffset = (int)(iFilePosition - m_nStartPosition);
+    unsigned int nOffset = (unsigned int)(iFilePosition - m_nStartPosition);
     // copy to history so we can seek back
-    if (m_HistoryBuffer.GetMaxWriteSize() < nOffset)
-      m_HistoryBuffer.SkipBytes(nOffset);
+    if (nOffset > m_HistoryBuffer.Size())
+    {
+      m_HistoryBuffer.Clear();
+      m_buffer.SkipBytes(nOffset - m_HistoryBuffer.Size());
+      nOffset = m_HistoryBuffer.Size();
+    }
+    else if (m_HistoryBuffer.GetMaxWriteSize() < nOffset)
+      m_HistoryBuffer.SkipBytes(nOffset - m_HistoryBuffer.GetMaxWriteSize());
 
     if (!m_buffer.ReadBinary(m_HistoryBuffer, nOffset))
     {
@@ -179,29 +201,40 @@ __int64 CacheMemBuffer::Seek(__int64 iFilePosition, int iWhence)
   }
 
   __int64 iHistoryStart = m_nStartPosition - m_HistoryBuffer.GetMaxReadSize();
-  if (iFilePosition < m_nStartPosition && iFilePosition > iHistoryStart)
+  if (iFilePosition < m_nStartPosition && iFilePosition >= iHistoryStart)
   {
-    CRingBuffer saveHist, saveUnRead;
-    __int64 nToSkip = iFilePosition - iHistoryStart;
-    SEEK_CHECK_RET(m_HistoryBuffer.ReadBinary(saveHist, (int)nToSkip));
+    // seeking back means putting history in front of the unread data,
+    // the writer has to stay out while we rebuild the buffer
+    CSingleLock lock(m_sync);
 
-    SEEK_CHECK_RET(saveUnRead.Copy(m_buffer));
+    unsigned int nToSkip  = (unsigned int)(iFilePosition - iHistoryStart);
+    unsigned int nHistory = m_HistoryBuffer.GetMaxReadSize() - nToSkip;
+    unsigned int nTotal   = nHistory + m_buffer.GetMaxReadSize() + m_forwardBuffer.GetMaxReadSize();
 
-    SEEK_CHECK_RET(m_buffer.Copy(m_HistoryBuffer));
-    int nSpace = m_buffer.GetMaxWriteSize();
-    int nToCopy = saveUnRead.GetMaxReadSize();
+    // all of it has to fit in buffer + forward buffer, otherwise let the source seek
+    if (nTotal > m_buffer.Size() + m_forwardBuffer.Size())
+      return CACHE_RC_ERROR;
 
-    if (nToCopy < nSpace)
-      nSpace = nToCopy;
+    CSPSCRingBuffer unread;
+    if (!unread.Create(nTotal))
+      return CACHE_RC_ERROR;
 
-    SEEK_CHECK_RET(saveUnRead.ReadBinary(m_buffer, nSpace));
-    nToCopy -= nSpace;
-    if (nToCopy > 0)
-      m_forwardBuffer.Copy(saveUnRead);
+    m_HistoryBuffer.SkipBytes(nToSkip);
+    unread.Append(m_HistoryBuffer);
+    unread.Append(m_buffer);
+    unread.Append(m_forwardBuffer);
 
-    SEEK_CHECK_RET(m_HistoryBuffer.Copy(saveHist));
+    m_buffer.Clear();
+    m_forwardBuffer.Clear();
     m_HistoryBuffer.Clear();
 
+    unsigned int nSpace = m_buffer.GetMaxWriteSize();
+    if (nSpace > nTotal)
+      nSpace = nTotal;
+    unread.ReadBinary(m_buffer, nSpace);
+    if (nTotal > nSpace)
+      unread.ReadBinary(m_forwardBuffer, nTotal - nSpace);
+
     m_nStartPosition = iFilePosition; 
     return m_nStartPosition;
   }
@@ -212,11 +245,10 @@ __int64 CacheMemBuffer::Seek(__int64 iFilePosition, int iWhence)
 
 void CacheMemBuffer::Reset(__int64 iSourcePosition) 
 {
+  // called from the cache thread while the reader waits for the seek to finish
   CSingleLock lock(m_sync);
   m_nStartPosition = iSourcePosition;
   m_buffer.Clear(); 
   m_HistoryBuffer.Clear();
   m_forwardBuffer.Clear();
 }
-
-
@@ -24,7 +24,7 @@
 
 #include "CacheStrategy.h"
 #include "utils/CriticalSection.h"
-#include "RingBuffer.h"
+#include "SPSCRingBuffer.h"
 
 /**
 	@author Team XBMC
@@ -48,11 +48,11 @@ public:
 	virtual void Reset(__int64 iSourcePosition) ;
 
 protected:
-    __int64 m_nStartPosition;
-    CRingBuffer m_buffer;
-    CRingBuffer m_HistoryBuffer;
-    CRingBuffer m_forwardBuffer; // for seek cases, to store data already read
-    CCriticalSection m_sync;
+    volatile __int64 m_nStartPosition;
+    CSPSCRingBuffer m_buffer;        // written by the cache thread, read by the player
+    CSPSCRingBuffer m_HistoryBuffer; // only used by the reader
+    CSPSCRingBuffer m_forwardBuffer; // for seek cases, to store data already read
+    CCriticalSection m_sync;         // held by the writer, and by the reader when it has to rearrange m_buffer
 };
 
 } // namespace XFILE
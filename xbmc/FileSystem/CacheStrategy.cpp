@@ -25,6 +25,12 @@
 #ifdef _LINUX
 #include "PlatformInclude.h"
 #endif
+#if defined(__APPLE__)
+#include <sys/param.h>
+#include <sys/mount.h>
+#elif defined(_LINUX)
+#include <sys/vfs.h>
+#endif
 #include "Util.h"
 #include "utils/log.h"
 #include "utils/SingleLock.h"
@@ -249,4 +255,312 @@ void CSimpleFileCache::EndOfInput()
   SetEvent(m_hDataAvailEvent); 
 }
 
+CSparseFileCache::CSparseFileCache()
+  : m_hCacheFileRead(NULL)
+  , m_hCacheFileWrite(NULL)
+  , m_hDataAvailEvent(NULL)
+  , m_nWritePosition(0)
+  , m_nReadPosition(0) {
+}
+
+CSparseFileCache::~CSparseFileCache() {
+  Close();
+}
+
+bool CSparseFileCache::SupportsSparseFiles(const CStdString& strPath)
+{
+#if defined(__APPLE__)
+  // HFS+ has no holes, ufs/zfs and the rest do
+  struct statfs fsInfo;
+  if (statfs(strPath.c_str(), &fsInfo) != 0)
+    return false;
+  return strcasecmp(fsInfo.f_fstypename, "hfs") != 0 && strcasecmp(fsInfo.f_fstypename, "msdos") != 0;
+#elif defined(_LINUX)
+  // everything but vfat keeps holes
+  struct statfs fsInfo;
+  if (statfs(strPath.c_str(), &fsInfo) != 0)
+    return false;
+  return fsInfo.f_type != 0x4d44; // MSDOS_SUPER_MAGIC
+#elif defined(_WIN32PC)
+  DWORD dwFlags = 0;
+  if (!GetVolumeInformation(strPath.c_str(), NULL, 0, NULL, NULL, &dwFlags, NULL, 0))
+    return false;
+  return (dwFlags & FILE_SUPPORTS_SPARSE_FILES) != 0;
+#else
+  // FATX
+  return false;
+#endif
+}
+
+int CSparseFileCache::Open() {
+  Close();
+
+  m_hDataAvailEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+
+  CStdString fileName = CUtil::GetNextFilename(_P("Z:\\filecache%03d.cache"), 999);
+  if(fileName.empty())
+  {
+    CLog::Log(LOGERROR, "%s - Unable to generate a new filename", __FUNCTION__);
+    Close();
+    return CACHE_RC_ERROR;
+  }
+
+  // the data is written at the offset it has in the source, so the file stays
+  // sparse and only takes the space of what was actually downloaded
+  m_hCacheFileWrite = CreateFile(fileName.c_str()
+            , GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_DELETE
+            , NULL
+            , CREATE_ALWAYS
+            , FILE_ATTRIBUTE_NORMAL
+            , NULL);
+
+  if(m_hCacheFileWrite == INVALID_HANDLE_VALUE)
+  {
+    CLog::Log(LOGERROR, "%s - failed to create file %s with error code %d", __FUNCTION__, fileName.c_str(), GetLastError());
+    m_hCacheFileWrite = NULL;
+    Close();
+    return CACHE_RC_ERROR;
+  }
+
+#ifdef _WIN32PC
+  // ntfs only leaves holes in files flagged as sparse, anything else is zero filled
+  DWORD dwReturned = 0;
+  if (!DeviceIoControl(m_hCacheFileWrite, FSCTL_SET_SPARSE, NULL, 0, NULL, 0, &dwReturned, NULL))
+    CLog::Log(LOGWARNING, "%s - failed to mark %s as sparse, error %d", __FUNCTION__, fileName.c_str(), GetLastError());
+#endif
+
+  m_hCacheFileRead = CreateFile(fileName.c_str()
+            , GENERIC_READ, FILE_SHARE_WRITE
+            , NULL
+            , OPEN_EXISTING
+            , FILE_ATTRIBUTE_NORMAL | FILE_FLAG_DELETE_ON_CLOSE
+            , NULL);
+
+  if(m_hCacheFileRead == INVALID_HANDLE_VALUE)
+  {
+    CLog::Log(LOGERROR, "%s - failed to open file %s with error code %d", __FUNCTION__, fileName.c_str(), GetLastError());
+    m_hCacheFileRead = NULL;
+    Close();
+    return CACHE_RC_ERROR;
+  }
+
+  CSingleLock lock(m_sync);
+  m_ranges.clear();
+  m_nWritePosition = 0;
+  m_nReadPosition = 0;
+
+  return CACHE_RC_OK;
+}
+
+int CSparseFileCache::Close()
+{
+  if (m_hDataAvailEvent)
+    CloseHandle(m_hDataAvailEvent);
+
+  m_hDataAvailEvent = NULL;
+
+  if (m_hCacheFileWrite)
+    CloseHandle(m_hCacheFileWrite);
+
+  m_hCacheFileWrite = NULL;
+
+  if (m_hCacheFileRead)
+    CloseHandle(m_hCacheFileRead);
+
+  m_hCacheFileRead = NULL;
+
+  CSingleLock lock(m_sync);
+  m_ranges.clear();
+
+  return CACHE_RC_OK;
+}
+
+CSparseFileCache::RangeMap::iterator CSparseFileCache::FindRange(__int64 iPosition)
+{
+  RangeMap::iterator it = m_ranges.upper_bound(iPosition);
+  if (it == m_ranges.begin())
+    return m_ranges.end();
+
+  --it;
+  if (iPosition < it->second)
+    return it;
+
+  return m_ranges.end();
+}
+
+void CSparseFileCache::AddRange(__int64 iStart, __int64 iEnd)
+{
+  // merge with the ranges we overlap or touch
+  RangeMap::iterator it = m_ranges.upper_bound(iStart);
+  if (it != m_ranges.begin())
+  {
+    RangeMap::iterator prev = it;
+    --prev;
+    if (prev->second >= iStart)
+    {
+      iStart = prev->first;
+      if (prev->second > iEnd)
+        iEnd = prev->second;
+      m_ranges.erase(prev);
+    }
+  }
+
+  while (it != m_ranges.end() && it->first <= iEnd)
+  {
+    if (it->second > iEnd)
+      iEnd = it->second;
+    m_ranges.erase(it++);
+  }
+
+  m_ranges[iStart] = iEnd;
+}
+
+int CSparseFileCache::WriteToCache(const char *pBuffer, size_t iSize) {
+  DWORD iWritten=0;
+  if (!WriteFile(m_hCacheFileWrite, pBuffer, iSize, &iWritten, NULL)) {
+    CLog::Log(LOGERROR, "%s - failed to write to file. err: %u",
+                        __FUNCTION__, GetLastError());
+    return CACHE_RC_ERROR;
+  }
+
+  {
+    CSingleLock lock(m_sync);
+    AddRange(m_nWritePosition, m_nWritePosition + iWritten);
+    m_nWritePosition += iWritten;
+  }
+
+  // when reader waits for data it will wait on the event.
+  SetEvent(m_hDataAvailEvent);
+  return iWritten;
+}
+
+__int64 CSparseFileCache::GetAvailableRead()
+{
+  CSingleLock lock(m_sync);
+  RangeMap::iterator it = FindRange(m_nReadPosition);
+  if (it == m_ranges.end())
+    return 0;
+  return it->second - m_nReadPosition;
+}
+
+int CSparseFileCache::ReadFromCache(char *pBuffer, size_t iMaxSize)
+{
+  __int64 iAvailable = GetAvailableRead();
+  if ( iAvailable <= 0 ) {
+    // only at eof once we caught up with a writer that reached the end of the source
+    if (m_bEndOfInput && m_nReadPosition >= m_nWritePosition)
+      return CACHE_RC_EOF;
+    return CACHE_RC_WOULD_BLOCK;
+  }
+
+  if (iMaxSize > iAvailable)
+    iMaxSize = (size_t)iAvailable;
+
+  DWORD iRead = 0;
+  if (!ReadFile(m_hCacheFileRead, pBuffer, iMaxSize, &iRead, NULL)) {
+    CLog::Log(LOGERROR,"CSparseFileCache::ReadFromCache - failed to read %d bytes.", iMaxSize);
+    return CACHE_RC_ERROR;
+  }
+  m_nReadPosition += iRead;
+  return iRead;
+}
+
+__int64 CSparseFileCache::WaitForData(unsigned int iMinAvail, unsigned int iMillis)
+{
+  if( iMillis == 0 || IsEndOfInput() )
+    return GetAvailableRead();
+
+  DWORD dwTimeout = GetTickCount() + iMillis;
+  DWORD dwTime;
+  while ( !IsEndOfInput() && (dwTime = GetTickCount()) < dwTimeout )
+  {
+    __int64 iAvail = GetAvailableRead();
+    if (iAvail >= iMinAvail)
+      return iAvail;
+
+    // busy look (sleep max 1 sec each round)
+    DWORD dwRc = WaitForSingleObject(m_hDataAvailEvent, (dwTimeout - dwTime)>1000?1000:(dwTimeout - dwTime) );
+    if (dwRc == WAIT_FAILED || dwRc == WAIT_ABANDONED)
+      return CACHE_RC_ERROR;
+  }
+
+  if( IsEndOfInput() )
+    return GetAvailableRead();
+
+  return CACHE_RC_TIMEOUT;
+}
+
+__int64 CSparseFileCache::Seek(__int64 iFilePosition, int iWhence)
+{
+  if (iWhence != SEEK_SET)
+  {
+    // sanity. we should always get here with SEEK_SET
+    CLog::Log(LOGERROR, "%s, only SEEK_SET supported.", __FUNCTION__);
+    return CACHE_RC_ERROR;
+  }
+
+  // if seek is a bit over what the writer has, give it a few seconds to get there
+  DWORD dwTimeout = GetTickCount() + 5000;
+  while (iFilePosition > m_nWritePosition && iFilePosition - m_nWritePosition < 500000
+      && !IsEndOfInput() && GetTickCount() < dwTimeout)
+    WaitForSingleObject(m_hDataAvailEvent, 100);
+
+  bool bCached;
+  {
+    CSingleLock lock(m_sync);
+    bCached = FindRange(iFilePosition) != m_ranges.end() || iFilePosition == m_nWritePosition;
+  }
+
+  // the reader continues from here either way, if it's not cached the source will be
+  // seeked and the writer is Reset() to this position
+  LARGE_INTEGER pos;
+  pos.QuadPart = iFilePosition;
+  if(!SetFilePointerEx(m_hCacheFileRead, pos, &pos, FILE_BEGIN))
+    return CACHE_RC_ERROR;
+
+  m_nReadPosition = iFilePosition;
+
+  if (!bCached)
+    return CACHE_RC_ERROR;
+
+  CLog::Log(LOGDEBUG,"CSparseFileCache::Seek, serving %"PRId64" from cache", iFilePosition);
+  return iFilePosition;
+}
+
+__int64 CSparseFileCache::GetSourceResumePosition(__int64 iFilePosition)
+{
+  CSingleLock lock(m_sync);
+  RangeMap::iterator it = FindRange(iFilePosition);
+  if (it == m_ranges.end() || it->second == m_nWritePosition)
+    return -1;
+
+  return it->second;
+}
+
+void CSparseFileCache::Reset(__int64 iSourcePosition)
+{
+  // only the writer moves, everything downloaded so far stays valid
+  CSingleLock lock(m_sync);
+
+  LARGE_INTEGER pos;
+  pos.QuadPart = iSourcePosition;
+  SetFilePointerEx(m_hCacheFileWrite, pos, NULL, FILE_BEGIN);
+  m_nWritePosition = iSourcePosition;
+}
+
+void CSparseFileCache::EndOfInput()
+{
+  CCacheStrategy::EndOfInput();
+  SetEvent(m_hDataAvailEvent);
+}
+
+bool CSparseFileCache::GetCachedRanges(std::vector< std::pair<__int64, __int64> >& ranges)
+{
+  CSingleLock lock(m_sync);
+  ranges.clear();
+  for (RangeMap::iterator it = m_ranges.begin(); it != m_ranges.end(); it++)
+    ranges.push_back(std::make_pair(it->first, it->second));
+  return true;
+}
+
 }
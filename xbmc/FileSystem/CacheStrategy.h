@@ -30,6 +30,9 @@
 #endif
 #include "utils/CriticalSection.h"
 
+#include <map>
+#include <vector>
+
 namespace XFILE {
 
 #define CACHE_RC_OK  0
@@ -47,6 +50,11 @@ public:
   virtual ~ICacheInterface() { }
   virtual int GetCacheLevel() { return -1; }
 
+  /**
+   * fills ranges with the [start, end) byte ranges of the source that are
+   * available locally. returns false if the cache can't tell.
+   */
+  virtual bool GetCachedRanges(std::vector< std::pair<__int64, __int64> >& ranges) { return false; }
 };
   
 class CCacheStrategy{
@@ -68,6 +76,12 @@ public:
 	virtual bool IsEndOfInput();
   virtual void ClearEndOfInput();
 
+  /**
+   * after a successful Seek() to iFilePosition, returns where the source should
+   * continue reading so the cached data gets extended, or -1 if it already does.
+   */
+  virtual __int64 GetSourceResumePosition(__int64 iFilePosition) { return -1; }
+
   virtual ICacheInterface* GetInterface() { return NULL; }
 protected:
 	bool	m_bEndOfInput;
@@ -103,6 +117,55 @@ protected:
   volatile __int64 m_nReadPosition;
 };
 
+/**
+ * Keeps everything that was downloaded in a sparse temp file, at the same
+ * offset it has in the source, together with a map of the byte ranges that
+ * are present. Seeks into any downloaded range are served locally instead of
+ * re-opening the source.
+ */
+class CSparseFileCache : public CCacheStrategy, ICacheInterface {
+public:
+  CSparseFileCache();
+  virtual ~CSparseFileCache();
+
+  virtual int Open();
+  virtual int Close();
+
+  virtual int WriteToCache(const char *pBuffer, size_t iSize);
+  virtual int ReadFromCache(char *pBuffer, size_t iMaxSize);
+  virtual __int64 WaitForData(unsigned int iMinAvail, unsigned int iMillis);
+
+  virtual __int64 Seek(__int64 iFilePosition, int iWhence);
+  virtual void Reset(__int64 iSourcePosition);
+  virtual void EndOfInput();
+  virtual __int64 GetSourceResumePosition(__int64 iFilePosition);
+  virtual ICacheInterface* GetInterface() { return (ICacheInterface*)this; }
+
+  virtual bool GetCachedRanges(std::vector< std::pair<__int64, __int64> >& ranges);
+
+  /**
+   * Whether files on the volume holding strPath can have holes. Without that,
+   * writing past the end of the file zero-fills the gap (e.g. HFS+, FAT), so a
+   * forward seek would stall on writing up to the whole length of the source.
+   */
+  static bool SupportsSparseFiles(const CStdString& strPath);
+
+protected:
+  typedef std::map<__int64, __int64> RangeMap; // start -> end (exclusive)
+
+  __int64 GetAvailableRead();
+  RangeMap::iterator FindRange(__int64 iPosition);
+  void AddRange(__int64 iStart, __int64 iEnd);
+
+  HANDLE   m_hCacheFileRead;
+  HANDLE   m_hCacheFileWrite;
+  HANDLE   m_hDataAvailEvent;
+  RangeMap m_ranges;
+  volatile __int64 m_nWritePosition;
+  volatile __int64 m_nReadPosition;
+  CCriticalSection m_sync;
+};
+
 }
 
 #endif
@@ -36,6 +36,9 @@ CDirectoryCache::CDir::CDir(const CStdString &strPath, DIR_CACHE_TYPE cacheType)
   m_cacheType = cacheType;
   m_Items = new CFileItemList;
   m_Items->SetFastLookup(true);
+  m_iSize = 0;
+  m_iSequence = 0;
+  m_dwExpires = 0;
 }
 
 CDirectoryCache::CDir::~CDir()
@@ -43,32 +46,115 @@ CDirectoryCache::CDir::~CDir()
   delete m_Items;
 }
 
+bool CDirectoryCache::CDir::IsExpired(DWORD dwNow) const
+{
+  // signed difference, so the check survives the tick count wrapping
+  return m_dwExpires && (long)(dwNow - m_dwExpires) >= 0;
+}
+
 CDirectoryCache::CDirectoryCache(void)
 {
   m_iThumbCacheRefCount = 0;
   m_iMusicThumbCacheRefCount = 0;
+  m_iCacheSize = 0;
+  m_iSequence = 0;
+  m_iHits = 0;
+  m_iMisses = 0;
+  m_iExpired = 0;
+  m_iEvicted = 0;
 }
 
 CDirectoryCache::~CDirectoryCache(void)
 {
+  for (imapCache i = m_cache.begin(); i != m_cache.end(); ++i)
+    delete i->second;
 }
 
-bool CDirectoryCache::GetDirectory(const CStdString& strPath, CFileItemList &items) const
+CStdString CDirectoryCache::NormalisePath(const CStdString &strPath)
 {
-  CSingleLock lock (m_cs);
-
   CStdString storedPath = _P(strPath);
   CUtil::RemoveSlashAtEnd(storedPath);
+  return storedPath;
+}
 
-  for (civecCache i = m_vecCache.begin(); i != m_vecCache.end(); i++)
+unsigned int CDirectoryCache::EstimateSize(const CFileItemList &items)
+{
+  unsigned int iSize = sizeof(CFileItemList);
+  for (int i = 0; i < items.Size(); i++)
   {
-    const CDir* dir = *i;
-    if (dir->m_strPath == storedPath && dir->m_cacheType == DIR_CACHE_ALWAYS)
+    const CFileItemPtr item = items[i];
+    iSize += sizeof(CFileItem) + item->m_strPath.size() + item->GetLabel().size();
+  }
+  return iSize;
+}
+
+CDirectoryCache::CDir* CDirectoryCache::Find(const CStdString &storedPath) const
+{
+  cimapCache i = m_cache.find(storedPath);
+  if (i == m_cache.end())
+    return NULL;
+  return i->second;
+}
+
+void CDirectoryCache::Touch(CDir* dir) const
+{
+  m_lru.splice(m_lru.begin(), m_lru, dir->m_lru);
+}
+
+void CDirectoryCache::Delete(CDir* dir)
+{
+  m_cache.erase(dir->m_strPath);
+  m_sequence.erase(dir->m_iSequence);
+  m_lru.erase(dir->m_lru);
+  m_iCacheSize -= dir->m_iSize;
+  delete dir;
+}
+
+void CDirectoryCache::Evict()
+{
+  // drop least recently used entries until we're within budget, but never the
+  // most recent one, and never the directories we were asked to keep around
+  unsigned int iMaxSize = (unsigned int)g_advancedSettings.m_dirCacheMaxSize * 1024;
+  std::list<CDir*>::iterator i = m_lru.end();
+  while (m_iCacheSize > iMaxSize && i != m_lru.begin())
+  {
+    --i;
+    if (i == m_lru.begin())
+      break;
+
+    CDir* dir = *i;
+    if (IsCacheDir(dir->m_strPath))
+      continue;
+
+    std::list<CDir*>::iterator next = i;
+    ++next;
+    Delete(dir);
+    m_iEvicted++;
+    i = next;
+  }
+}
+
+bool CDirectoryCache::GetDirectory(const CStdString& strPath, CFileItemList &items) const
+{
+  CSingleLock lock (m_cs);
+
+  CDir* dir = Find(NormalisePath(strPath));
+  if (dir && dir->m_cacheType == DIR_CACHE_ALWAYS)
+  {
+    if (dir->IsExpired(timeGetTime()))
     {
-      items.Assign(*dir->m_Items);
-      return true;
+      // stale listing, the caller refetches and replaces it
+      m_iExpired++;
+      m_iMisses++;
+      return false;
     }
+
+    Touch(dir);
+    items.Assign(*dir->m_Items);
+    m_iHits++;
+    return true;
   }
+  m_iMisses++;
   return false;
 }
 
@@ -92,66 +178,58 @@ void CDirectoryCache::SetDirectory(const CStdString& strPath, const CFileItemLis
 
   ClearDirectory(strPath);
 
-  CStdString storedPath = _P(strPath);
-  CUtil::RemoveSlashAtEnd(storedPath);
+  CStdString storedPath = NormalisePath(strPath);
 
   CDir* dir = new CDir(storedPath, cacheType);
   dir->m_Items->Assign(items);
-  m_vecCache.push_back(dir);
+  dir->m_iSize = EstimateSize(items);
+  dir->m_iSequence = ++m_iSequence;
+  if (cacheType == DIR_CACHE_ALWAYS && g_advancedSettings.m_dirCacheRemoteTTL > 0 && CUtil::IsRemote(storedPath))
+    dir->m_dwExpires = (timeGetTime() + g_advancedSettings.m_dirCacheRemoteTTL * 1000) | 1;
+
+  m_cache[storedPath] = dir;
+  m_sequence[dir->m_iSequence] = dir;
+  dir->m_lru = m_lru.insert(m_lru.begin(), dir);
+  m_iCacheSize += dir->m_iSize;
+
+  Evict();
 }
 
 void CDirectoryCache::ClearDirectory(const CStdString& strPath)
 {
   CSingleLock lock (m_cs);
 
-  CStdString storedPath = _P(strPath);
-  CUtil::RemoveSlashAtEnd(storedPath);
-
-  for (ivecCache i = m_vecCache.begin(); i != m_vecCache.end(); i++)
-  {
-    CDir* dir = *i;
-    if (dir->m_strPath == storedPath)
-    {
-      delete dir;
-      m_vecCache.erase(i);
-      return;
-    }
-  }
+  CDir* dir = Find(NormalisePath(strPath));
+  if (dir)
+    Delete(dir);
 }
 
 void CDirectoryCache::ClearSubPaths(const CStdString& strPath)
 {
   CSingleLock lock (m_cs);
 
-  CStdString storedPath = _P(strPath);
-  CUtil::RemoveSlashAtEnd(storedPath);
+  CStdString storedPath = NormalisePath(strPath);
 
-  ivecCache i = m_vecCache.begin();
-  for (bool found=false; i != m_vecCache.end(); )
+  // everything cached after this path was (re)fetched goes
+  CDir* dir = Find(storedPath);
+  if (dir)
   {
-    CDir* dir = *i;
-    printf("Comparing %s to %s (%d characters)\n", 
-        dir->m_strPath.c_str(), 
-        storedPath.c_str(), storedPath.GetLength());
-    
-    if (found)
-    {
-      delete dir;
-      i = m_vecCache.erase(i);
-    }
-    else if (strncmp(dir->m_strPath.c_str(), storedPath.c_str(), storedPath.GetLength()) == 0 &&
-             dir->m_strPath.size() > storedPath.size())
-    {
-      delete dir;
-      i = m_vecCache.erase(i);
-    }
-    else
+    std::map<unsigned int, CDir*>::iterator i = m_sequence.upper_bound(dir->m_iSequence);
+    while (i != m_sequence.end())
     {
-      i++;
+      CDir* later = i->second;
+      ++i;
+      Delete(later);
     }
-    
-    if (storedPath == dir->m_strPath)
-      found = true;
+  }
+
+  // as does everything below it. the map is ordered, so they follow the path itself
+  imapCache i = m_cache.upper_bound(storedPath);
+  while (i != m_cache.end() && strncmp(i->first.c_str(), storedPath.c_str(), storedPath.GetLength()) == 0)
+  {
+    CDir* sub = i->second;
+    ++i;
+    Delete(sub);
   }
 }
 
@@ -168,16 +246,15 @@ bool CDirectoryCache::FileExists(const CStdString& strFile, bool& bInCache) cons
   CUtil::GetDirectory(translatedFile, strPath);
   CUtil::RemoveSlashAtEnd(strPath);
 
-  for (civecCache i = m_vecCache.begin(); i != m_vecCache.end(); i++)
+  CDir* dir = Find(strPath);
+  if (dir && !dir->IsExpired(timeGetTime()))
   {
-    const CDir* dir = *i;
-    if (dir->m_strPath == strPath)
-    {
-      bInCache = true;
-      if (dir->m_Items->Contains(translatedFile))
-        return true;
-    }
+    bInCache = true;
+    Touch(dir);
+    m_iHits++;
+    return dir->m_Items->Contains(translatedFile);
   }
+  m_iMisses++;
   return false;
 }
 
@@ -186,20 +263,28 @@ void CDirectoryCache::Clear()
   // this routine clears everything except things we always cache
   CSingleLock lock (m_cs);
 
-  ivecCache i = m_vecCache.begin();
-  while (i != m_vecCache.end() )
+  PrintStats();
+
+  imapCache i = m_cache.begin();
+  while (i != m_cache.end())
   {
-    CDir* dir = *i;
+    CDir* dir = i->second;
+    ++i;
     if (!IsCacheDir(dir->m_strPath))
-    {
-      delete dir;
-      i = m_vecCache.erase(i);
-    }
-    else
-      i++;
+      Delete(dir);
   }
 }
 
+void CDirectoryCache::PrintStats() const
+{
+  CSingleLock lock (m_cs);
+
+  unsigned int iLookups = m_iHits + m_iMisses;
+  CLog::Log(LOGDEBUG, "%s - %u entries, %u bytes, hits: %u, misses: %u (%u%% hit rate), expired: %u, evicted: %u",
+            __FUNCTION__, (unsigned int)m_cache.size(), m_iCacheSize, m_iHits, m_iMisses,
+            iLookups ? m_iHits * 100 / iLookups : 0, m_iExpired, m_iEvicted);
+}
+
 void CDirectoryCache::InitCache(set<CStdString>& dirs)
 {
   set<CStdString>::iterator it;
@@ -214,17 +299,13 @@ void CDirectoryCache::InitCache(set<CStdString>& dirs)
 
 void CDirectoryCache::ClearCache(set<CStdString>& dirs)
 {
-  ivecCache i = m_vecCache.begin();
-  while (i != m_vecCache.end() )
+  imapCache i = m_cache.begin();
+  while (i != m_cache.end())
   {
-    CDir* dir = *i;
+    CDir* dir = i->second;
+    ++i;
     if (dirs.find(dir->m_strPath) != dirs.end())
-    {
-      delete dir;
-      m_vecCache.erase(i);
-    }
-    else
-      i++;
+      Delete(dir);
   }
 }
 
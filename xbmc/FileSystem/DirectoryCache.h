@@ -24,11 +24,19 @@
 #include "Directory.h"
 
 #include <set>
+#include <map>
+#include <list>
 
 class CFileItem;
 
 namespace DIRECTORY
 {
+  /*
+   * Directory listings are indexed by their normalised path (translated, no trailing slash).
+   * Entries are kept in least recently used order and the oldest ones are evicted once the
+   * estimated size of all cached listings goes over g_advancedSettings.m_dirCacheMaxSize.
+   * DIR_CACHE_ALWAYS listings of remote shares expire after m_dirCacheRemoteTTL seconds.
+   */
   class CDirectoryCache
   {
     class CDir
@@ -36,9 +44,15 @@ namespace DIRECTORY
     public:
       CDir(const CStdString &strPath, DIR_CACHE_TYPE cacheType);
       virtual ~CDir();
+      bool IsExpired(DWORD dwNow) const;
+
       CStdString m_strPath;
       CFileItemList* m_Items;
       DIR_CACHE_TYPE m_cacheType;
+      unsigned int m_iSize;       // estimated memory used by m_Items
+      unsigned int m_iSequence;   // insertion order, see ClearSubPaths()
+      DWORD m_dwExpires;          // 0 if the entry never expires
+      std::list<CDir*>::iterator m_lru;
     };
   public:
     CDirectoryCache(void);
@@ -53,14 +67,36 @@ namespace DIRECTORY
     void ClearThumbCache();
     void InitMusicThumbCache();
     void ClearMusicThumbCache();
+    void PrintStats() const;
   protected:
     void InitCache(std::set<CStdString>& dirs);
     void ClearCache(std::set<CStdString>& dirs);
     bool IsCacheDir(const CStdString &strPath) const;
 
-    std::vector<CDir*> m_vecCache;
-    typedef std::vector<CDir*>::iterator ivecCache;
-    typedef std::vector<CDir*>::const_iterator civecCache;
+    static CStdString NormalisePath(const CStdString &strPath);
+    static unsigned int EstimateSize(const CFileItemList &items);
+    CDir* Find(const CStdString &storedPath) const;
+    void Touch(CDir* dir) const;
+    void Delete(CDir* dir);
+    void Evict();
+
+    typedef std::map<CStdString, CDir*> mapCache;
+    typedef mapCache::iterator imapCache;
+    typedef mapCache::const_iterator cimapCache;
+    mapCache m_cache;
+
+    // entries by insertion order
+    std::map<unsigned int, CDir*> m_sequence;
+
+    // most recently used entries at the front. mutable, as lookups reorder it
+    mutable std::list<CDir*> m_lru;
+    unsigned int m_iCacheSize;
+    unsigned int m_iSequence;
+
+    mutable unsigned int m_iHits;
+    mutable unsigned int m_iMisses;
+    mutable unsigned int m_iExpired;
+    unsigned int m_iEvicted;
 
     CCriticalSection m_cs;
     std::set<CStdString> m_thumbDirs;
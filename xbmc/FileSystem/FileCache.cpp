@@ -25,6 +25,7 @@
 #include "utils/Thread.h"
 #include "File.h"
 #include "URL.h"
+#include "Util.h"
 
 #include "CacheMemBuffer.h"
 #include "utils/SingleLock.h"
@@ -37,6 +38,7 @@ using namespace XFILE;
 CFileCache::CFileCache()
 {
    m_bDeleteCache = true;
+   m_bDefaultCache = true;
    m_nSeekResult = 0;
    m_seekPos = 0;
    m_readPos = 0;
@@ -51,6 +53,7 @@ CFileCache::CFileCache(CCacheStrategy *pCache, bool bDeleteCache)
 {
   m_pCache = pCache;
   m_bDeleteCache = bDeleteCache;
+  m_bDefaultCache = false;
   m_seekPos = 0;
   m_readPos = 0; 
   m_nSeekResult = 0;
@@ -73,6 +76,7 @@ void CFileCache::SetCacheStrategy(CCacheStrategy *pCache, bool bDeleteCache)
 
   m_pCache = pCache;
   m_bDeleteCache = bDeleteCache;
+  m_bDefaultCache = false;
 }
 
 IFile *CFileCache::GetFileImp() {
@@ -111,6 +115,29 @@ bool CFileCache::Open(const CURL& url, bool bBinary)
   // check if source can seek
   m_bSeekPossible = m_source.Seek(0, SEEK_POSSIBLE) > 0 ? true : false;
 
+  // seekable sources are cached on disk when there is room for all of it, so seeking
+  // back into anything downloaded before is served locally instead of re-requesting it.
+  // that relies on holes: where the temp volume has none, a forward seek would make
+  // the write zero fill everything up to the new position, so the memory cache is kept.
+  __int64 iLength = m_source.GetLength();
+  CStdString strDrive = _P("Z:\\");
+  if (m_bDefaultCache && m_bSeekPossible && iLength > 0 && CSparseFileCache::SupportsSparseFiles(strDrive))
+  {
+    ULARGE_INTEGER lTotalFreeBytes;
+    if (GetDiskFreeSpaceEx(strDrive.c_str(), NULL, NULL, &lTotalFreeBytes) && (__int64)lTotalFreeBytes.QuadPart > iLength)
+    {
+      CSparseFileCache *pDiskCache = new CSparseFileCache();
+      if (pDiskCache->Open() == CACHE_RC_OK)
+      {
+        CLog::Log(LOGDEBUG,"CFileCache::Open - using disk cache for <%s>", url.GetFileName().c_str());
+        m_pCache->Close();
+        SetCacheStrategy(pDiskCache);
+      }
+      else
+        delete pDiskCache;
+    }
+  }
+
   m_readPos = 0;
   m_seekEvent.Reset();
   m_seekEnded.Reset();
@@ -326,6 +353,20 @@ __int64 CFileCache::Seek(__int64 iFilePosition, int iWhence)
       return -1;
     }
   }
+  else if (m_bSeekPossible)
+  {
+    // served from the cache, but the source may be filling some other part of it.
+    // have it continue where the cached data we are going to read ends.
+    __int64 iResume = m_pCache->GetSourceResumePosition(iTarget);
+    if (iResume >= 0)
+    {
+      m_seekPos = iResume;
+      m_seekEvent.Set();
+      if (!m_seekEnded.WaitMSec(INFINITE))
+        CLog::Log(LOGWARNING,"%s - resuming source at %"PRId64" failed.", __FUNCTION__, iResume);
+      m_nSeekResult = iTarget;
+    }
+  }
 
   if (m_nSeekResult >= 0)
     m_readPos = m_nSeekResult;
@@ -66,6 +66,7 @@ namespace XFILE
   private:
     CCacheStrategy *m_pCache;
     bool      m_bDeleteCache;
+    bool      m_bDefaultCache; // we created the strategy and may replace it
     bool      m_bSeekPossible;
     CFile      m_source;
     CStdString    m_sourcePath;
@@ -239,6 +239,17 @@ long CFileCurl::CReadState::Connect(unsigned int size)
   if (CURLE_OK == g_curlInterface.easy_getinfo(m_easyHandle, CURLINFO_CONTENT_LENGTH_DOWNLOAD, &length))
     m_fileSize = m_filePos + (__int64)length;
   
+  long response;
+  if (CURLE_OK != g_curlInterface.easy_getinfo(m_easyHandle, CURLINFO_RESPONSE_CODE, &response))
+    return -1;
+
+  // A conditional request answered with 304 Not Modified never carries a body.
+  if (response == 304)
+  {
+    m_fileSize = m_filePos;
+    return response;
+  }
+
   // If we started at the end of the file, then we're of course not able to read a single byte.
   if (m_fileSize != m_filePos && couldFillBuffer == false)
   {
@@ -246,11 +257,7 @@ long CFileCurl::CReadState::Connect(unsigned int size)
     return -1; 
   }
 
-  long response;
-  if (CURLE_OK == g_curlInterface.easy_getinfo(m_easyHandle, CURLINFO_RESPONSE_CODE, &response))
-    return response;
-
-  return -1;
+  return response;
 }
 
 void CFileCurl::CReadState::Disconnect()
@@ -282,6 +289,7 @@ CFileCurl::CFileCurl()
   m_seekable = true;
   m_useOldHttpVersion = false;
   m_timeout = 0;
+  m_httpresponse = -1;
   m_ftpauth = "";
   m_ftpport = "";
   m_ftppasvip = false;
@@ -604,6 +612,7 @@ bool CFileCurl::Open(const CURL& url, bool bBinary)
   m_opened = true;
 
   long response = m_state->Connect(m_bufferSize);
+  m_httpresponse = response;
   if( response < 0 )
     return false;
   
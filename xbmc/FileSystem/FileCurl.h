@@ -67,6 +67,7 @@ namespace XFILE
       void SetBufferSize(unsigned int size);
       
       const CHttpHeader& GetHttpHeader() { return m_state->m_httpheader; }
+      long GetResponseCode() const       { return m_httpresponse; } // of the last Open(), -1 if it failed
 
       /* static function that will get content type of a file */      
       static bool GetHttpHeader(const CURL &url, CHttpHeader &headers);
@@ -127,6 +128,7 @@ namespace XFILE
       CStdString      m_ftpport;
       bool            m_ftppasvip;
       int             m_timeout;
+      long            m_httpresponse;
       bool            m_opened;
       bool            m_useOldHttpVersion;
       bool            m_seekable;
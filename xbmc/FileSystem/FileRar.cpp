@@ -127,6 +127,8 @@ CFileRar::CFileRar()
   m_szStartOfBuffer = NULL;
   m_iDataInBuffer = 0;
   m_bUseFile = false;
+  m_bUseVolumes = false;
+  m_iSegment = -1;
   m_bOpen = false;
   m_bSeekable = true;
 }
@@ -143,6 +145,8 @@ CFileRar::~CFileRar()
     m_File.Close();
     g_RarManager.ClearCachedFile(m_strRarPath,m_strPathInRar); 
   }
+  else if (m_bUseVolumes)
+    m_File.Close();
   else
   {
     CleanUp();
@@ -174,6 +178,18 @@ bool CFileRar::Open(const CURL& url, bool bBinary)
   {
     if (items[i]->m_idepth == 0x30) // stored
     {
+      // the data lies as is in the volumes, read it from there when we can
+      if (g_RarManager.GetVolumeIndex(m_strRarPath, m_strPathInRar, m_volumes))
+      {
+        m_iFileSize = items[i]->m_dwSize;
+        m_iFilePosition = 0;
+        m_iSegment = -1;
+        m_bUseVolumes = true;
+        m_bSeekable = true;
+        m_bOpen = true;
+        return true;
+      }
+
       if (!OpenInArchive())
         return false;
 
@@ -278,6 +294,9 @@ unsigned int CFileRar::Read(void *lpBuf, __int64 uiBufSize)
   
   if (m_iFilePosition >= GetLength()) // we are done
     return 0;
+
+  if (m_bUseVolumes)
+    return ReadFromVolumes((byte*)lpBuf,uiBufSize);
   
   if( WaitForSingleObject(m_pExtract->GetDataIO().hBufferEmpty,5000) == WAIT_TIMEOUT )
   {
@@ -366,6 +385,14 @@ void CFileRar::Close()
     g_RarManager.ClearCachedFile(m_strRarPath,m_strPathInRar);
     m_bOpen = false;
   }
+  else if (m_bUseVolumes)
+  {
+    m_File.Close();
+    m_volumes.clear();
+    m_iSegment = -1;
+    m_bUseVolumes = false;
+    m_bOpen = false;
+  }
   else
   {
     CleanUp();
@@ -391,6 +418,23 @@ __int64 CFileRar::Seek(__int64 iFilePosition, int iWhence)
 
   if (m_bUseFile)
     return m_File.Seek(iFilePosition,iWhence);
+
+  if (m_bUseVolumes)
+  {
+    // the volume is positioned on the next read
+    if (iWhence == SEEK_CUR)
+      iFilePosition += m_iFilePosition;
+    else if (iWhence == SEEK_END)
+      iFilePosition += m_iFileSize;
+    else if (iWhence != SEEK_SET)
+      return -1;
+
+    if (iFilePosition < 0 || iFilePosition > m_iFileSize)
+      return -1;
+
+    m_iFilePosition = iFilePosition;
+    return m_iFilePosition;
+  }
   
   if( WaitForSingleObject(m_pExtract->GetDataIO().hBufferEmpty,SEEKTIMOUT) == WAIT_TIMEOUT )
   {
@@ -556,6 +600,70 @@ void CFileRar::InitFromUrl(const CURL& url)
 
 }
 
+unsigned int CFileRar::ReadFromVolumes(byte* pBuf, __int64 uiBufSize)
+{
+  __int64 iRead = 0;
+  while (iRead < uiBufSize && m_iFilePosition < m_iFileSize)
+  {
+    int iSegment = FindSegment(m_iFilePosition);
+    if (iSegment < 0)
+      break;
+
+    const RarVolumeSegment& segment = m_volumes[iSegment];
+    if (iSegment != m_iSegment)
+    {
+      // consecutive parts often share a volume, only reopen when it changes
+      if (m_iSegment < 0 || m_volumes[m_iSegment].strVolume != segment.strVolume)
+      {
+        m_File.Close();
+        m_iSegment = -1;
+        if (!m_File.Open(segment.strVolume))
+        {
+          CLog::Log(LOGERROR, "%s - failed to open volume %s", __FUNCTION__, segment.strVolume.c_str());
+          break;
+        }
+      }
+      m_iSegment = iSegment;
+    }
+
+    __int64 iOffset = m_iFilePosition - segment.iFileOffset;
+    if (m_File.GetPosition() != segment.iVolumeOffset + iOffset
+    &&  m_File.Seek(segment.iVolumeOffset + iOffset, SEEK_SET) < 0)
+      break;
+
+    __int64 iChunk = segment.iLength - iOffset;
+    if (iChunk > uiBufSize - iRead)
+      iChunk = uiBufSize - iRead;
+
+    unsigned int iBytes = m_File.Read(pBuf + iRead, iChunk);
+    if (iBytes == 0)
+      break;
+
+    iRead += iBytes;
+    m_iFilePosition += iBytes;
+  }
+  return (unsigned int)iRead;
+}
+
+int CFileRar::FindSegment(__int64 iFilePosition) const
+{
+  // last part starting at or before iFilePosition
+  int iLow = 0;
+  int iHigh = (int)m_volumes.size();
+  while (iLow < iHigh)
+  {
+    int iMid = (iLow + iHigh) / 2;
+    if (m_volumes[iMid].iFileOffset <= iFilePosition)
+      iLow = iMid + 1;
+    else
+      iHigh = iMid;
+  }
+
+  if (iLow == 0 || iFilePosition >= m_volumes[iLow - 1].iFileOffset + m_volumes[iLow - 1].iLength)
+    return -1;
+  return iLow - 1;
+}
+
 void CFileRar::CleanUp()
 {
 #ifdef HAS_RAR
@@ -32,6 +32,7 @@
 #include "IFile.h"
 #include "lib/UnrarXLib/rar.hpp"
 #include "utils/Thread.h"
+#include "RarManager.h"
 #ifdef HAS_RAR
 #endif
 
@@ -93,6 +94,8 @@ namespace XFILE
 		void InitFromUrl(const CURL& url);
     bool OpenInArchive();
     void CleanUp();
+    unsigned int ReadFromVolumes(byte* pBuf, __int64 uiBufSize);
+    int FindSegment(__int64 iFilePosition) const;
     
     __int64 m_iFilePosition;
     __int64 m_iFileSize;
@@ -100,7 +103,11 @@ namespace XFILE
     bool m_bUseFile;
     bool m_bOpen;
     bool m_bSeekable;
-    CFile m_File; // for packed source
+    CFile m_File; // for packed source, or the current volume of a stored one
+    // stored files are read straight from the volumes, m_iSegment is the part m_File is open on
+    bool m_bUseVolumes;
+    RarVolumeIndex m_volumes;
+    int m_iSegment;
 #ifdef HAS_RAR
     Archive* m_pArc;
     CommandData* m_pCmd;
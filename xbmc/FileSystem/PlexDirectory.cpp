@@ -24,6 +24,7 @@
 #include "FileItem.h"
 #include "GUIViewState.h"
 #include "GUIDialogOK.h"
+#include "utils/SingleLock.h"
 
 using namespace std;
 using namespace XFILE;
@@ -31,11 +32,15 @@ using namespace DIRECTORY;
 
 #define MASTER_PLEX_MEDIA_SERVER "http://localhost:32400"
 
+static void ComputeLabels(const string& nodeType, const CStdString& strURL, string& strFileLabel, string& strDirLabel, string& strSecondDirLabel);
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 CPlexDirectory::CPlexDirectory(bool parseResults)
   : m_bStop(false)
   , m_bSuccess(true)
   , m_bParseResults(parseResults)
+  , m_root(0)
+  , m_items(0)
   , m_dirCacheType(DIR_CACHE_ALWAYS)
 {
   m_timeout = 300;
@@ -44,6 +49,8 @@ CPlexDirectory::CPlexDirectory(bool parseResults)
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 CPlexDirectory::~CPlexDirectory()
 {
+  delete m_root;
+  delete m_items;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -108,14 +115,11 @@ bool CPlexDirectory::GetDirectory(const CStdString& strPath, CFileItemList &item
   if (m_bParseResults == false)
     return true;
   
-  // Parse returned xml.
-  TiXmlDocument doc;
-  doc.Parse(m_data.c_str());
-
-  TiXmlElement* root = doc.RootElement();
+  // The items were built while the response was streaming in.
+  TiXmlElement* root = m_root;
   if (root == 0)
   {
-    CLog::Log(LOGERROR, "%s - Unable to parse XML\n%s", __FUNCTION__, m_data.c_str());
+    CLog::Log(LOGERROR, "%s - Unable to parse XML from %s", __FUNCTION__, m_url.c_str());
     return false;
   }
   
@@ -125,12 +129,18 @@ bool CPlexDirectory::GetDirectory(const CStdString& strPath, CFileItemList &item
   if (fanart && strlen(fanart) > 0)
     strFanart = ProcessUrl(strPath, fanart, false);
 
-  // Walk the parsed tree.
+  // Labels depend on the kind of the items.
   string strFileLabel = "%N - %T"; 
   string strDirLabel = "%B";
   string strSecondDirLabel = "%Y";
   
-  Parse(m_url, root, items, strFileLabel, strDirLabel, strSecondDirLabel);
+  ComputeLabels(m_lastNodeType, m_url, strFileLabel, strDirLabel, strSecondDirLabel);
+  
+  if (m_items)
+  {
+    items.Append(*m_items);
+    m_items->Clear();
+  }
   
   // Set the window titles
   const char* title1 = root->Attribute("title1");
@@ -225,6 +235,7 @@ class PlexMediaNode
 {
  public:
    static PlexMediaNode* Create(const string& name);
+   virtual ~PlexMediaNode() {}
    
    CFileItemPtr BuildFileItem(const CURL& url, TiXmlElement& el)
    {
@@ -653,28 +664,287 @@ PlexMediaNode* PlexMediaNode::Create(const string& name)
 }
   
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-void CPlexDirectory::Parse(const CURL& url, TiXmlElement* root, CFileItemList &items, string& strFileLabel, string& strDirLabel, string& strSecondDirLabel)
+void CPlexDirectory::OnRootElement(TiXmlElement& root)
+{
+  delete m_root;
+  m_root = root.Clone()->ToElement();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+static void ComputeLabels(const string& nodeType, const CStdString& strURL, string& strFileLabel, string& strDirLabel, string& strSecondDirLabel)
+{
+  if (nodeType.empty())
+    return;
+  
+  PlexMediaNode* mediaNode = PlexMediaNode::Create(nodeType);
+  if (mediaNode != 0)
+  {
+    CStdString strPath;
+    CURL(strURL).GetURL(strPath);
+    mediaNode->ComputeLabels(strPath, strFileLabel, strDirLabel, strSecondDirLabel);
+    delete mediaNode;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CPlexDirectory::OnChildElement(const CURL& url, TiXmlElement& element)
+{
+  PlexMediaNode* mediaNode = PlexMediaNode::Create(element.Value());
+  if (mediaNode != 0)
+  {
+    CFileItemPtr item = mediaNode->BuildFileItem(url, element);
+    if (item)
+      m_items->Add(item);
+    
+    m_lastNodeType = element.Value();
+    delete mediaNode;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Cuts an XML document into its root element and the root's children as the data arrives, so
+// each child can be parsed and turned into an item on its own, without building the whole tree.
+//
+class PlexXmlStream
 {
-  PlexMediaNode* mediaNode = 0;
+ public:
+  PlexXmlStream(CPlexDirectory* pDirectory, const CURL& url)
+    : m_pDirectory(pDirectory)
+    , m_url(url)
+    , m_scan(0)
+    , m_depth(0)
+    , m_elementStart(0)
+    , m_bDone(false)
+  {
+  }
+  
+  void Write(const char* data, int size)
+  {
+    m_pending.append(data, size);
+    
+    while (m_bDone == false)
+    {
+      size_t start = m_pending.find('<', m_scan);
+      if (start == string::npos)
+      {
+        m_scan = m_pending.size();
+        break;
+      }
+      
+      size_t end = FindMarkupEnd(start);
+      if (end == string::npos)
+      {
+        // Incomplete markup, wait for more data.
+        m_scan = start;
+        break;
+      }
+      
+      m_scan = end + 1;
+      HandleMarkup(start, end);
+    }
+    
+    // Drop what we've consumed, unless we're in the middle of an element.
+    if (m_depth <= 1)
+    {
+      m_pending.erase(0, m_scan);
+      m_scan = 0;
+    }
+  }
   
-  for (TiXmlElement* element = root->FirstChildElement(); element; element=element->NextSiblingElement())
+ private:
+  // Returns the position of the '>' that ends the markup starting at pos.
+  size_t FindMarkupEnd(size_t pos)
   {
-    mediaNode = PlexMediaNode::Create(element->Value());
-    if (mediaNode != 0)
+    if (m_pending.compare(pos, 4, "<!--") == 0)
+      return Terminator(pos, "-->");
+    else if (m_pending.compare(pos, 9, "<![CDATA[") == 0)
+      return Terminator(pos, "]]>");
+    else if (m_pending.compare(pos, 2, "<?") == 0)
+      return Terminator(pos, "?>");
+    
+    // Tags and declarations, skip over quoted attribute values.
+    char quote = 0;
+    for (size_t i = pos + 1; i < m_pending.size(); i++)
     {
-      CFileItemPtr item = mediaNode->BuildFileItem(url, *element);
-      if (item)
-        items.Add(item);
+      char c = m_pending[i];
+      if (quote)
+      {
+        if (c == quote)
+          quote = 0;
+      }
+      else if (c == '"' || c == '\'')
+        quote = c;
+      else if (c == '>')
+        return i;
     }
+    
+    return string::npos;
   }
   
-  if (mediaNode != 0)
+  size_t Terminator(size_t pos, const char* terminator)
   {
-    CStdString strURL;
-    url.GetURL(strURL);
-    mediaNode->ComputeLabels(strURL, strFileLabel, strDirLabel, strSecondDirLabel);
+    size_t end = m_pending.find(terminator, pos);
+    if (end == string::npos)
+      return string::npos;
+    return end + strlen(terminator) - 1;
   }
-}
+  
+  void HandleMarkup(size_t start, size_t end)
+  {
+    char type = m_pending[start + 1];
+    
+    if (type == '?' || type == '!')
+    {
+      // Keep the declaration, it tells each fragment its encoding.
+      if (m_depth == 0 && m_pending.compare(start, 5, "<?xml") == 0)
+        m_declaration = m_pending.substr(start, end - start + 1);
+      return;
+    }
+    
+    if (type == '/')
+    {
+      if (--m_depth == 1)
+        ParseElement(m_elementStart, end);
+      else if (m_depth <= 0)
+        m_bDone = true;
+      return;
+    }
+    
+    bool bEmpty = m_pending[end - 1] == '/';
+    if (m_depth == 0)
+    {
+      // The root, parsed on its own with the children left out.
+      string root = m_pending.substr(start, end - start);
+      if (bEmpty == false)
+        root += "/";
+      root += ">";
+      
+      TiXmlDocument doc;
+      doc.Parse((m_declaration + root).c_str());
+      if (doc.RootElement())
+        m_pDirectory->OnRootElement(*doc.RootElement());
+      
+      if (bEmpty)
+        m_bDone = true;
+      else
+        m_depth = 1;
+    }
+    else if (m_depth == 1)
+    {
+      m_elementStart = start;
+      if (bEmpty)
+        ParseElement(start, end);
+      else
+        m_depth = 2;
+    }
+    else if (bEmpty == false)
+    {
+      m_depth++;
+    }
+  }
+  
+  void ParseElement(size_t start, size_t end)
+  {
+    TiXmlDocument doc;
+    doc.Parse((m_declaration + m_pending.substr(start, end - start + 1)).c_str());
+    if (doc.RootElement())
+      m_pDirectory->OnChildElement(m_url, *doc.RootElement());
+  }
+  
+  CPlexDirectory* m_pDirectory;
+  CURL   m_url;
+  string m_pending;
+  string m_declaration;
+  size_t m_scan;
+  int    m_depth;
+  size_t m_elementStart;
+  bool   m_bDone;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Keeps the last responses of the media servers that came with an ETag or a Last-Modified header,
+// so going back to a listing only costs a conditional request, answered with 304 if unchanged.
+// It's shared by all directory instances, and bounded in size with the oldest responses going first.
+//
+#define PLEX_RESPONSE_CACHE_SIZE       (4 * 1024 * 1024)
+#define PLEX_RESPONSE_CACHE_MAX_ENTRY  (512 * 1024)
+
+class PlexResponseCache
+{
+ public:
+  struct Entry
+  {
+    CStdString etag;
+    CStdString lastModified;
+    string     body;
+  };
+  
+  PlexResponseCache()
+    : m_size(0)
+  {
+  }
+  
+  bool Lookup(const CStdString& url, Entry& entry)
+  {
+    CSingleLock lock(m_lock);
+    
+    map<CStdString, Node>::iterator it = m_entries.find(url);
+    if (it == m_entries.end())
+      return false;
+    
+    m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+    entry = it->second.entry;
+    return true;
+  }
+  
+  void Store(const CStdString& url, const Entry& entry)
+  {
+    CSingleLock lock(m_lock);
+    Remove(url);
+    
+    if (entry.body.size() > PLEX_RESPONSE_CACHE_MAX_ENTRY)
+      return;
+    
+    while (m_lru.empty() == false && m_size + entry.body.size() > PLEX_RESPONSE_CACHE_SIZE)
+    {
+      CStdString oldest = m_lru.back();
+      Remove(oldest);
+    }
+    
+    m_lru.push_front(url);
+    Node& node = m_entries[url];
+    node.entry = entry;
+    node.lru = m_lru.begin();
+    m_size += entry.body.size();
+  }
+  
+  void Remove(const CStdString& url)
+  {
+    CSingleLock lock(m_lock);
+    
+    map<CStdString, Node>::iterator it = m_entries.find(url);
+    if (it == m_entries.end())
+      return;
+    
+    m_size -= it->second.entry.body.size();
+    m_lru.erase(it->second.lru);
+    m_entries.erase(it);
+  }
+  
+ private:
+  struct Node
+  {
+    Entry entry;
+    list<CStdString>::iterator lru;
+  };
+  
+  map<CStdString, Node> m_entries;
+  list<CStdString>      m_lru;     // most recently used first
+  size_t                m_size;    // bytes of all bodies
+  CCriticalSection      m_lock;
+};
+
+static PlexResponseCache g_plexResponseCache;
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 void CPlexDirectory::Process()
@@ -684,10 +954,25 @@ void CPlexDirectory::Process()
   url.SetProtocol("http");
   url.SetPort(32400);  
 
-  // Set request headers.
+  CStdString strCacheKey;
+  url.GetURL(strCacheKey);
+
+  // Set request headers, the conditional ones of an earlier listing mustn't stay around.
+  m_http.ClearRequestHeaders();
   m_http.SetRequestHeader("X-Plex-Version", Cocoa_GetAppVersion());
   m_http.SetRequestHeader("X-Plex-Language", Cocoa_GetLanguage());
   
+  // If we've seen this listing before, only ask for it if it changed.
+  PlexResponseCache::Entry cached;
+  bool bHaveCached = g_plexResponseCache.Lookup(strCacheKey, cached);
+  if (bHaveCached)
+  {
+    if (cached.etag.IsEmpty() == false)
+      m_http.SetRequestHeader("If-None-Match", cached.etag);
+    if (cached.lastModified.IsEmpty() == false)
+      m_http.SetRequestHeader("If-Modified-Since", cached.lastModified);
+  }
+  
   m_http.SetTimeout(m_timeout);
   if (m_http.Open(url, false) == false) 
   {
@@ -701,7 +986,22 @@ void CPlexDirectory::Process()
   url.SetProtocol(protocol);
 
   CStdString content = m_http.GetContent();
-  if (content.Equals("text/xml;charset=utf-8") == false && content.Equals("application/xml") == false)
+  if (bHaveCached && m_http.GetResponseCode() == 304)
+  {
+    CLog::Log(LOGDEBUG, "%s - %s not modified, using the cached response", __FUNCTION__, m_url.c_str());
+    
+    ResetResults();
+    if (m_bParseResults)
+    {
+      PlexXmlStream stream(this, CURL(m_url));
+      stream.Write(cached.body.data(), cached.body.size());
+    }
+    else
+    {
+      m_data = cached.body;
+    }
+  }
+  else if (content.Equals("text/xml;charset=utf-8") == false && content.Equals("application/xml") == false)
   {
     CLog::Log(LOGERROR, "%s - Invalid content type %s", __FUNCTION__, content.c_str());
     m_bSuccess = false;
@@ -713,27 +1013,65 @@ void CPlexDirectory::Process()
     int size_total = (int)m_http.GetLength();
     int data_size = 0;
   
-    m_data.reserve(size_total);
     printf("Content-Length was %d bytes\n", size_total);
     
-    // Read response from server into string buffer.
+    // Keep a copy of the response if the server gave us something to revalidate it with.
+    PlexResponseCache::Entry response;
+    response.etag = m_http.GetHttpHeader().GetValue("ETag");
+    response.lastModified = m_http.GetHttpHeader().GetValue("Last-Modified");
+    bool bCache = (response.etag.IsEmpty() == false || response.lastModified.IsEmpty() == false) && 
+                  size_total <= PLEX_RESPONSE_CACHE_MAX_ENTRY;
+    if (bCache)
+      response.body.reserve(max(size_total, 0));
+    
+    // Build the items while the response streams in, unless the caller wants the raw data.
+    PlexXmlStream stream(this, CURL(m_url));
+    ResetResults();
+    if (m_bParseResults == false)
+      m_data.reserve(size_total);
+    
     char buffer[4096];
-    while (m_bStop == false && (size_read = m_http.Read(buffer, sizeof(buffer)-1)) > 0)
+    while (m_bStop == false && (size_read = m_http.Read(buffer, sizeof(buffer))) > 0)
     {
-      buffer[size_read] = 0;
-      m_data += buffer;
+      if (m_bParseResults)
+        stream.Write(buffer, size_read);
+      else
+        m_data.append(buffer, size_read);
+      
+      if (bCache)
+      {
+        response.body.append(buffer, size_read);
+        bCache = response.body.size() <= PLEX_RESPONSE_CACHE_MAX_ENTRY;
+      }
+      
       data_size += size_read;
     }
     
     // If we didn't get it all, we failed.
-    if (m_data.size() != size_total)
+    if (data_size != size_total)
       m_bSuccess = false;
+    
+    if (m_bSuccess && m_bStop == false && bCache)
+      g_plexResponseCache.Store(strCacheKey, response);
+    else
+      g_plexResponseCache.Remove(strCacheKey);
   }
 
   m_http.Close();
   m_downloadEvent.Set();
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void CPlexDirectory::ResetResults()
+{
+  delete m_root;
+  m_root = 0;
+  delete m_items;
+  m_items = new CFileItemList();
+  m_lastNodeType.clear();
+  m_data.clear();
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 void CPlexDirectory::OnExit()
 {
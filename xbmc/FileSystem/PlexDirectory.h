@@ -14,6 +14,8 @@
 
 class CURL;
 class TiXmlElement;
+class CFileItemList;
+class PlexXmlStream;
 using namespace std;
 using namespace XFILE;
 
@@ -34,18 +36,25 @@ class CPlexDirectory : public IDirectory,
   string GetData() { return m_data; } 
   
  protected:
+  friend class ::PlexXmlStream;
    
   virtual void Process();
   virtual void OnExit();
   virtual void StopThread();
   
-  void Parse(const CURL& url, TiXmlElement* root, CFileItemList &items, string& strFileLabel, string& strDirLabel, string& strSecondDirLabel);
+  // called from the download thread as the response streams in
+  void OnRootElement(TiXmlElement& root);
+  void OnChildElement(const CURL& url, TiXmlElement& element);
+  void ResetResults();
   
   CEvent     m_downloadEvent;
   bool       m_bStop;
   
   CStdString m_url;
-  CStdString m_data;
+  CStdString m_data;          // raw response, only kept when the results aren't parsed
+  TiXmlElement*  m_root;      // attributes of the root element, without its children
+  CFileItemList* m_items;     // items built so far
+  string     m_lastNodeType;  // element name of the last item, decides the labels
   bool       m_bSuccess;
   bool       m_bParseResults;
   int        m_timeout;
@@ -410,6 +410,7 @@ void CRarManager::ClearCache(bool force)
   }
  
   m_ExFiles.clear();
+  m_VolumeIndex.clear();
 #endif
 }
 
@@ -436,6 +437,118 @@ void CRarManager::ClearCachedFile(const CStdString& strRarPath, const CStdString
 #endif
 }
 
+bool CRarManager::GetVolumeIndex(const CStdString& strRarPath, const CStdString& strPathInRar, RarVolumeIndex& index)
+{
+#ifdef HAS_RAR
+  CSingleLock lock(m_CritSection);
+
+  std::map<CStdString, std::map<CStdString, RarVolumeIndex> >::iterator j = m_VolumeIndex.find(strRarPath);
+  if (j == m_VolumeIndex.end())
+  {
+    std::map<CStdString, RarVolumeIndex> files;
+    BuildVolumeIndex(strRarPath, files);
+    j = m_VolumeIndex.insert(std::make_pair(strRarPath, files)).first;
+  }
+
+  std::map<CStdString, RarVolumeIndex>::iterator it = j->second.find(strPathInRar);
+  if (it == j->second.end())
+    return false;
+
+  index = it->second;
+  return true;
+#else
+  return false;
+#endif
+}
+
+void CRarManager::BuildVolumeIndex(const CStdString& strRarPath, std::map<CStdString, RarVolumeIndex>& files)
+{
+#ifdef HAS_RAR
+  // walks the headers of every volume in the set, without touching the data
+  std::map<CStdString, __int64> sizes;
+  std::set<CStdString> unusable;
+  char szVolume[NM];
+  strncpy(szVolume, strRarPath.c_str(), NM - 1);
+  szVolume[NM - 1] = '\0';
+
+  InitCRC();
+  bool bFirst = true;
+  while (1)
+  {
+    Archive arc;
+    if (!arc.WOpen(szVolume, NULL) || !arc.IsArchive(false))
+    {
+      if (!bFirst)
+        CLog::Log(LOGWARNING, "%s - volume %s missing, index of %s is incomplete", __FUNCTION__, szVolume, strRarPath.c_str());
+      break;
+    }
+
+    // old style or encrypted headers, or not opened at the first volume
+    if (arc.OldFormat || arc.Encrypted || (bFirst && arc.NotFirstVolume))
+      return;
+
+    bool bNextVolume = false;
+    while (arc.ReadHeader() > 0)
+    {
+      if (arc.GetHeaderType() == ENDARC_HEAD)
+      {
+        bNextVolume = (arc.EndArcHead.Flags & EARC_NEXT_VOLUME) != 0;
+        break;
+      }
+
+      if (arc.GetHeaderType() == FILE_HEAD && (arc.NewLhd.Flags & LHD_WINDOWMASK) != LHD_DIRECTORY)
+      {
+        IntToExt(arc.NewLhd.FileName, arc.NewLhd.FileName);
+        CStdString strName;
+        if (wcslen(arc.NewLhd.FileNameW) > 0)
+          g_charsetConverter.wToUTF8(arc.NewLhd.FileNameW, strName);
+        else
+          g_charsetConverter.stringCharsetToUtf8(arc.NewLhd.FileName, strName);
+        strName.Replace('\\', '/');
+
+        if (arc.NewLhd.Method != 0x30 || (arc.NewLhd.Flags & LHD_PASSWORD))
+          unusable.insert(strName);
+
+        if (unusable.find(strName) == unusable.end())
+        {
+          RarVolumeIndex& index = files[strName];
+          if (!(arc.NewLhd.Flags & LHD_SPLIT_BEFORE))
+            index.clear(); // a later entry of the same name replaces the earlier one
+
+          RarVolumeSegment segment;
+          segment.strVolume     = arc.FileName;
+          segment.iLength       = arc.NewLhd.FullPackSize;
+          segment.iVolumeOffset = arc.NextBlockPos - segment.iLength;
+          segment.iFileOffset   = index.empty() ? 0 : index.back().iFileOffset + index.back().iLength;
+          if (segment.iLength > 0)
+            index.push_back(segment);
+          sizes[strName] = arc.NewLhd.FullUnpSize;
+        }
+        bNextVolume = (arc.NewLhd.Flags & LHD_SPLIT_AFTER) != 0;
+      }
+      arc.SeekToNext();
+    }
+
+    if (!arc.Volume || !bNextVolume)
+      break;
+
+    NextVolumeName(szVolume, (arc.NewMhd.Flags & MHD_NEWNUMBERING) == 0 || arc.OldFormat);
+    bFirst = false;
+  }
+
+  // only keep files that are complete, anything else goes through unrar as before
+  for (std::map<CStdString, RarVolumeIndex>::iterator it = files.begin(); it != files.end();)
+  {
+    __int64 iSize = it->second.empty() ? 0 : it->second.back().iFileOffset + it->second.back().iLength;
+    if (unusable.find(it->first) != unusable.end() || iSize != sizes[it->first])
+      files.erase(it++);
+    else
+      ++it;
+  }
+  CLog::Log(LOGDEBUG, "%s - %u stored files of %s can be read from the volumes", __FUNCTION__, (unsigned int)files.size(), strRarPath.c_str());
+#endif
+}
+
 void CRarManager::ExtractArchive(const CStdString& strArchive, const CStdString& strPath)
 {
 #ifdef HAS_RAR
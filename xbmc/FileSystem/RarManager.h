@@ -64,6 +64,18 @@ public:
   int m_iIsSeekable;
 };
 
+// part of a stored file, lying uncompressed in one volume of the archive set
+typedef struct stRarVolumeSegment
+{
+  CStdString strVolume;     // path of the volume holding this part
+  __int64    iVolumeOffset; // where the part starts in the volume
+  __int64    iFileOffset;   // where the part starts in the unpacked file
+  __int64    iLength;
+} RarVolumeSegment;
+
+// the parts of one stored file, ordered by iFileOffset
+typedef std::vector<RarVolumeSegment> RarVolumeIndex;
+
 class CRarManager
 {
 public:
@@ -83,12 +95,23 @@ public:
   void ClearCachedFile(const CStdString& strRarPath, const CStdString& strPathInRar);
   void ExtractArchive(const CStdString& strArchive, const CStdString& strPath);
   void SetWipeAtWill(bool bWipe) { m_bWipe = bWipe; }
+
+  /*
+   * fills index with the volume layout of a stored, unencrypted file, so it
+   * can be read straight from the volumes. the layout of the whole archive set
+   * is read once and kept until ClearCache().
+   * returns false if the file has to go through unrar.
+   */
+  bool GetVolumeIndex(const CStdString& strRarPath, const CStdString& strPathInRar, RarVolumeIndex& index);
 protected:
 
   bool ListArchive(const CStdString& strRarPath, ArchiveList_struct* &pArchiveList);
   std::map<CStdString, std::pair<ArchiveList_struct*,std::vector<CFileInfo> > > m_ExFiles;
   CCriticalSection m_CritSection;
 
+  void BuildVolumeIndex(const CStdString& strRarPath, std::map<CStdString, RarVolumeIndex>& files);
+  std::map<CStdString, std::map<CStdString, RarVolumeIndex> > m_VolumeIndex;
+
   __int64 CheckFreeSpace(const CStdString& strDrive);
 
   bool m_bWipe;
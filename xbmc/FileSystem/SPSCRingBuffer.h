@@ -0,0 +1,280 @@
+/*
+ *      Copyright (C) 2005-2008 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#ifndef SPSCRINGBUFFER_H
+#define SPSCRINGBUFFER_H
+
+#ifdef _LINUX
+#include "PlatformDefs.h"
+#endif
+#include <string.h>
+
+// full barrier, orders the data accesses against the position updates
+#if defined(__GNUC__)
+#define SPSC_MEMORY_BARRIER() __sync_synchronize()
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#define SPSC_MEMORY_BARRIER() _ReadWriteBarrier()
+#endif
+
+/**
+ * Lock free ring buffer for exactly one writer thread and one reader thread.
+ *
+ * Read and write positions are free running counters, only the writer moves
+ * the write position and only the reader moves the read position, so neither
+ * side needs a lock. The size is always a power of two so positions wrap with
+ * a mask, and the whole buffer is usable (no byte is kept as a marker).
+ *
+ * GetWriteBuffer()/CommitWrite() and GetReadBuffer()/CommitRead() give direct
+ * access to the contiguous part of the free space or data, so callers can
+ * fill or drain the buffer without an intermediate copy.
+ *
+ * Clear(), Create() and Destroy() are not thread safe and may only be called
+ * while neither side is using the buffer.
+ */
+class CSPSCRingBuffer
+{
+public:
+  CSPSCRingBuffer()
+  {
+    m_pBuf      = NULL;
+    m_iSize     = 0;
+    m_iMask     = 0;
+    m_iReadPos  = 0;
+    m_iWritePos = 0;
+  }
+
+  ~CSPSCRingBuffer()
+  {
+    Destroy();
+  }
+
+  // iSize is rounded up to the next power of two
+  bool Create(unsigned int iSize)
+  {
+    Destroy();
+
+    unsigned int iRealSize = 1;
+    while (iRealSize < iSize)
+      iRealSize <<= 1;
+
+    m_pBuf = new char[iRealSize];
+    if (!m_pBuf)
+      return false;
+
+    m_iSize = iRealSize;
+    m_iMask = iRealSize - 1;
+    return true;
+  }
+
+  void Destroy()
+  {
+    delete [] m_pBuf;
+    m_pBuf      = NULL;
+    m_iSize     = 0;
+    m_iMask     = 0;
+    m_iReadPos  = 0;
+    m_iWritePos = 0;
+  }
+
+  void Clear()
+  {
+    m_iReadPos  = 0;
+    m_iWritePos = 0;
+  }
+
+  unsigned int Size() const
+  {
+    return m_iSize;
+  }
+
+  unsigned int GetMaxReadSize() const
+  {
+    return m_iWritePos - m_iReadPos;
+  }
+
+  unsigned int GetMaxWriteSize() const
+  {
+    return m_iSize - (m_iWritePos - m_iReadPos);
+  }
+
+  //
+  // writer side
+  //
+
+  // returns the start of the contiguous free space, its length in iContiguous
+  char* GetWriteBuffer(unsigned int& iContiguous)
+  {
+    unsigned int iOffset = m_iWritePos & m_iMask;
+    unsigned int iFree   = GetMaxWriteSize();
+
+    iContiguous = m_iSize - iOffset;
+    if (iContiguous > iFree)
+      iContiguous = iFree;
+    return m_pBuf + iOffset;
+  }
+
+  // publishes iBytes written into the space returned by GetWriteBuffer()
+  void CommitWrite(unsigned int iBytes)
+  {
+    SPSC_MEMORY_BARRIER();
+    m_iWritePos = m_iWritePos + iBytes;
+  }
+
+  bool WriteBinary(const char* pBuf, unsigned int nBufLen)
+  {
+    if (nBufLen > GetMaxWriteSize())
+      return false;
+
+    unsigned int iWritten = 0;
+    while (iWritten < nBufLen)
+    {
+      unsigned int iOffset = (m_iWritePos + iWritten) & m_iMask;
+      unsigned int iChunk  = m_iSize - iOffset;
+      if (iChunk > nBufLen - iWritten)
+        iChunk = nBufLen - iWritten;
+
+      memcpy(m_pBuf + iOffset, pBuf + iWritten, iChunk);
+      iWritten += iChunk;
+    }
+    CommitWrite(nBufLen);
+    return true;
+  }
+
+  // appends all data of buf without consuming it from buf
+  bool Append(const CSPSCRingBuffer& buf)
+  {
+    unsigned int iBytes = buf.GetMaxReadSize();
+    if (iBytes > GetMaxWriteSize())
+      return false;
+
+    unsigned int iReadPos = buf.m_iReadPos;
+    while (iBytes > 0)
+    {
+      unsigned int iOffset = iReadPos & buf.m_iMask;
+      unsigned int iChunk  = buf.m_iSize - iOffset;
+      if (iChunk > iBytes)
+        iChunk = iBytes;
+
+      WriteBinary(buf.m_pBuf + iOffset, iChunk);
+      iReadPos += iChunk;
+      iBytes   -= iChunk;
+    }
+    return true;
+  }
+
+  //
+  // reader side
+  //
+
+  // returns the start of the contiguous readable data, its length in iContiguous
+  const char* GetReadBuffer(unsigned int& iContiguous) const
+  {
+    unsigned int iAvail  = GetMaxReadSize();
+    SPSC_MEMORY_BARRIER();
+    unsigned int iOffset = m_iReadPos & m_iMask;
+
+    iContiguous = m_iSize - iOffset;
+    if (iContiguous > iAvail)
+      iContiguous = iAvail;
+    return m_pBuf + iOffset;
+  }
+
+  // releases iBytes of the data returned by GetReadBuffer() to the writer
+  void CommitRead(unsigned int iBytes)
+  {
+    SPSC_MEMORY_BARRIER();
+    m_iReadPos = m_iReadPos + iBytes;
+  }
+
+  bool ReadBinary(char* pBuf, unsigned int nBufLen)
+  {
+    if (!PeekBinary(pBuf, nBufLen))
+      return false;
+
+    CommitRead(nBufLen);
+    return true;
+  }
+
+  // copies data out without consuming it
+  bool PeekBinary(char* pBuf, unsigned int nBufLen) const
+  {
+    if (nBufLen > GetMaxReadSize())
+      return false;
+
+    SPSC_MEMORY_BARRIER();
+    unsigned int iRead = 0;
+    while (iRead < nBufLen)
+    {
+      unsigned int iOffset = (m_iReadPos + iRead) & m_iMask;
+      unsigned int iChunk  = m_iSize - iOffset;
+      if (iChunk > nBufLen - iRead)
+        iChunk = nBufLen - iRead;
+
+      memcpy(pBuf + iRead, m_pBuf + iOffset, iChunk);
+      iRead += iChunk;
+    }
+    return true;
+  }
+
+  // moves nBufLen bytes into another ring buffer, the caller must be the writer of buf
+  bool ReadBinary(CSPSCRingBuffer& buf, unsigned int nBufLen)
+  {
+    if (nBufLen > GetMaxReadSize() || nBufLen > buf.GetMaxWriteSize())
+      return false;
+
+    unsigned int iRead = 0;
+    while (iRead < nBufLen)
+    {
+      unsigned int iContiguous;
+      const char* pSrc = GetReadBuffer(iContiguous);
+      if (iContiguous > nBufLen - iRead)
+        iContiguous = nBufLen - iRead;
+
+      buf.WriteBinary(pSrc, iContiguous);
+      CommitRead(iContiguous);
+      iRead += iContiguous;
+    }
+    return true;
+  }
+
+  bool SkipBytes(unsigned int nBufLen)
+  {
+    if (nBufLen > GetMaxReadSize())
+      return false;
+
+    CommitRead(nBufLen);
+    return true;
+  }
+
+protected:
+  char*                 m_pBuf;
+  unsigned int          m_iSize;
+  unsigned int          m_iMask;
+  volatile unsigned int m_iReadPos;  // only written by the reader
+  volatile unsigned int m_iWritePos; // only written by the writer
+
+private:
+  CSPSCRingBuffer(const CSPSCRingBuffer&);
+  CSPSCRingBuffer& operator=(const CSPSCRingBuffer&);
+};
+
+#endif
@@ -31,33 +31,75 @@ CGUILargeTextureManager g_largeTextureManager;
 
 CGUILargeTextureManager::CGUILargeTextureManager()
 {
-  m_running = false;
+  for (unsigned int i = 0; i < NUM_LOADERS; i++)
+    m_loaders[i] = new CLoader(this);
+  memset(&m_stats, 0, sizeof(m_stats));
+  m_stopping = false;
 }
 
 CGUILargeTextureManager::~CGUILargeTextureManager()
 {
-  m_bStop = true;
-  m_listEvent.Set();
-  StopThread();
+  {
+    CSingleLock lock(m_listSection);
+    m_stopping = true;
+  }
+  for (unsigned int i = 0; i < NUM_LOADERS; i++)
+  {
+    m_loaders[i]->StopThread();
+    delete m_loaders[i];
+  }
 }
 
-// Process loop for this thread
-// Check and deallocate images that have been finished with.
-// And allocate new images that have been queued.
-// Once there's nothing queued or allocated, end the thread.
-void CGUILargeTextureManager::Process()
+// picks the next image to load, the caller must hold m_listSection.
+// images that a control has polled recently are on screen, so they go first,
+// oldest request first. otherwise the oldest request wins.
+CGUILargeTextureManager::CLargeTexture *CGUILargeTextureManager::GetNextImage()
+{
+  unsigned int now = timeGetTime();
+  CLargeTexture *next = NULL;
+  bool nextVisible = false;
+  for (listIterator it = m_queued.begin(); it != m_queued.end(); ++it)
+  {
+    CLargeTexture *image = *it;
+    if (image->IsLoading())
+      continue;
+    bool visible = now - image->GetTimeRequested() < VISIBLE_TIME;
+    if (!next || (visible && !nextVisible))
+    {
+      next = image;
+      nextVisible = visible;
+    }
+    // m_queued is in request order, so the first visible image is the oldest one
+    if (nextVisible)
+      break;
+  }
+  return next;
+}
+
+// Process loop for each loader thread.
+// Loads queued images, most wanted first, until there's nothing left to claim.
+// Images that are released while they load are thrown away once loaded.
+void CGUILargeTextureManager::LoadImages(CLoader *loader)
 {
   // lock item list
   CSingleLock lock(m_listSection);
-  m_running = true;
 
-  while (m_queued.size() && !m_bStop)
-  { // load the top item in the queue
+  while (!loader->IsStopping() && !m_stopping)
+  {
+    CLargeTexture *image = GetNextImage();
+    if (!image)
+      break;
+
     // take a copy of the details required for the load, as
     // it may be no longer required by the time the load is complete
-    CLargeTexture *image = m_queued[0];
+    image->SetLoading();
+    loader->m_busy = true;
     CStdString path = image->GetPath();
+    int maxSize = image->GetMaxSize();
+    unsigned int start = timeGetTime();
+    unsigned int queueTime = start - image->GetTimeQueued();
     lock.Leave();
+
     // load the image using our image lib
     SDL_Surface * texture = NULL;
     CPicture pic;
@@ -69,29 +111,51 @@ void CGUILargeTextureManager::Process()
       {
         loadPath = g_TextureManager.GetTexturePath(path);
       }
-      texture = pic.Load(loadPath, std::min(g_graphicsContext.GetWidth(), 2048), std::min(g_graphicsContext.GetHeight(), 1080));
+      int maxWidth = std::min(g_graphicsContext.GetWidth(), 2048);
+      int maxHeight = std::min(g_graphicsContext.GetHeight(), 1080);
+      if (maxSize)
+      { // decode no larger than the control can show
+        maxWidth = std::min(maxWidth, maxSize);
+        maxHeight = std::min(maxHeight, maxSize);
+      }
+      texture = pic.Load(loadPath, maxWidth, maxHeight);
     }
+
     // and add to our allocated list
     lock.Enter();
-    if (m_queued.size() && m_queued[0]->GetPath() == path)
+    loader->m_busy = false;
+    listIterator it = m_queued.begin();
+    while (it != m_queued.end() && !((*it)->IsLoading() && (*it)->GetPath() == path))
+      ++it;
+    if (it != m_queued.end())
     {
       // still have the same image in the queue, so move it across to the
       // allocated list, even if it doesn't exist
-      CLargeTexture *image = m_queued[0];
+      CLargeTexture *image = *it;
       image->SetTexture(texture, pic.GetWidth(), pic.GetHeight(), (g_guiSettings.GetBool("pictures.useexifrotation") && pic.GetExifInfo()->Orientation) ? pic.GetExifInfo()->Orientation - 1: 0);
       m_allocated.push_back(image);
-      m_queued.erase(m_queued.begin());
+      m_queued.erase(it);
+
+      m_stats.iLoaded++;
+      m_stats.iQueueTimeTotal += queueTime;
+      if (queueTime > m_stats.iQueueTimeMax)
+        m_stats.iQueueTimeMax = queueTime;
+      m_stats.iLoadTimeTotal += timeGetTime() - start;
     }
     else
     { // no need for the texture any more
       SDL_FreeSurface(texture);
       texture = NULL;
+      m_stats.iDiscarded++;
     }
-    lock.Leave();
-    m_listEvent.WaitMSec(1000);
-    lock.Enter();
   }
-  m_running = false;
+
+  loader->m_running = false;
+  bool idle = m_queued.empty();
+  lock.Leave();
+
+  if (idle && !m_stopping)
+    LogStats();
 }
 
 void CGUILargeTextureManager::CleanupUnusedImages()
@@ -107,15 +171,14 @@ void CGUILargeTextureManager::CleanupUnusedImages()
     else
       ++it;
   }
-  m_listEvent.Set();
 }
 
 // if available, increment reference count, and return the image.
 // else, add to the queue list if appropriate.
 #ifdef HAS_SDL_2D
-SDL_Surface * CGUILargeTextureManager::GetImage(const CStdString &path, int &width, int &height, int &orientation, bool firstRequest)
+SDL_Surface * CGUILargeTextureManager::GetImage(const CStdString &path, int &width, int &height, int &orientation, bool firstRequest, int maxSize)
 #else
-CGLTexture * CGUILargeTextureManager::GetImage(const CStdString &path, int &width, int &height, int &orientation, bool firstRequest)
+CGLTexture * CGUILargeTextureManager::GetImage(const CStdString &path, int &width, int &height, int &orientation, bool firstRequest, int maxSize)
 #endif
 {
   // note: max size to load images: 2048x1024? (8MB)
@@ -133,10 +196,22 @@ CGLTexture * CGUILargeTextureManager::GetImage(const CStdString &path, int &widt
       return image->GetTexture();
     }
   }
+
+  if (!firstRequest)
+  { // the control is still rendering, so keep the image at the front of the queue
+    for (listIterator it = m_queued.begin(); it != m_queued.end(); ++it)
+    {
+      if ((*it)->GetPath() == path)
+      {
+        (*it)->Touch();
+        break;
+      }
+    }
+    return NULL;
+  }
   lock.Leave();
 
-  if (firstRequest)
-    QueueImage(path);
+  QueueImage(path, maxSize);
 
   return NULL;
 }
@@ -157,39 +232,93 @@ void CGUILargeTextureManager::ReleaseImage(const CStdString &path, bool immediat
   for (listIterator it = m_queued.begin(); it != m_queued.end(); ++it)
   {
     CLargeTexture *image = *it;
-    if (image->GetPath() == path && image->DecrRef(true))
+    if (image->GetPath() == path)
     {
-      m_queued.erase(it);
+      // a loader that is busy with it notices it's gone when it's done
+      bool loading = image->IsLoading();
+      if (image->DecrRef(true))
+      {
+        m_queued.erase(it);
+        if (!loading)
+          m_stats.iDropped++;
+      }
       return;
     }
   }
 }
 
-// queue the image, and start the background loader if necessary
-void CGUILargeTextureManager::QueueImage(const CStdString &path)
+// queue the image, and start background loaders if necessary
+void CGUILargeTextureManager::QueueImage(const CStdString &path, int maxSize)
 {
   CSingleLock lock(m_listSection);
+  if (m_stopping)
+    return;
+
+  bool queued = false;
   for (listIterator it = m_queued.begin(); it != m_queued.end(); ++it)
   {
     CLargeTexture *image = *it;
     if (image->GetPath() == path)
     {
       image->AddRef();
-      return; // already queued
+      image->RequestSize(maxSize);
+      image->Touch();
+      queued = true;
+      break;
     }
   }
 
-  // queue the item
-  CLargeTexture *image = new CLargeTexture(path);
-  m_queued.push_back(image);
-  m_listEvent.Set();
-  
-  if(m_running)
-    return;
+  if (!queued)
+    m_queued.push_back(new CLargeTexture(path, maxSize));
+
+  // one loader per unclaimed image, up to NUM_LOADERS. loaders that are busy
+  // decoding don't count, they only pick up a waiting image once done
+  unsigned int waiting = 0;
+  for (listIterator it = m_queued.begin(); it != m_queued.end(); ++it)
+  {
+    if (!(*it)->IsLoading())
+      waiting++;
+  }
+  unsigned int idle = 0;
+  for (unsigned int i = 0; i < NUM_LOADERS; i++)
+  {
+    if (m_loaders[i]->m_running && !m_loaders[i]->m_busy)
+      idle++;
+  }
+
+  std::vector<CLoader *> start;
+  for (unsigned int i = 0; i < NUM_LOADERS && idle + start.size() < waiting; i++)
+  {
+    if (!m_loaders[i]->m_running)
+    {
+      m_loaders[i]->m_running = true;
+      start.push_back(m_loaders[i]);
+    }
+  }
 
   lock.Leave(); // done with our lock
 
-  StopThread();
-  Create();
+  for (unsigned int i = 0; i < start.size(); i++)
+  { // reap the previous run of this loader (it has already left the list lock) and restart it
+    start[i]->StopThread();
+    start[i]->Create();
+    start[i]->SetName("LargeTextureLoader");
+  }
+}
+
+void CGUILargeTextureManager::GetStats(LargeTextureStats &stats)
+{
+  CSingleLock lock(m_listSection);
+  stats = m_stats;
 }
 
+void CGUILargeTextureManager::LogStats()
+{
+  LargeTextureStats stats;
+  GetStats(stats);
+
+  unsigned int queueAvg = stats.iLoaded ? stats.iQueueTimeTotal / stats.iLoaded : 0;
+  unsigned int loadAvg = stats.iLoaded ? stats.iLoadTimeTotal / stats.iLoaded : 0;
+  CLog::Log(LOGDEBUG, "CGUILargeTextureManager - loaded: %u, dropped: %u, discarded: %u, queue time avg: %ums max: %ums, load time avg: %ums",
+                      stats.iLoaded, stats.iDropped, stats.iDiscarded, queueAvg, stats.iQueueTimeMax, loadAvg);
+}
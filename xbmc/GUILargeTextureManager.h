@@ -30,28 +30,51 @@
 
 #include <assert.h>
 
-class CGUILargeTextureManager : public CThread
+typedef struct stLargeTextureStats
+{
+  unsigned int iLoaded;        // images decoded and handed out
+  unsigned int iDropped;       // requests released before their decode started
+  unsigned int iDiscarded;     // requests released while they were being decoded
+  unsigned int iQueueTimeTotal; // ms between request and start of decode, summed over all loaded images
+  unsigned int iQueueTimeMax;
+  unsigned int iLoadTimeTotal;  // ms spent decoding, summed over all loaded images
+} LargeTextureStats;
+
+/*
+ * Loads large images (fanart and the like) in the background for CGUILargeImage.
+ *
+ * A small pool of loader threads is started on demand and exits once the queue
+ * is empty. Requests that have been polled by a rendering control recently (i.e.
+ * the ones on screen) are loaded first, the rest in request order, and requests
+ * released before their turn are dropped without being decoded. Images are
+ * decoded no larger than the size the control asks for.
+ */
+class CGUILargeTextureManager
 {
 public:
   CGUILargeTextureManager();
   virtual ~CGUILargeTextureManager();
 
-  virtual void Process();
-
+  /*
+   * maxSize bounds both dimensions of the decoded image, 0 means the screen size.
+   */
 #ifdef HAS_SDL_2D
-  SDL_Surface * GetImage(const CStdString &path, int &width, int &height, int &orientation, bool firstRequest);
+  SDL_Surface * GetImage(const CStdString &path, int &width, int &height, int &orientation, bool firstRequest, int maxSize = 0);
 #else
-  CGLTexture  * GetImage(const CStdString &path, int &width, int &height, int &orientation, bool firstRequest);
+  CGLTexture  * GetImage(const CStdString &path, int &width, int &height, int &orientation, bool firstRequest, int maxSize = 0);
 #endif
   void ReleaseImage(const CStdString &path, bool immediately = false);
 
   void CleanupUnusedImages();
 
+  void GetStats(LargeTextureStats &stats);
+  void LogStats();
+
 protected:
   class CLargeTexture
   {
   public:
-    CLargeTexture(const CStdString &path)
+    CLargeTexture(const CStdString &path, int maxSize)
     {
       m_path = path;
       m_width = 0;
@@ -60,6 +83,10 @@ protected:
       m_texture = NULL;
       m_refCount = 1;
       m_timeToDelete = 0;
+      m_maxSize = maxSize;
+      m_loading = false;
+      m_timeQueued = timeGetTime();
+      m_timeRequested = m_timeQueued;
     };
 
     virtual ~CLargeTexture()
@@ -126,6 +153,23 @@ protected:
     int GetOrientation() const { return m_orientation; };
     const CStdString &GetPath() const { return m_path; };
 
+    // the largest size any of the requesting controls asked for, 0 for the screen size
+    void RequestSize(int maxSize)
+    {
+      if (!m_maxSize || !maxSize)
+        m_maxSize = 0;
+      else if (maxSize > m_maxSize)
+        m_maxSize = maxSize;
+    };
+    int GetMaxSize() const { return m_maxSize; };
+
+    void Touch() { m_timeRequested = timeGetTime(); };
+    unsigned int GetTimeRequested() const { return m_timeRequested; };
+    unsigned int GetTimeQueued() const { return m_timeQueued; };
+
+    void SetLoading() { m_loading = true; };
+    bool IsLoading() const { return m_loading; };
+
   private:
     static const unsigned int TIME_TO_DELETE = 2000;
 
@@ -140,19 +184,41 @@ protected:
     int m_height;
     int m_orientation;
     unsigned int m_timeToDelete;
+    int m_maxSize;
+    bool m_loading;
+    unsigned int m_timeQueued;
+    unsigned int m_timeRequested;
   };
 
-  void QueueImage(const CStdString &path);
+  class CLoader : public CThread
+  {
+  public:
+    CLoader(CGUILargeTextureManager *manager) : m_running(false), m_busy(false), m_manager(manager) {};
+    bool IsStopping() const { return m_bStop; };
+    bool m_running; // guarded by the manager's m_listSection
+    bool m_busy;    // decoding an image, guarded by the manager's m_listSection
+  protected:
+    virtual void Process() { m_manager->LoadImages(this); };
+    CGUILargeTextureManager *m_manager;
+  };
+
+  void QueueImage(const CStdString &path, int maxSize);
+  void LoadImages(CLoader *loader);
+  CLargeTexture *GetNextImage();
 
 private:
+  static const unsigned int NUM_LOADERS = 2;
+  // requests polled within this many ms are on screen, and go first
+  static const unsigned int VISIBLE_TIME = 250;
+
   std::vector<CLargeTexture *> m_queued;
   std::vector<CLargeTexture *> m_allocated;
   typedef std::vector<CLargeTexture *>::iterator listIterator;
 
   CCriticalSection m_listSection;
-  CEvent m_listEvent;
-  bool m_running;
+  CLoader *m_loaders[NUM_LOADERS];
+  LargeTextureStats m_stats;
+  bool m_stopping;
 };
 
 extern CGUILargeTextureManager g_largeTextureManager;
-
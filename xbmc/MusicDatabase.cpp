@@ -2440,7 +2440,7 @@ bool CMusicDatabase::GetGenresNav(const CStdString& strBaseDir, CFileItemList& i
 
     // run query
     CLog::Log(LOGDEBUG, "%s query: %s", __FUNCTION__, strSQL.c_str());
-    if (!m_pDS->query(strSQL.c_str())) return false;
+    if (!m_pDS->query_forward(strSQL.c_str())) return false;
     int iRowsFound = m_pDS->num_rows();
     if (iRowsFound == 0)
     {
@@ -2449,12 +2449,14 @@ bool CMusicDatabase::GetGenresNav(const CStdString& strBaseDir, CFileItemList& i
     }
 
     // get data from returned rows
+    int genreColumn = m_pDS->fieldIndex("strGenre");
+    int idColumn = m_pDS->fieldIndex("idGenre");
     while (!m_pDS->eof())
     {
-      CFileItemPtr pItem(new CFileItem(m_pDS->fv("strGenre").get_asString()));
-      pItem->GetMusicInfoTag()->SetGenre(m_pDS->fv("strGenre").get_asString());
+      CFileItemPtr pItem(new CFileItem(m_pDS->fv(genreColumn).get_asString()));
+      pItem->GetMusicInfoTag()->SetGenre(m_pDS->fv(genreColumn).get_asString());
       CStdString strDir;
-      strDir.Format("%ld/", m_pDS->fv("idGenre").get_asLong());
+      strDir.Format("%ld/", m_pDS->fv(idColumn).get_asLong());
       pItem->m_strPath=strBaseDir + strDir;
       pItem->m_bIsFolder=true;
       items.Add(pItem);
@@ -2486,7 +2488,7 @@ bool CMusicDatabase::GetYearsNav(const CStdString& strBaseDir, CFileItemList& it
 
     // run query
     CLog::Log(LOGDEBUG, "%s query: %s", __FUNCTION__, strSQL.c_str());
-    if (!m_pDS->query(strSQL.c_str())) return false;
+    if (!m_pDS->query_forward(strSQL.c_str())) return false;
     int iRowsFound = m_pDS->num_rows();
     if (iRowsFound == 0)
     {
@@ -2497,12 +2499,12 @@ bool CMusicDatabase::GetYearsNav(const CStdString& strBaseDir, CFileItemList& it
     // get data from returned rows
     while (!m_pDS->eof())
     {
-      CFileItemPtr pItem(new CFileItem(m_pDS->fv("iYear").get_asString()));
+      CFileItemPtr pItem(new CFileItem(m_pDS->fv(0).get_asString()));
       SYSTEMTIME stTime;
-      stTime.wYear = (WORD)m_pDS->fv("iYear").get_asLong();
+      stTime.wYear = (WORD)m_pDS->fv(0).get_asLong();
       pItem->GetMusicInfoTag()->SetReleaseDate(stTime);
       CStdString strDir;
-      strDir.Format("%ld/", m_pDS->fv("iYear").get_asLong());
+      strDir.Format("%ld/", m_pDS->fv(0).get_asLong());
       pItem->m_strPath=strBaseDir + strDir;
       pItem->m_bIsFolder=true;
       items.Add(pItem);
@@ -2894,8 +2896,8 @@ bool CMusicDatabase::GetSongsByWhere(const CStdString &baseDir, const CStdString
     // We don't use FormatSQL here, as the WHERE clause is already formatted.
     CStdString strSQL = "select * from songview " + whereClause;
     CLog::Log(LOGDEBUG, "%s query = %s", __FUNCTION__, strSQL.c_str());
-    // run query
-    if (!m_pDS->query(strSQL.c_str()))
+    // run query, the rows are read as the items are built
+    if (!m_pDS->query_forward(strSQL.c_str()))
       return false;
     int iRowsFound = m_pDS->num_rows();
     if (iRowsFound == 0)
@@ -2904,8 +2906,6 @@ bool CMusicDatabase::GetSongsByWhere(const CStdString &baseDir, const CStdString
       return false;
     }
 
-    // get data from returned rows
-    items.Reserve(items.Size() + iRowsFound);
     // get songs from returned subtable
     int count = 0;
     while (!m_pDS->eof())
@@ -3701,6 +3701,33 @@ bool CMusicDatabase::GetPathHash(const CStdString &path, CStdString &hash)
   return false;
 }
 
+bool CMusicDatabase::GetPathHashes(map<CStdString, CStdString> &hashes)
+{
+  // all path hashes in one query, keyed on the lower case path as GetPathHash() matches with like
+  try
+  {
+    if (NULL == m_pDB.get()) return false;
+    if (NULL == m_pDS.get()) return false;
+
+    hashes.clear();
+    if (!m_pDS->query_forward("select strPath, strHash from path")) return false;
+    while (!m_pDS->eof())
+    {
+      CStdString path = m_pDS->fv(0).get_asString();
+      path.ToLower();
+      hashes[path] = m_pDS->fv(1).get_asString();
+      m_pDS->next();
+    }
+    m_pDS->close();
+    return true;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s failed", __FUNCTION__);
+  }
+  return false;
+}
+
 bool CMusicDatabase::RemoveSongsFromPath(const CStdString &path, CSongMap &songs)
 {
   // We need to remove all songs from this path, as their tags are going
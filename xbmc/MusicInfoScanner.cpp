@@ -50,13 +50,54 @@ using namespace MUSIC_INFO;
 using namespace DIRECTORY;
 using namespace MUSIC_GRABBER;
 
+// directories the walkers may queue ahead of each tag reader
+#define SCAN_QUEUE_PER_READER 4
+// songs written per database transaction
+#define SCAN_BATCH_SONGS      500
+
+namespace MUSIC_INFO
+{
+// a directory on its way through the scan pipeline
+class CMusicScanDirectory
+{
+public:
+  CMusicScanDirectory(const CStdString &path) : strPath(path), bChanged(false) {}
+
+  CStdString strPath;
+  CStdString strHash;
+  bool bChanged;
+  CFileItemList items;
+  VECSONGS songs;
+  vector<CStdString> files; // the item each song was read from
+};
+}
+
+// the loaders that parse the tags themselves can run side by side, the ones going
+// through a dll (mp3 uses the shared id3tag and ape wrappers, others a codec) and
+// cdda, which talks to the drive, are run one at a time
+static bool CanLoadTagConcurrently(const CStdString &strFileName)
+{
+  CStdString strExtension;
+  CUtil::GetExtension(strFileName, strExtension);
+  strExtension.ToLower();
+  return strExtension == ".ogg" || strExtension == ".flac" || strExtension == ".wma" ||
+         strExtension == ".m4a" || strExtension == ".mp4" || strExtension == ".m4p";
+}
+
+static CCriticalSection g_tagLoaderSection;
+
 CMusicInfoScanner::CMusicInfoScanner()
+  : m_walker(this, false), m_tagReader(this, true)
 {
   m_bRunning = false;
   m_pObserver = NULL;
   m_bCanInterrupt = false;
   m_currentItem=0;
   m_itemCount=0;
+  m_queueLimit=0;
+  m_walkersBusy=0;
+  m_walkersRunning=0;
+  m_readersRunning=0;
 }
 
 CMusicInfoScanner::~CMusicInfoScanner()
@@ -82,7 +123,6 @@ void CMusicInfoScanner::Process()
     if (m_scanType == 0) // load info from files
     {
       CLog::Log(LOGDEBUG, "%s - Starting scan", __FUNCTION__);
-      //m_musicDatabase.BeginTransaction();
 
       if (m_pObserver)
         m_pObserver->OnStateChanged(READING_MUSIC_INFO);
@@ -103,18 +143,8 @@ void CMusicInfoScanner::Process()
       m_bCanInterrupt = false;
       m_needsCleanup = false;
 
-      bool commit = false;
-      bool cancelled = false;
-      while (!cancelled && m_pathsToScan.size())
-      {
-        if (!DoScan(*m_pathsToScan.begin()))
-          cancelled = true;
-        commit = !cancelled;
-      }
-
-      if (commit)
+      if (DoScan())
       {
-        //m_musicDatabase.CommitTransaction();
         g_infoManager.ResetPersistentCache();
 
         if (m_needsCleanup)
@@ -130,8 +160,6 @@ void CMusicInfoScanner::Process()
           m_musicDatabase.Compress(false);
         }
       }
-      //else
-      //  m_musicDatabase.RollbackTransaction();
 
       fileCountReader.StopThread();
 
@@ -323,159 +351,411 @@ void CMusicInfoScanner::SetObserver(IMusicInfoScannerObserver* pObserver)
   m_pObserver = pObserver;
 }
 
-bool CMusicInfoScanner::DoScan(const CStdString& strDirectory)
+void CMusicInfoScanner::CScanWorker::Run()
 {
-  if (m_pObserver)
-    m_pObserver->OnDirectoryChanged(strDirectory);
+  if (m_readTags)
+    m_scanner->ReadTags();
+  else
+    m_scanner->WalkDirectories();
+}
+
+bool CMusicInfoScanner::DoScan()
+{
+  int walkers = g_advancedSettings.m_musicLibraryScanDirectoryThreads;
+  int readers = g_advancedSettings.m_musicLibraryScanTagThreads;
+
+  // the walkers compare against these, so they don't need a database connection
+  m_musicDatabase.GetPathHashes(m_pathHashes);
+
+  {
+    CSingleLock lock(m_scanSection);
+    for (set<CStdString>::iterator it = m_pathsToScan.begin(); it != m_pathsToScan.end(); ++it)
+    {
+      if (m_dirsQueued.insert(*it).second)
+        m_dirQueue.push_back(*it);
+    }
+    m_queueLimit = readers * SCAN_QUEUE_PER_READER;
+    m_walkersBusy = 0;
+    m_walkersRunning = walkers;
+    m_readersRunning = readers;
+  }
+
+  vector<CThread*> workers;
+  for (int i = 0; i < walkers + readers; i++)
+  {
+    CThread *worker = new CThread(i < walkers ? (IRunnable*)&m_walker : (IRunnable*)&m_tagReader);
+    worker->Create();
+    worker->SetPriority(THREAD_PRIORITY_IDLE);
+    workers.push_back(worker);
+  }
+  CLog::Log(LOGDEBUG, "%s - scanning with %i directory and %i tag threads", __FUNCTION__, walkers, readers);
+
+  // this thread is the only writer, the songs of a directory all go in at once and
+  // the transaction is committed every SCAN_BATCH_SONGS songs or when we run dry
+  bool inTransaction = false;
+  int songsInTransaction = 0;
+  int lastProgress = -1;
+  while (!m_bStop)
+  {
+    CMusicScanDirectory *directory = NULL;
+    bool finished = false;
+    int currentItem;
+    {
+      CSingleLock lock(m_scanSection);
+      if (!m_resultQueue.empty())
+      {
+        directory = m_resultQueue.front();
+        m_resultQueue.pop_front();
+      }
+      else if (m_walkersRunning == 0 && m_readersRunning == 0)
+        finished = true;
+      currentItem = m_currentItem;
+    }
+
+    // notify our observer of our progress
+    if (m_pObserver && m_itemCount > 0 && currentItem != lastProgress)
+    {
+      m_pObserver->OnSetProgress(currentItem, m_itemCount);
+      lastProgress = currentItem;
+    }
 
+    if (finished)
+      break;
+
+    if (!directory)
+    { // nothing to write - don't keep the database locked while the readers are busy
+      if (inTransaction)
+      {
+        m_musicDatabase.CommitTransaction();
+        inTransaction = false;
+        songsInTransaction = 0;
+      }
+      m_resultEvent.WaitMSec(100);
+      continue;
+    }
+    m_tagEvent.Set();  // room in the result queue
+    m_walkEvent.Set();
+
+    if (directory->bChanged && !inTransaction)
+    {
+      m_musicDatabase.BeginTransaction();
+      inTransaction = true;
+    }
+    songsInTransaction += WriteDirectory(*directory);
+
+    bool fetchInfo = directory->songs.size() &&
+                     (g_guiSettings.GetBool("musiclibrary.autoartistinfo") || g_guiSettings.GetBool("musiclibrary.autoalbuminfo"));
+    if (inTransaction && (fetchInfo || songsInTransaction >= SCAN_BATCH_SONGS))
+    {
+      m_musicDatabase.CommitTransaction();
+      inTransaction = false;
+      songsInTransaction = 0;
+    }
+
+    // the online lookups take their time, so they run outside the transaction
+    if (fetchInfo)
+      DownloadSongInfo(directory->songs);
+
+    delete directory;
+  }
+
+  // what has been written is complete per directory, so keep it even when cancelled
+  if (inTransaction)
+    m_musicDatabase.CommitTransaction();
+
+  for (unsigned int i = 0; i < workers.size(); i++)
+  {
+    workers[i]->StopThread();
+    delete workers[i];
+  }
+  ClearScanQueues();
+
+  return !m_bStop;
+}
+
+// This function is run by the directory walker threads
+void CMusicInfoScanner::WalkDirectories()
+{
+  while (!m_bStop)
+  {
+    CStdString strDirectory;
+    {
+      CSingleLock lock(m_scanSection);
+      if (m_dirQueue.empty() && m_walkersBusy == 0)
+        break; // nothing left, and nobody is going to find any more
+      if (!m_dirQueue.empty())
+      {
+        strDirectory = m_dirQueue.front();
+        m_dirQueue.pop_front();
+        m_walkersBusy++;
+      }
+    }
+
+    if (strDirectory.IsEmpty())
+    { // another walker may still turn up subfolders
+      m_walkEvent.WaitMSec(50);
+      continue;
+    }
+
+    WalkDirectory(strDirectory);
+
+    {
+      CSingleLock lock(m_scanSection);
+      m_walkersBusy--;
+    }
+    m_walkEvent.Set();
+  }
+
+  {
+    CSingleLock lock(m_scanSection);
+    m_walkersRunning--;
+  }
+  // pass it on, so the idle walkers and the readers notice we're done
+  m_walkEvent.Set();
+  m_tagEvent.Set();
+  m_resultEvent.Set();
+}
+
+void CMusicInfoScanner::WalkDirectory(const CStdString& strDirectory)
+{
   // load subfolder
-  CFileItemList items;
+  CMusicScanDirectory *directory = new CMusicScanDirectory(strDirectory);
+  CFileItemList &items = directory->items;
   CDirectory::GetDirectory(strDirectory, items, g_stSettings.m_musicExtensions + "|.jpg|.tbn");
 
   // sort and get the path hash.  Note that we don't filter .cue sheet items here as we want
   // to detect changes in the .cue sheet as well.  The .cue sheet items only need filtering
   // if we have a changed hash.
   items.Sort(SORT_METHOD_LABEL, SORT_ORDER_ASC);
-  CStdString hash;
-  GetPathHash(items, hash);
+  GetPathHash(items, directory->strHash);
+
+  // queue the subfolders straight away, so the other walkers can get going on them
+  {
+    CSingleLock lock(m_scanSection);
+    for (int i = 0; i < items.Size(); ++i)
+    {
+      CFileItemPtr pItem = items[i];
+      // if we have a directory item (non-playlist) we then recurse into that folder
+      if (pItem->m_bIsFolder && !pItem->IsParentFolder() && !pItem->IsPlayList() &&
+          m_dirsQueued.insert(pItem->m_strPath).second)
+        m_dirQueue.push_back(pItem->m_strPath);
+    }
+  }
+  m_walkEvent.Set();
 
   // get the folder's thumb (this will cache the album thumb).
   items.SetMusicThumb(true); // true forces it to get a remote thumb
 
   // check whether we need to rescan or not
-  CStdString dbHash;
-  if (!m_musicDatabase.GetPathHash(strDirectory, dbHash) || dbHash != hash)
+  CStdString path(strDirectory);
+  path.ToLower();
+  map<CStdString, CStdString>::const_iterator it = m_pathHashes.find(path);
+  if (it == m_pathHashes.end() || it->second != directory->strHash)
   { // path has changed - rescan
-    if (dbHash.IsEmpty())
+    if (it == m_pathHashes.end() || it->second.IsEmpty())
       CLog::Log(LOGDEBUG, "%s Scanning dir '%s' as not in the database", __FUNCTION__, strDirectory.c_str());
     else
       CLog::Log(LOGDEBUG, "%s Rescanning dir '%s' due to change", __FUNCTION__, strDirectory.c_str());
+    directory->bChanged = true;
 
-    // filter items in the sub dir (for .cue sheet support)
-    items.FilterCueItems();
-    items.Sort(SORT_METHOD_LABEL, SORT_ORDER_ASC);
-
-    // and then scan in the new information
-    if (RetrieveMusicInfo(items, strDirectory) > 0)
+    // hand it to the readers, waiting while they're behind
+    while (!m_bStop)
     {
-      if (m_pObserver)
-        m_pObserver->OnDirectoryScanned(strDirectory);
+      {
+        CSingleLock lock(m_scanSection);
+        if (m_tagQueue.size() < m_queueLimit)
+        {
+          m_tagQueue.push_back(directory);
+          directory = NULL;
+          break;
+        }
+      }
+      m_walkEvent.WaitMSec(50);
     }
-
-    // save information about this folder
-    m_musicDatabase.SetPathHash(strDirectory, hash);
+    if (directory)
+      delete directory; // cancelled
+    else
+      m_tagEvent.Set();
   }
   else
   { // path is the same - no need to rescan
     CLog::Log(LOGDEBUG, "%s Skipping dir '%s' due to no change", __FUNCTION__, strDirectory.c_str());
-    m_currentItem += CountFiles(items, false);  // false for non-recursive
+    int count = CountFiles(items, false);  // false for non-recursive
+    items.Clear();
 
-    // notify our observer of our progress
-    if (m_pObserver)
     {
-      if (m_itemCount>0)
-        m_pObserver->OnSetProgress(m_currentItem, m_itemCount);
-      m_pObserver->OnDirectoryScanned(strDirectory);
+      CSingleLock lock(m_scanSection);
+      m_currentItem += count;
     }
-  }
 
-  // remove this path from the list we're processing
-  set<CStdString>::iterator it = m_pathsToScan.find(strDirectory);
-  if (it != m_pathsToScan.end())
-    m_pathsToScan.erase(it);
+    // straight to the writer, which only has to tell the observer
+    while (!m_bStop)
+    {
+      {
+        CSingleLock lock(m_scanSection);
+        if (m_resultQueue.size() < m_queueLimit)
+        {
+          m_resultQueue.push_back(directory);
+          directory = NULL;
+          break;
+        }
+      }
+      m_walkEvent.WaitMSec(50);
+    }
+    if (directory)
+      delete directory; // cancelled
+    else
+      m_resultEvent.Set();
+  }
+}
 
-  // now scan the subfolders
-  for (int i = 0; i < items.Size(); ++i)
+// This function is run by the tag reader threads
+void CMusicInfoScanner::ReadTags()
+{
+  while (!m_bStop)
   {
-    CFileItemPtr pItem = items[i];
+    CMusicScanDirectory *directory = NULL;
+    {
+      CSingleLock lock(m_scanSection);
+      if (m_tagQueue.empty() && m_walkersRunning == 0)
+        break;
+      if (!m_tagQueue.empty())
+      {
+        directory = m_tagQueue.front();
+        m_tagQueue.pop_front();
+      }
+    }
 
-    if (m_bStop)
-      break;
-    // if we have a directory item (non-playlist) we then recurse into that folder
-    if (pItem->m_bIsFolder && !pItem->IsParentFolder() && !pItem->IsPlayList())
+    if (!directory)
+    {
+      m_tagEvent.WaitMSec(50);
+      continue;
+    }
+    m_walkEvent.Set(); // room in the tag queue
+
+    ReadDirectory(*directory);
+
+    // hand it to the writer, waiting while it's behind
+    while (!m_bStop)
     {
-      CStdString strPath=pItem->m_strPath;
-      if (!DoScan(strPath))
       {
-        m_bStop = true;
+        CSingleLock lock(m_scanSection);
+        if (m_resultQueue.size() < m_queueLimit)
+        {
+          m_resultQueue.push_back(directory);
+          directory = NULL;
+          break;
+        }
       }
+      m_tagEvent.WaitMSec(50);
     }
+    if (directory)
+      delete directory; // cancelled
+    else
+      m_resultEvent.Set();
   }
 
-  return !m_bStop;
+  {
+    CSingleLock lock(m_scanSection);
+    m_readersRunning--;
+  }
+  m_tagEvent.Set();
+  m_resultEvent.Set();
 }
 
-int CMusicInfoScanner::RetrieveMusicInfo(CFileItemList& items, const CStdString& strDirectory)
+void CMusicInfoScanner::ReadDirectory(CMusicScanDirectory& directory)
 {
-  CSongMap songsMap;
+  CFileItemList &items = directory.items;
 
-  // get all information for all files in current directory from database, and remove them
-  if (m_musicDatabase.RemoveSongsFromPath(strDirectory, songsMap))
-    m_needsCleanup = true;
+  // filter items in the sub dir (for .cue sheet support)
+  items.FilterCueItems();
+  items.Sort(SORT_METHOD_LABEL, SORT_ORDER_ASC);
 
-  VECSONGS songsToAdd;
   // for every file found, but skip folder
   for (int i = 0; i < items.Size(); ++i)
   {
     CFileItemPtr pItem = items[i];
-    CStdString strExtension;
-    CUtil::GetExtension(pItem->m_strPath, strExtension);
 
     if (m_bStop)
-      return 0;
+      return;
 
     // dont try reading id3tags for folders, playlists or shoutcast streams
     if (!pItem->m_bIsFolder && !pItem->IsPlayList() && !pItem->IsShoutCast() && !pItem->IsPicture())
     {
-      m_currentItem++;
 //      CLog::Log(LOGDEBUG, "%s - Reading tag for: %s", __FUNCTION__, pItem->m_strPath.c_str());
-
-      // grab info from the song
-      CSong *dbSong = songsMap.Find(pItem->m_strPath);
-
       CMusicInfoTag& tag = *pItem->GetMusicInfoTag();
       if (!tag.Loaded() )
       { // read the tag from a file
         auto_ptr<IMusicInfoTagLoader> pLoader (CMusicInfoTagLoaderFactory::CreateLoader(pItem->m_strPath));
         if (NULL != pLoader.get())
-          pLoader->Load(pItem->m_strPath, tag);
+        {
+          if (CanLoadTagConcurrently(pItem->m_strPath))
+            pLoader->Load(pItem->m_strPath, tag);
+          else
+          {
+            CSingleLock lock(g_tagLoaderSection);
+            pLoader->Load(pItem->m_strPath, tag);
+          }
+        }
       }
 
-      // if we have the itemcount, notify our
-      // observer with the progress we made
-      if (m_pObserver && m_itemCount>0)
-        m_pObserver->OnSetProgress(m_currentItem, m_itemCount);
+      {
+        CSingleLock lock(m_scanSection);
+        m_currentItem++;
+      }
 
       if (tag.Loaded())
       {
         CSong song(tag);
         song.iStartOffset = pItem->m_lStartOffset;
         song.iEndOffset = pItem->m_lEndOffset;
-        if (dbSong)
-        { // keep the db-only fields intact on rescan...
-          song.iTimesPlayed = dbSong->iTimesPlayed;
-          song.lastPlayed = dbSong->lastPlayed;
-          if (song.rating == '0') song.rating = dbSong->rating;
-        }
         pItem->SetMusicThumb();
         song.strThumb = pItem->GetThumbnailImage();
-        songsToAdd.push_back(song);
-//        CLog::Log(LOGDEBUG, "%s - Tag loaded for: %s", __FUNCTION__, spItem->m_strPath.c_str());
+        directory.songs.push_back(song);
+        directory.files.push_back(pItem->m_strPath);
       }
       else
         CLog::Log(LOGDEBUG, "%s - No tag found for: %s", __FUNCTION__, pItem->m_strPath.c_str());
     }
   }
 
-  CheckForVariousArtists(songsToAdd);
+  CheckForVariousArtists(directory.songs);
   if (!items.HasThumbnail())
-    UpdateFolderThumb(songsToAdd, items.m_strPath);
+    UpdateFolderThumb(directory.songs, items.m_strPath);
+
+  // the writer only needs the songs
+  items.Clear();
+}
+
+int CMusicInfoScanner::WriteDirectory(CMusicScanDirectory& directory)
+{
+  if (m_pObserver)
+    m_pObserver->OnDirectoryChanged(directory.strPath);
+
+  if (!directory.bChanged)
+  {
+    if (m_pObserver)
+      m_pObserver->OnDirectoryScanned(directory.strPath);
+    return 0;
+  }
+
+  CSongMap songsMap;
+
+  // get all information for all files in current directory from database, and remove them
+  if (m_musicDatabase.RemoveSongsFromPath(directory.strPath, songsMap))
+    m_needsCleanup = true;
 
   // finally, add these to the database
-  for (unsigned int i = 0; i < songsToAdd.size(); ++i)
+  for (unsigned int i = 0; i < directory.songs.size(); ++i)
   {
-    if (m_bStop) return i;
-    CSong &song = songsToAdd[i];
+    CSong &song = directory.songs[i];
+    CSong *dbSong = songsMap.Find(directory.files[i]);
+    if (dbSong)
+    { // keep the db-only fields intact on rescan...
+      song.iTimesPlayed = dbSong->iTimesPlayed;
+      song.lastPlayed = dbSong->lastPlayed;
+      if (song.rating == '0') song.rating = dbSong->rating;
+    }
     m_musicDatabase.AddSong(song, false);
     long iArtist = m_musicDatabase.GetArtistByName(song.strArtist);
     CFileItem item(song.strArtist,false);
@@ -486,8 +766,26 @@ int CMusicInfoScanner::RetrieveMusicInfo(CFileItemList& items, const CStdString&
       CPicture pic;
       pic.CacheImage(strFanart,item.GetCachedFanart());  
     }
-    if (!m_bStop && g_guiSettings.GetBool("musiclibrary.autoartistinfo"))
+  }
+
+  // save information about this folder
+  m_musicDatabase.SetPathHash(directory.strPath, directory.strHash);
+
+  if (directory.songs.size() && m_pObserver)
+    m_pObserver->OnDirectoryScanned(directory.strPath);
+
+  return directory.songs.size();
+}
+
+void CMusicInfoScanner::DownloadSongInfo(const VECSONGS &songs)
+{
+  for (unsigned int i = 0; i < songs.size(); ++i)
+  {
+    if (m_bStop) return;
+    const CSong &song = songs[i];
+    if (g_guiSettings.GetBool("musiclibrary.autoartistinfo"))
     {
+      long iArtist = m_musicDatabase.GetArtistByName(song.strArtist);
       CStdString strPath;
       strPath.Format("musicdb://2/%u/",iArtist);
       if (find(m_artistsScanned.begin(),m_artistsScanned.end(),iArtist) == m_artistsScanned.end())
@@ -513,7 +811,21 @@ int CMusicInfoScanner::RetrieveMusicInfo(CFileItemList& items, const CStdString&
         m_pObserver->OnStateChanged(READING_MUSIC_INFO);
     }
   }
-  return songsToAdd.size();
+}
+
+void CMusicInfoScanner::ClearScanQueues()
+{
+  CSingleLock lock(m_scanSection);
+  for (unsigned int i = 0; i < m_tagQueue.size(); i++)
+    delete m_tagQueue[i];
+  for (unsigned int i = 0; i < m_resultQueue.size(); i++)
+    delete m_resultQueue[i];
+  m_tagQueue.clear();
+  m_resultQueue.clear();
+  m_dirQueue.clear();
+  m_dirsQueued.clear();
+  m_pathsToScan.clear();
+  m_pathHashes.clear();
 }
 
 static bool SortSongsByTrack(CSong *song, CSong *song2)
@@ -20,14 +20,19 @@
  *
  */
 #include "utils/Thread.h"
+#include "utils/CriticalSection.h"
 #include "MusicDatabase.h"
 #include "MusicAlbumInfo.h"
 
+#include <deque>
+
 class CAlbum;
 class CArtist;
 
 namespace MUSIC_INFO
 {
+class CMusicScanDirectory;
+
 enum SCAN_STATE { PREPARING = 0, REMOVING_OLD, CLEANING_UP_DATABASE, READING_MUSIC_INFO, DOWNLOADING_ALBUM_INFO, DOWNLOADING_ARTIST_INFO, COMPRESSING_DATABASE, WRITING_CHANGES };
 
 class IMusicInfoScannerObserver
@@ -60,12 +65,34 @@ public:
   bool DownloadAlbumInfo(const CStdString& strPath, const CStdString& strArtist, const CStdString& strAlbum, bool& bCanceled, MUSIC_GRABBER::CMusicAlbumInfo& album, CGUIDialogProgress* pDialog=NULL);
   bool DownloadArtistInfo(const CStdString& strPath, const CStdString& strArtist, CGUIDialogProgress* pDialog=NULL);
 protected:
+  /*
+   * File scans run as a pipeline: a pool of walker threads lists the directories
+   * and queues the changed ones, a pool of reader threads loads their tags, and
+   * the scanner thread itself is the only one touching the database, writing the
+   * results in batched transactions. The observer is only called from the scanner thread.
+   */
+  class CScanWorker : public IRunnable
+  {
+  public:
+    CScanWorker(CMusicInfoScanner *scanner, bool readTags) : m_scanner(scanner), m_readTags(readTags) {}
+    virtual void Run();
+  private:
+    CMusicInfoScanner *m_scanner;
+    bool m_readTags;
+  };
+
   virtual void Process();
-  int RetrieveMusicInfo(CFileItemList& items, const CStdString& strDirectory);
   void UpdateFolderThumb(const VECSONGS &songs, const CStdString &folderPath);
   int GetPathHash(const CFileItemList &items, CStdString &hash);
 
-  bool DoScan(const CStdString& strDirectory);
+  bool DoScan();
+  void WalkDirectories();
+  void WalkDirectory(const CStdString& strDirectory);
+  void ReadTags();
+  void ReadDirectory(CMusicScanDirectory& directory);
+  int WriteDirectory(CMusicScanDirectory& directory);
+  void DownloadSongInfo(const VECSONGS &songs);
+  void ClearScanQueues();
 
   virtual void Run();
   int CountFiles(const CFileItemList& items, bool recursive);
@@ -87,5 +114,22 @@ protected:
   std::set<CStdString> m_pathsToCount;
   std::vector<long> m_artistsScanned;
   std::vector<long> m_albumsScanned;
+
+  // pipeline state, guarded by m_scanSection
+  CCriticalSection m_scanSection;
+  CEvent m_walkEvent;   // a directory was queued, or there's room in the tag or result queue
+  CEvent m_tagEvent;    // a directory is waiting for its tags, or there's room in the result queue
+  CEvent m_resultEvent; // a directory is ready to be written, or a worker finished
+  std::deque<CStdString> m_dirQueue;
+  std::set<CStdString> m_dirsQueued;
+  std::deque<CMusicScanDirectory*> m_tagQueue;
+  std::deque<CMusicScanDirectory*> m_resultQueue;
+  std::map<CStdString, CStdString> m_pathHashes;
+  unsigned int m_queueLimit;
+  int m_walkersBusy;
+  int m_walkersRunning;
+  int m_readersRunning;
+  CScanWorker m_walker;
+  CScanWorker m_tagReader;
 };
 }
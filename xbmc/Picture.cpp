@@ -25,6 +25,7 @@
 #include "Settings.h"
 #include "FileItem.h"
 #include "FileSystem/File.h"
+#include "utils/PixelConverter.h"
 
 using namespace XFILE;
 
@@ -80,19 +81,9 @@ SDL_Surface* CPicture::Load(const CStdString& strFileName, int iMaxWidth, int iM
       DWORD srcPitch = ((m_info.width + 1)* 3 / 4) * 4; 
       BYTE *pixels = (BYTE *)pTexture->pixels;
 #endif
-      for (unsigned int y = 0; y < m_info.height; y++)
-      {
-        BYTE *dst = pixels + y * destPitch;
-        BYTE *src = m_info.texture + (m_info.height - 1 - y) * srcPitch;
-        BYTE *alpha = m_info.alpha + (m_info.height - 1 - y) * m_info.width;
-        for (unsigned int x = 0; x < m_info.width; x++)
-        {
-          *dst++ = *src++;
-          *dst++ = *src++;
-          *dst++ = *src++;
-          *dst++ = (m_info.alpha) ? *alpha++ : 0xff;  // alpha
-        }
-      }
+      // CxImage rows are bottom up
+      CPixelConverter::BGRToBGRA(m_info.texture, srcPitch, m_info.alpha, m_info.width,
+                                 pixels, destPitch, m_info.width, m_info.height, true);
   
 #ifndef HAS_SDL
       pTexture->UnlockRect( 0 );
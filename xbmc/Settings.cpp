@@ -234,6 +234,8 @@ CSettings::CSettings(void)
   g_advancedSettings.m_songInfoDuration = 10;
   g_advancedSettings.m_busyDialogDelay = 2000;
   g_advancedSettings.m_logLevel = LOG_LEVEL_NORMAL;
+  g_advancedSettings.m_logRotateSize = 0;
+  g_advancedSettings.m_logBlockOnOverflow = false;
   g_advancedSettings.m_cddbAddress = "freedb.freedb.org";
   g_advancedSettings.m_usePCDVDROM = false;
   g_advancedSettings.m_noDVDROM = false;
@@ -264,6 +266,8 @@ CSettings::CSettings(void)
   g_advancedSettings.m_remoteRepeat = 480;
   g_advancedSettings.m_controllerDeadzone = 0.2f;
   g_advancedSettings.m_FTPShowCache = false;
+  g_advancedSettings.m_dirCacheMaxSize = 8192;
+  g_advancedSettings.m_dirCacheRemoteTTL = 300;
 
   g_advancedSettings.m_playlistAsFolders = true;
   g_advancedSettings.m_detectAsUdf = false;
@@ -284,6 +288,8 @@ CSettings::CSettings(void)
   g_advancedSettings.m_strMusicLibraryAlbumFormatRight = "";
   g_advancedSettings.m_prioritiseAPEv2tags = false;
   g_advancedSettings.m_musicItemSeparator = " / ";
+  g_advancedSettings.m_musicLibraryScanDirectoryThreads = 2;
+  g_advancedSettings.m_musicLibraryScanTagThreads = 4;
   g_advancedSettings.m_videoItemSeparator = " / ";
 
   g_advancedSettings.m_bVideoLibraryHideAllItems = false;
@@ -291,6 +297,9 @@ CSettings::CSettings(void)
   g_advancedSettings.m_bVideoLibraryHideRecentlyAddedItems = false;
   g_advancedSettings.m_bVideoLibraryHideEmptySeries = false;
   g_advancedSettings.m_bVideoLibraryCleanOnUpdate = false;
+  g_advancedSettings.m_videoLibraryScanScraperThreads = 4;
+  g_advancedSettings.m_videoLibraryScanThumbThreads = 2;
+  g_advancedSettings.m_videoLibraryScanBatchSize = 50;
 
   g_advancedSettings.m_bUseEvilB = true;
 
@@ -1250,6 +1259,8 @@ void CSettings::LoadAdvancedSettings()
     GetString(pElement, "albumformat", g_advancedSettings.m_strMusicLibraryAlbumFormat);
     GetString(pElement, "albumformatright", g_advancedSettings.m_strMusicLibraryAlbumFormatRight);
     GetString(pElement, "itemseparator", g_advancedSettings.m_musicItemSeparator);
+    GetInteger(pElement, "scandirectorythreads", g_advancedSettings.m_musicLibraryScanDirectoryThreads, 1, 16);
+    GetInteger(pElement, "scantagthreads", g_advancedSettings.m_musicLibraryScanTagThreads, 1, 16);
   }
 
   pElement = pRootElement->FirstChildElement("videolibrary");
@@ -1261,6 +1272,9 @@ void CSettings::LoadAdvancedSettings()
     XMLUtils::GetBoolean(pElement, "hideemptyseries", g_advancedSettings.m_bVideoLibraryHideEmptySeries);
     XMLUtils::GetBoolean(pElement, "cleanonupdate", g_advancedSettings.m_bVideoLibraryCleanOnUpdate);
     GetString(pElement, "itemseparator", g_advancedSettings.m_videoItemSeparator);
+    GetInteger(pElement, "scanscraperthreads", g_advancedSettings.m_videoLibraryScanScraperThreads, 1, 16);
+    GetInteger(pElement, "scanthumbthreads", g_advancedSettings.m_videoLibraryScanThumbThreads, 1, 16);
+    GetInteger(pElement, "scanbatchsize", g_advancedSettings.m_videoLibraryScanBatchSize, 1, 1000);
   }
 
   pElement = pRootElement->FirstChildElement("slideshow");
@@ -1308,6 +1322,8 @@ void CSettings::LoadAdvancedSettings()
       setting->SetAdvanced();
     }
   }
+  GetInteger(pRootElement, "logrotatesize", g_advancedSettings.m_logRotateSize, 0, 0, 1024 * 1024);
+  XMLUtils::GetBoolean(pRootElement, "logblockonoverflow", g_advancedSettings.m_logBlockOnOverflow);
   GetString(pRootElement, "cddbaddress", g_advancedSettings.m_cddbAddress);
 #ifdef HAS_HAL
   XMLUtils::GetBoolean(pRootElement, "usehalmount", g_advancedSettings.m_useHalMount);
@@ -1434,7 +1450,14 @@ void CSettings::LoadAdvancedSettings()
   g_advancedSettings.m_cachePath = CUtil::TranslateSpecialSource(g_advancedSettings.m_cachePath);
   CUtil::AddSlashAtEnd(g_advancedSettings.m_cachePath);
 
+  // scraper requests are answered from the files in here instead of the network, see CScraperUrl::Get()
+  GetString(pRootElement, "scraperfixtures", g_advancedSettings.m_scraperFixturePath);
+  if (!g_advancedSettings.m_scraperFixturePath.IsEmpty())
+    g_advancedSettings.m_scraperFixturePath = CUtil::TranslateSpecialSource(g_advancedSettings.m_scraperFixturePath);
+
   XMLUtils::GetBoolean(pRootElement, "ftpshowcache", g_advancedSettings.m_FTPShowCache);
+  GetInteger(pRootElement, "dircachesize", g_advancedSettings.m_dirCacheMaxSize, 256, INT_MAX / 1024);
+  GetInteger(pRootElement, "dircacheremotettl", g_advancedSettings.m_dirCacheRemoteTTL, 0, 86400);
 
   g_LangCodeExpander.LoadUserCodes(pRootElement->FirstChildElement("languagecodes"));
   // stacking regexps
@@ -185,11 +185,14 @@ public:
     int m_songInfoDuration;
     int m_busyDialogDelay;
     int m_logLevel;
+    int m_logRotateSize;        // KB, xbmc.log is moved to xbmc.old.log when it gets bigger, 0 never
+    bool m_logBlockOnOverflow;  // wait for the log writer instead of dropping messages
     CStdString m_cddbAddress;
     bool m_usePCDVDROM;
     bool m_noDVDROM;
     bool m_enableOpticalMedia;
     CStdString m_cachePath;
+    CStdString m_scraperFixturePath;
     bool m_displayRemoteCodes;
     CStdStringArray m_videoStackRegExps;
     CStdStringArray m_tvshowStackRegExps;
@@ -198,6 +201,8 @@ public:
     int m_remoteRepeat;
     float m_controllerDeadzone;
     bool m_FTPShowCache;
+    int m_dirCacheMaxSize;      // KB of directory listings kept in memory
+    int m_dirCacheRemoteTTL;    // seconds before cached remote listings are refetched, 0 to keep them
 
     bool m_playlistAsFolders;
     bool m_detectAsUdf;
@@ -216,6 +221,8 @@ public:
     CStdString m_strMusicLibraryAlbumFormatRight;
     bool m_prioritiseAPEv2tags;
     CStdString m_musicItemSeparator;
+    int m_musicLibraryScanDirectoryThreads;
+    int m_musicLibraryScanTagThreads;
     CStdString m_videoItemSeparator;
     std::vector<CStdString> m_musicTagsFromFileFilters;
 
@@ -224,6 +231,9 @@ public:
     bool m_bVideoLibraryHideRecentlyAddedItems;
     bool m_bVideoLibraryHideEmptySeries;
     bool m_bVideoLibraryCleanOnUpdate;
+    int m_videoLibraryScanScraperThreads;
+    int m_videoLibraryScanThumbThreads;
+    int m_videoLibraryScanBatchSize;
     bool m_sambastatfiles;
     bool m_bUseEvilB;
     std::vector<CStdString> m_vecTokens; // cleaning strings tied to language
@@ -89,6 +89,44 @@ bool SSortFileItem::IgnoreFoldersDescending(const CFileItemPtr &left, const CFil
   return StringUtils::AlphaNumericCompare(left->GetSortLabel().c_str(),right->GetSortLabel().c_str()) > 0;
 }
 
+void SSortFileItem::AppendSortKey(const CStdString &label, std::string &key)
+{
+  // letters are folded to lower case. a run of digits is read the way AlphaNumericCompare() does,
+  // in numbers of at most 15 digits, and each number becomes its count of significant digits
+  // followed by those digits. the count byte stays within '0'..'9' (counts above 8 take a second
+  // byte), so a number still orders against any other character exactly as its first digit would.
+  const unsigned char *p = (const unsigned char *)label.c_str();
+  while (*p)
+  {
+    if (*p >= '0' && *p <= '9')
+    {
+      const unsigned char *start = p;
+      while (*p >= '0' && *p <= '9' && p < start + 15)
+        p++;
+
+      const unsigned char *digits = start;
+      while (digits < p && *digits == '0')
+        digits++;
+
+      int count = p - digits;
+      if (count < 9)
+        key += (char)('0' + count);
+      else
+      {
+        key += '9';
+        key += (char)('0' + count - 9);
+      }
+      key.append((const char *)digits, count);
+      continue;
+    }
+
+    unsigned char c = *p++;
+    if (c >= 'A' && c <= 'Z')
+      c += 'a' - 'A';
+    key += (char)c;
+  }
+}
+
 void SSortFileItem::ByLabel(CFileItemPtr &item)
 {
   if (!item) return;
@@ -33,6 +33,10 @@ struct SSortFileItem
   static bool IgnoreFoldersAscending(const CFileItemPtr &left, const CFileItemPtr &right);
   static bool IgnoreFoldersDescending(const CFileItemPtr &left, const CFileItemPtr &right);
 
+  // Appends the collation key of a sort label to key. memcmp() of two keys orders
+  // the same as StringUtils::AlphaNumericCompare() of their labels.
+  static void AppendSortKey(const CStdString &label, std::string &key);
+
   // Fill in sort field
   static void ByLabel(CFileItemPtr &item);
   static void ByLabelNoThe(CFileItemPtr &item);
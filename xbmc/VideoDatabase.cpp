@@ -319,10 +319,10 @@ long CVideoDatabase::GetPathId(const CStdString& strPath)
 
     CUtil::AddSlashAtEnd(strPath1);
 
-    strSQL=FormatSQL("select idPath from path where strPath like '%s'",strPath1.c_str());
-    m_pDS->query(strSQL.c_str());
+    strSQL = "select idPath from path where strPath like ?";
+    m_pDS->query(strSQL.c_str(), sql_record(1, field_value(strPath1.c_str())));
     if (!m_pDS->eof())
-      lPathId = m_pDS->fv("path.idPath").get_asLong();
+      lPathId = m_pDS->fv(0).get_asLong();
 
     m_pDS->close();
     return lPathId;
@@ -649,12 +649,13 @@ long CVideoDatabase::GetFileId(const CStdString& strFilenameAndPath)
     if (lPathId < 0)
       return -1;
 
-    CStdString strSQL;
-    strSQL=FormatSQL("select idFile from files where strFileName like '%s' and idPath=%u", strFileName.c_str(),lPathId);
-    m_pDS->query(strSQL.c_str());
+    sql_record params;
+    params.push_back(field_value(strFileName.c_str()));
+    params.push_back(field_value(lPathId));
+    m_pDS->query("select idFile from files where strFileName like ? and idPath=?", params);
     if (m_pDS->num_rows() > 0)
     {
-      long lFileId = m_pDS->fv("files.idFile").get_asLong();
+      long lFileId = m_pDS->fv(0).get_asLong();
       m_pDS->close();
       return lFileId;
     }
@@ -2364,14 +2365,15 @@ CVideoInfoTag CVideoDatabase::GetDetailsForMovie(auto_ptr<Dataset> &pDS, bool ne
   if (needsCast)
   {
     // create cast string
-    CStdString strSQL = FormatSQL("select  actors.strActor,actorlinkmovie.strRole,actors.strThumb from  actorlinkmovie,actors where actorlinkmovie.idMovie=%u and actorlinkmovie.idActor  = actors.idActor order by actorlinkmovie.ROWID",lMovieId);
-    m_pDS2->query(strSQL.c_str());
+    // the same statement is used for every item, only the id is bound
+    m_pDS2->query("select actors.strActor,actorlinkmovie.strRole,actors.strThumb from actorlinkmovie,actors where actorlinkmovie.idMovie=? and actorlinkmovie.idActor = actors.idActor order by actorlinkmovie.ROWID",
+                  sql_record(1, field_value(lMovieId)));
     while (!m_pDS2->eof())
     {
       SActorInfo info;
-      info.strName = m_pDS2->fv("actors.strActor").get_asString();
-      info.strRole = m_pDS2->fv("actorlinkmovie.strRole").get_asString();
-      info.thumbUrl.ParseString(m_pDS2->fv("actors.strThumb").get_asString());
+      info.strName = m_pDS2->fv(0).get_asString();
+      info.strRole = m_pDS2->fv(1).get_asString();
+      info.thumbUrl.ParseString(m_pDS2->fv(2).get_asString());
       details.m_cast.push_back(info);
       m_pDS2->next();
     }
@@ -2401,14 +2403,15 @@ CVideoInfoTag CVideoDatabase::GetDetailsForTvShow(auto_ptr<Dataset> &pDS, bool n
   if (needsCast)
   {
     // create cast string
-    CStdString strSQL = FormatSQL("select actors.strActor,actorlinktvshow.strRole,actors.strThumb from actorlinktvshow,actors where actorlinktvshow.idShow=%u and actorlinktvshow.idActor = actors.idActor",lTvShowId);
-    m_pDS2->query(strSQL.c_str());
+    // the same statement is used for every item, only the id is bound
+    m_pDS2->query("select actors.strActor,actorlinktvshow.strRole,actors.strThumb from actorlinktvshow,actors where actorlinktvshow.idShow=? and actorlinktvshow.idActor = actors.idActor",
+                  sql_record(1, field_value(lTvShowId)));
     while (!m_pDS2->eof())
     {
       SActorInfo info;
-      info.strName = m_pDS2->fv("actors.strActor").get_asString();
-      info.strRole = m_pDS2->fv("actorlinktvshow.strRole").get_asString();
-      info.thumbUrl.ParseString(m_pDS2->fv("actors.strThumb").get_asString());
+      info.strName = m_pDS2->fv(0).get_asString();
+      info.strRole = m_pDS2->fv(1).get_asString();
+      info.thumbUrl.ParseString(m_pDS2->fv(2).get_asString());
       details.m_cast.push_back(info);
       m_pDS2->next();
     }
@@ -2440,14 +2443,15 @@ CVideoInfoTag CVideoDatabase::GetDetailsForEpisode(auto_ptr<Dataset> &pDS, bool
   if (needsCast)
   {
     // create cast string
-    CStdString strSQL = FormatSQL("select actors.strActor,actorlinkepisode.strRole,actors.strThumb from actorlinkepisode,actors where actorlinkepisode.idEpisode=%u and actorlinkepisode.idActor = actors.idActor",lEpisodeId);
-    m_pDS2->query(strSQL.c_str());
+    // the same statement is used for every item, only the id is bound
+    m_pDS2->query("select actors.strActor,actorlinkepisode.strRole,actors.strThumb from actorlinkepisode,actors where actorlinkepisode.idEpisode=? and actorlinkepisode.idActor = actors.idActor",
+                  sql_record(1, field_value(lEpisodeId)));
     while (!m_pDS2->eof())
     {
       SActorInfo info;
-      info.strName = m_pDS2->fv("actors.strActor").get_asString();
-      info.strRole = m_pDS2->fv("actorlinkepisode.strRole").get_asString();
-      info.thumbUrl.ParseString(m_pDS2->fv("actors.strThumb").get_asString());
+      info.strName = m_pDS2->fv(0).get_asString();
+      info.strRole = m_pDS2->fv(1).get_asString();
+      info.thumbUrl.ParseString(m_pDS2->fv(2).get_asString());
       details.m_cast.push_back(info);      
       m_pDS2->next();
     }
@@ -3292,7 +3296,7 @@ bool CVideoDatabase::GetGenresNav(const CStdString& strBaseDir, CFileItemList& i
 
     // run query
     CLog::Log(LOGDEBUG, "%s query: %s", __FUNCTION__, strSQL.c_str());
-    if (!m_pDS->query(strSQL.c_str())) return false;
+    if (!m_pDS->query_forward(strSQL.c_str())) return false;
     int iRowsFound = m_pDS->num_rows();
     if (iRowsFound == 0)
     {
@@ -3306,15 +3310,15 @@ bool CVideoDatabase::GetGenresNav(const CStdString& strBaseDir, CFileItemList& i
       map<long, pair<CStdString,int> >::iterator it;
       while (!m_pDS->eof())
       {
-        long lGenreId = m_pDS->fv("genre.idgenre").get_asLong();
-        CStdString strGenre = m_pDS->fv("genre.strgenre").get_asString();
+        long lGenreId = m_pDS->fv(0).get_asLong();
+        CStdString strGenre = m_pDS->fv(1).get_asString();
         it = mapGenres.find(lGenreId);
         // was this genre already found?
         if (it == mapGenres.end())
         {
           // check path
           CStdString strPath;
-          if (g_passwordManager.IsDatabasePathUnlocked(CStdString(m_pDS->fv("path.strPath").get_asString()),g_settings.m_videoSources))
+          if (g_passwordManager.IsDatabasePathUnlocked(CStdString(m_pDS->fv(2).get_asString()),g_settings.m_videoSources))
             if (idContent == VIDEODB_CONTENT_MOVIES || idContent == VIDEODB_CONTENT_MUSICVIDEOS)
               mapGenres.insert(pair<long, pair<CStdString,int> >(lGenreId, pair<CStdString,int>(strGenre,m_pDS->fv(3).get_asInteger())));
             else
@@ -3344,9 +3348,9 @@ bool CVideoDatabase::GetGenresNav(const CStdString& strBaseDir, CFileItemList& i
     {
       while (!m_pDS->eof())
       {
-        CFileItemPtr pItem(new CFileItem(m_pDS->fv("genre.strgenre").get_asString()));
+        CFileItemPtr pItem(new CFileItem(m_pDS->fv(1).get_asString()));
         CStdString strDir;
-        strDir.Format("%ld/", m_pDS->fv("genre.idgenre").get_asLong());
+        strDir.Format("%ld/", m_pDS->fv(0).get_asLong());
         pItem->m_strPath=strBaseDir + strDir;
         pItem->m_bIsFolder=true;
         pItem->SetLabelPreformated(true);
@@ -3998,9 +4002,9 @@ bool CVideoDatabase::GetMoviesByWhere(const CStdString& strBaseDir, const CStdSt
 
     CStdString strSQL = "select * from movieview " + where;
 
-    // run query
+    // run query, the rows are read as the items are built
     CLog::Log(LOGDEBUG, "%s query: %s", __FUNCTION__, strSQL.c_str());
-    if (!m_pDS->query(strSQL.c_str())) return false;
+    if (!m_pDS->query_forward(strSQL.c_str())) return false;
     int iRowsFound = m_pDS->num_rows();
     if (iRowsFound == 0)
     {
@@ -4012,10 +4016,9 @@ bool CVideoDatabase::GetMoviesByWhere(const CStdString& strBaseDir, const CStdSt
               timeGetTime() - time); time = timeGetTime();
 
     // get data from returned rows
-    items.Reserve(iRowsFound);
     while (!m_pDS->eof())
     {
-      long lMovieId = m_pDS->fv("idMovie").get_asLong();
+      long lMovieId = m_pDS->fv(0).get_asLong();
       CVideoInfoTag movie = GetDetailsForMovie(m_pDS);
       if (g_settings.m_vecProfiles[0].getLockMode() == LOCK_MODE_EVERYONE || 
           g_passwordManager.bMasterUser                                   ||
@@ -4227,9 +4230,9 @@ bool CVideoDatabase::GetEpisodesByWhere(const CStdString& strBaseDir, const CStd
 
     CStdString strSQL = "select * from episodeview " + where;
 
-    // run query
+    // run query, the rows are read as the items are built
     CLog::Log(LOGDEBUG, "%s query: %s", __FUNCTION__, strSQL.c_str());
-    if (!m_pDS->query(strSQL.c_str())) return false;
+    if (!m_pDS->query_forward(strSQL.c_str())) return false;
     int iRowsFound = m_pDS->num_rows();
     if (iRowsFound == 0)
     {
@@ -4241,11 +4244,11 @@ bool CVideoDatabase::GetEpisodesByWhere(const CStdString& strBaseDir, const CStd
               timeGetTime() - time); time = timeGetTime();
 
     // get data from returned rows
-    items.Reserve(iRowsFound);
+    int showColumn = m_pDS->fieldIndex("idShow");
     while (!m_pDS->eof())
     {
-      long lEpisodeId = m_pDS->fv("idEpisode").get_asLong();
-      long lShowId = m_pDS->fv("idShow").get_asLong();
+      long lEpisodeId = m_pDS->fv(0).get_asLong();
+      long lShowId = m_pDS->fv(showColumn).get_asLong();
 
       CVideoInfoTag movie = GetDetailsForEpisode(m_pDS);
       CFileItemPtr pItem(new CFileItem(movie));
@@ -39,14 +39,51 @@
 
 #define REGEXSAMPLEFILE "[-\\._ ](sample|trailer)[-\\._ ]"
 
+// items in flight per scraper/thumb thread before the scanner thread waits
+#define SCAN_QUEUE_PER_THREAD 4
+
 using namespace std;
 using namespace DIRECTORY;
 using namespace XFILE;
 
 namespace VIDEO 
 {
+  // an item on its way from the scanner thread through the scrapers and thumb fetchers to the database
+  class CVideoScanJob
+  {
+  public:
+    CVideoScanJob(const CFileItem& item, const SScraperInfo& info, const CStdString& content)
+      : item(item), info(info), strContent(content)
+    {
+      bGrabAny = false;
+      bApplyToDir = false;
+      bHasUrl = false;
+      bFound = false;
+      idShow = -1;
+      iSeason = -1;
+      iEpisode = -1;
+    }
+
+    CFileItem item;
+    SScraperInfo info;
+    CStdString strContent;
+    CStdString strMovieName; // movies and music videos: searched for if there's no nfo
+    bool bGrabAny;           // passed on to GetnfoFile()
+    bool bApplyToDir;        // copy the thumb to the folder as well
+    CScraperUrl url;         // episodes: the episode guide entry
+    bool bHasUrl;
+    long idShow;
+    int iSeason;
+    int iEpisode;
+    CStdString strShowTitle;
+    CStdString strHashPath;  // directory whose path hash waits for this job
+
+    CVideoInfoTag details;
+    bool bFound;
+  };
 
   CVideoInfoScanner::CVideoInfoScanner()
+    : m_scraper(this, false), m_thumbFetcher(this, true)
   {
     m_bRunning = false;
     m_pObserver = NULL;
@@ -54,6 +91,11 @@ namespace VIDEO
     m_currentItem=0;
     m_itemCount=0;
     m_bClean=false;
+    m_jobsPending=0;
+    m_queueLimit=0;
+    m_itemsInTransaction=0;
+    m_bPipeline=false;
+    m_bStopWorkers=false;
   }
 
   CVideoInfoScanner::~CVideoInfoScanner()
@@ -90,6 +132,8 @@ namespace VIDEO
       // result in unexpected behaviour.
       m_bCanInterrupt = false;
 
+      StartPipeline();
+
       bool bCancelled = false;
       for(std::map<CStdString,VIDEO::SScanSettings>::iterator it = m_pathsToScan.begin(); it != m_pathsToScan.end(); it++)
       {
@@ -100,6 +144,9 @@ namespace VIDEO
         }
       }
 
+      // write out whatever is still in the pipeline
+      StopPipeline(!bCancelled);
+
       if (!bCancelled)
       {
         if (m_bClean)
@@ -316,10 +363,20 @@ namespace VIDEO
 
     if (!bSkip)
     {
+      bool bStoreHash = m_info.strContent.Equals("movies") || m_info.strContent.Equals("musicvideos");
+      if (bStoreHash && m_bPipeline)
+      { // held until the queueing is done, the last written job stores the hash
+        m_pendingHashes[strDirectory] = make_pair(hash, 1);
+        m_strHashPath = strDirectory;
+      }
       RetrieveVideoInfo(items,settings.parent_name_root,m_info);
-      if (!m_bStop && (m_info.strContent.Equals("movies") || m_info.strContent.Equals("musicvideos")))
+      m_strHashPath.Empty();
+      if (!m_bStop && bStoreHash)
       {
-        m_database.SetPathHash(strDirectory, hash);
+        if (m_bPipeline)
+          ReleasePathHash(strDirectory);
+        else
+          m_database.SetPathHash(strDirectory, hash);
         m_pathsToClean.push_back(m_database.GetPathId(strDirectory));
       }
     }
@@ -567,6 +624,16 @@ namespace VIDEO
           {
             if (!m_database.HasMovieInfo(pItem->m_strPath))
             {
+              if (m_bPipeline)
+              { // the scrapers take it from here
+                CVideoScanJob *job = new CVideoScanJob(*pItem, info2, info.strContent);
+                job->strMovieName = strMovieName;
+                job->bGrabAny = bDirNames;
+                job->bApplyToDir = bDirNames;
+                QueueJob(job);
+                continue;
+              }
+
               // handle .nfo files
               CScraperUrl scrUrl;
               NFOResult result = CheckForNFOFile(pItem.get(),bDirNames,info2,pDlgProgress,scrUrl);
@@ -580,6 +647,14 @@ namespace VIDEO
           {
             if (!m_database.HasMusicVideoInfo(pItem->m_strPath))
             {
+              if (m_bPipeline)
+              { // the scrapers take it from here
+                CVideoScanJob *job = new CVideoScanJob(*pItem, info2, info.strContent);
+                job->strMovieName = strMovieName;
+                QueueJob(job);
+                continue;
+              }
+
               CScraperUrl scrUrl;
               NFOResult result = CheckForNFOFile(pItem.get(),false,info2,pDlgProgress,scrUrl);
               if (result == FULL_NFO || result == URL_NFO)
@@ -847,15 +922,17 @@ namespace VIDEO
   }
 
   long CVideoInfoScanner::AddMovieAndGetThumb(CFileItem *pItem, const CStdString &content, CVideoInfoTag &movieDetails, long idShow, bool bApplyToDir /*=false*/, CGUIDialogProgress* pDialog /* = NULL */)
+  {
+    FetchArtwork(pItem, content, movieDetails, bApplyToDir, pDialog);
+    return AddToDatabase(pItem, content, movieDetails, idShow);
+  }
+
+  long CVideoInfoScanner::AddToDatabase(CFileItem *pItem, const CStdString &content, CVideoInfoTag &movieDetails, long idShow)
   {
     long lResult=-1;
     // add to all movies in the stacked set
     if (content.Equals("movies"))
     {
-      // find local trailer first
-      CStdString strTrailer = pItem->FindTrailer();
-      if (!strTrailer.IsEmpty())
-        movieDetails.m_strTrailer = strTrailer;
       m_database.SetDetailsForMovie(pItem->m_strPath, movieDetails);
     }
     else if (content.Equals("tvshows"))
@@ -876,6 +953,20 @@ namespace VIDEO
     {
       m_database.SetDetailsForMusicVideo(pItem->m_strPath, movieDetails);
     }
+    return lResult;
+  }
+
+  // everything here is file or network access, none of it touches the database
+  void CVideoInfoScanner::FetchArtwork(CFileItem *pItem, const CStdString &content, CVideoInfoTag &movieDetails, bool bApplyToDir, CGUIDialogProgress* pDialog)
+  {
+    if (content.Equals("movies"))
+    {
+      // find local trailer first
+      CStdString strTrailer = pItem->FindTrailer();
+      if (!strTrailer.IsEmpty())
+        movieDetails.m_strTrailer = strTrailer;
+    }
+
     pItem->CacheFanart();
     // get & save fanart image
     if (!CFile::Exists(pItem->GetCachedFanart()))
@@ -940,7 +1031,6 @@ namespace VIDEO
 
     if (g_guiSettings.GetBool("videolibrary.actorthumbs"))
       FetchActorThumbs(movieDetails.m_cast);
-    return lResult;
   }
 
   void CVideoInfoScanner::OnProcessSeriesFolder(IMDB_EPISODELIST& episodes, IMDB_EPISODELIST& files, long lShowId, CIMDB& IMDB, const CStdString& strShowTitle, CGUIDialogProgress* pDlgProgress /* = NULL */)
@@ -989,6 +1079,23 @@ namespace VIDEO
       CFileItem item;
       item.m_strPath = iter->second.m_url[0].m_url;
 
+      if (m_bPipeline)
+      { // the scrapers take it from here
+        CVideoScanJob *job = new CVideoScanJob(item, IMDB.GetScraperInfo(), "tvshows");
+        job->idShow = lShowId;
+        job->strShowTitle = strShowTitle;
+        IMDB_EPISODELIST::iterator iter2 = episodes.find(iter->first);
+        if (iter2 != episodes.end())
+        {
+          job->url = iter2->second;
+          job->bHasUrl = true;
+          job->iSeason = iter2->first.first;
+          job->iEpisode = iter2->first.second;
+        }
+        QueueJob(job);
+        continue;
+      }
+
       // handle .nfo files
       CStdString strNfoFile = GetnfoFile(&item,false);
       if (!strNfoFile.IsEmpty())
@@ -1026,7 +1133,12 @@ namespace VIDEO
       }
     }
     if (g_guiSettings.GetBool("videolibrary.seasonthumbs"))
-      FetchSeasonThumbs(lShowId);
+    {
+      if (m_bPipeline)
+        m_seasonThumbShows.insert(lShowId); // once the episodes are in the database
+      else
+        FetchSeasonThumbs(lShowId);
+    }
     m_database.Close();
   }
 
@@ -1290,5 +1402,315 @@ namespace VIDEO
 
     return NO_NFO;
   }
+
+  void CVideoInfoScanner::CScanWorker::Run()
+  {
+    if (m_fetchThumbs)
+      m_scanner->FetchThumbs();
+    else
+      m_scanner->ScrapeItems();
+  }
+
+  void CVideoInfoScanner::StartPipeline()
+  {
+    int scrapers = g_advancedSettings.m_videoLibraryScanScraperThreads;
+    int thumbFetchers = g_advancedSettings.m_videoLibraryScanThumbThreads;
+
+    m_queueLimit = (scrapers + thumbFetchers) * SCAN_QUEUE_PER_THREAD;
+    m_jobsPending = 0;
+    m_itemsInTransaction = 0;
+    m_seasonThumbShows.clear();
+    m_pendingHashes.clear();
+    m_bStopWorkers = false;
+
+    for (int i = 0; i < scrapers + thumbFetchers; i++)
+    {
+      CThread *worker = new CThread(i < scrapers ? (IRunnable*)&m_scraper : (IRunnable*)&m_thumbFetcher);
+      worker->Create();
+      worker->SetPriority(THREAD_PRIORITY_IDLE);
+      m_workers.push_back(worker);
+    }
+    m_bPipeline = true;
+    CLog::Log(LOGDEBUG, "%s - scanning with %i scraper and %i thumb threads", __FUNCTION__, scrapers, thumbFetchers);
+  }
+
+  void CVideoInfoScanner::StopPipeline(bool bFlush)
+  {
+    if (bFlush)
+      WriteResults(true);
+    CommitBatch();
+
+    m_bStopWorkers = true;
+    for (unsigned int i = 0; i < m_workers.size(); i++)
+    {
+      m_workers[i]->StopThread();
+      delete m_workers[i];
+    }
+    m_workers.clear();
+    m_bPipeline = false;
+
+    {
+      CSingleLock lock(m_scanSection);
+      for (unsigned int i = 0; i < m_scrapeQueue.size(); i++)
+        delete m_scrapeQueue[i];
+      for (unsigned int i = 0; i < m_thumbQueue.size(); i++)
+        delete m_thumbQueue[i];
+      for (unsigned int i = 0; i < m_resultQueue.size(); i++)
+        delete m_resultQueue[i];
+      m_scrapeQueue.clear();
+      m_thumbQueue.clear();
+      m_resultQueue.clear();
+      m_jobsPending = 0;
+    }
+    // directories with dropped jobs keep their old hash, so they are scanned again next time
+    m_pendingHashes.clear();
+
+    // the season thumbs are looked up from the episodes, so these wait until they're all written
+    for (set<long>::iterator it = m_seasonThumbShows.begin(); bFlush && it != m_seasonThumbShows.end() && !m_bStop; ++it)
+      FetchSeasonThumbs(*it);
+    m_seasonThumbShows.clear();
+  }
+
+  void CVideoInfoScanner::QueueJob(CVideoScanJob *job)
+  {
+    if (!m_strHashPath.IsEmpty())
+    {
+      job->strHashPath = m_strHashPath;
+      m_pendingHashes[m_strHashPath].second++;
+    }
+
+    while (!m_bStop)
+    {
+      {
+        CSingleLock lock(m_scanSection);
+        if (m_jobsPending < m_queueLimit)
+        {
+          m_jobsPending++;
+          m_scrapeQueue.push_back(job);
+          job = NULL;
+          break;
+        }
+      }
+      // the workers are behind - write out what they have finished meanwhile
+      WriteResults(false);
+      m_resultEvent.WaitMSec(50);
+    }
+
+    if (job)
+      delete job; // cancelled
+    else
+    {
+      m_scrapeEvent.Set();
+      WriteResults(false);
+    }
+  }
+
+  void CVideoInfoScanner::WriteResults(bool bFlush)
+  {
+    while (!m_bStop)
+    {
+      CVideoScanJob *job = NULL;
+      {
+        CSingleLock lock(m_scanSection);
+        if (!m_resultQueue.empty())
+        {
+          job = m_resultQueue.front();
+          m_resultQueue.pop_front();
+        }
+        else if (!bFlush || m_jobsPending == 0)
+          break;
+      }
+
+      if (!job)
+      {
+        m_resultEvent.WaitMSec(100);
+        continue;
+      }
+
+      if (job->bFound)
+      {
+        if (m_pObserver)
+        {
+          if (job->strContent.Equals("tvshows"))
+          {
+            CStdString strTitle;
+            strTitle.Format("%s - %ix%i - %s",job->strShowTitle.c_str(),job->details.m_iSeason,job->details.m_iEpisode,job->details.m_strTitle.c_str());
+            m_pObserver->OnSetTitle(strTitle);
+          }
+          else
+            m_pObserver->OnSetTitle(job->details.m_strTitle);
+        }
+
+        if (m_itemsInTransaction++ == 0)
+          m_database.BeginTransaction();
+        AddToDatabase(&job->item, job->strContent, job->details, job->idShow);
+        if (m_itemsInTransaction >= g_advancedSettings.m_videoLibraryScanBatchSize)
+          CommitBatch();
+      }
+      else
+        CLog::Log(LOGDEBUG, "%s - no details found for %s", __FUNCTION__, job->item.m_strPath.c_str());
+
+      if (!job->strHashPath.IsEmpty())
+        ReleasePathHash(job->strHashPath);
+      delete job;
+      {
+        CSingleLock lock(m_scanSection);
+        m_jobsPending--;
+      }
+    }
+  }
+
+  void CVideoInfoScanner::ReleasePathHash(const CStdString &strDirectory)
+  {
+    map<CStdString, pair<CStdString, int> >::iterator it = m_pendingHashes.find(strDirectory);
+    if (it == m_pendingHashes.end())
+      return;
+
+    if (--it->second.second == 0)
+    {
+      m_database.SetPathHash(it->first, it->second.first);
+      m_pendingHashes.erase(it);
+    }
+  }
+
+  void CVideoInfoScanner::CommitBatch()
+  {
+    if (m_itemsInTransaction > 0)
+    {
+      m_database.CommitTransaction();
+      m_itemsInTransaction = 0;
+    }
+  }
+
+  // This function is run by the scraper threads
+  void CVideoInfoScanner::ScrapeItems()
+  {
+    while (!m_bStop && !m_bStopWorkers)
+    {
+      CVideoScanJob *job = NULL;
+      {
+        CSingleLock lock(m_scanSection);
+        if (!m_scrapeQueue.empty())
+        {
+          job = m_scrapeQueue.front();
+          m_scrapeQueue.pop_front();
+        }
+      }
+
+      if (!job)
+      {
+        m_scrapeEvent.WaitMSec(50);
+        continue;
+      }
+
+      ScrapeItem(*job);
+
+      // nothing to fetch artwork for if the lookup failed, the writer just drops it
+      {
+        CSingleLock lock(m_scanSection);
+        if (job->bFound)
+          m_thumbQueue.push_back(job);
+        else
+          m_resultQueue.push_back(job);
+      }
+      if (job->bFound)
+        m_thumbEvent.Set();
+      else
+        m_resultEvent.Set();
+    }
+  }
+
+  void CVideoInfoScanner::ScrapeItem(CVideoScanJob &job)
+  {
+    // handle .nfo files
+    CScraperUrl url;
+    bool bHaveUrl = false;
+    CStdString strNfoFile = GetnfoFile(&job.item, job.bGrabAny);
+    if (!strNfoFile.IsEmpty() && CFile::Exists(strNfoFile))
+    {
+      CLog::Log(LOGDEBUG,"Found matching nfo file: %s", strNfoFile.c_str());
+      CNfoFile nfoReader(job.strContent);
+      if (nfoReader.Create(strNfoFile) == S_OK)
+      {
+        if (nfoReader.m_strScraper == "NFO")
+        {
+          CLog::Log(LOGDEBUG, "%s Got details from nfo", __FUNCTION__);
+          nfoReader.GetDetails(job.details);
+          job.bFound = true;
+          return;
+        }
+        if (!job.strContent.Equals("tvshows")) // episodes only take full nfo's
+        {
+          url = CScraperUrl(nfoReader.m_strImDbUrl);
+          url.strId = nfoReader.m_strImDbNr;
+          job.info.strPath = nfoReader.m_strScraper;
+          bHaveUrl = true;
+          CLog::Log(LOGDEBUG,"-- nfo-scraper: %s", nfoReader.m_strScraper.c_str());
+        }
+      }
+    }
+
+    if (m_bStop)
+      return;
+
+    CIMDB IMDB;
+    IMDB.SetScraperInfo(job.info);
+    if (job.strContent.Equals("tvshows"))
+    {
+      if (job.bHasUrl)
+      {
+        if (IMDB.GetEpisodeDetails(job.url, job.details))
+        {
+          job.details.m_iSeason = job.iSeason;
+          job.details.m_iEpisode = job.iEpisode;
+          job.bFound = true;
+        }
+        else
+          CLog::Log(LOGERROR, "%s - failed to get details for episode %ix%i of %s, skipping it", __FUNCTION__, job.iSeason, job.iEpisode, job.strShowTitle.c_str());
+      }
+      return;
+    }
+
+    if (!bHaveUrl)
+    {
+      IMDB_MOVIELIST movielist;
+      if (!IMDB.FindMovie(job.strMovieName, movielist) || movielist.empty())
+        return;
+      url = movielist[0];
+    }
+    job.details.m_strFileNameAndPath = job.item.m_strPath;
+    job.bFound = IMDB.GetDetails(url, job.details);
+  }
+
+  // This function is run by the thumb threads
+  void CVideoInfoScanner::FetchThumbs()
+  {
+    while (!m_bStop && !m_bStopWorkers)
+    {
+      CVideoScanJob *job = NULL;
+      {
+        CSingleLock lock(m_scanSection);
+        if (!m_thumbQueue.empty())
+        {
+          job = m_thumbQueue.front();
+          m_thumbQueue.pop_front();
+        }
+      }
+
+      if (!job)
+      {
+        m_thumbEvent.WaitMSec(50);
+        continue;
+      }
+
+      FetchArtwork(&job->item, job->strContent, job->details, job->bApplyToDir, NULL);
+
+      {
+        CSingleLock lock(m_scanSection);
+        m_resultQueue.push_back(job);
+      }
+      m_resultEvent.Set();
+    }
+  }
 }
 
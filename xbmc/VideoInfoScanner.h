@@ -20,14 +20,19 @@
  *
  */
 #include "utils/Thread.h"
+#include "utils/CriticalSection.h"
 #include "VideoDatabase.h"
 #include "ScraperSettings.h"
 #include "NfoFile.h"
 
+#include <deque>
+
 class CIMDB;
 
 namespace VIDEO
 {
+  class CVideoScanJob;
+
   typedef struct SScanSettings
   {
     bool parent_name;       /* use the parent dirname as name of lookup */
@@ -75,9 +80,40 @@ namespace VIDEO
     };
     NFOResult CheckForNFOFile(CFileItem* pItem, bool bGrabAny, SScraperInfo& info, CGUIDialogProgress* pDlgProgress, CScraperUrl& scrUrl);
   protected:
+    /*
+     * While the library is being scanned, movies, music videos and episodes are looked up
+     * in a pipeline: the scanner thread lists and hashes the folders and queues the items
+     * that need looking up, a pool of scraper threads handles the nfo files and online
+     * lookups, a pool of thumb threads fetches the artwork and the scanner thread writes
+     * the results, committing every m_videoLibraryScanBatchSize items.
+     * Refreshes from the info dialog don't go through the pipeline.
+     */
+    class CScanWorker : public IRunnable
+    {
+    public:
+      CScanWorker(CVideoInfoScanner *scanner, bool fetchThumbs) : m_scanner(scanner), m_fetchThumbs(fetchThumbs) {}
+      virtual void Run();
+    private:
+      CVideoInfoScanner *m_scanner;
+      bool m_fetchThumbs;
+    };
+
     virtual void Process();
     bool DoScan(const CStdString& strDirectory, SScanSettings settings);
 
+    long AddToDatabase(CFileItem *pItem, const CStdString &content, CVideoInfoTag &movieDetails, long idShow);
+    void FetchArtwork(CFileItem *pItem, const CStdString &content, CVideoInfoTag &movieDetails, bool bApplyToDir, CGUIDialogProgress* pDialog);
+
+    void StartPipeline();
+    void StopPipeline(bool bFlush);
+    void QueueJob(CVideoScanJob *job);
+    void WriteResults(bool bFlush);
+    void CommitBatch();
+    void ReleasePathHash(const CStdString &strDirectory);
+    void ScrapeItems();
+    void ScrapeItem(CVideoScanJob &job);
+    void FetchThumbs();
+
     virtual void Run();
     int CountFiles(const CStdString& strPath);
     void FetchSeasonThumbs(long lTvShowId);
@@ -98,6 +134,28 @@ namespace VIDEO
     std::map<CStdString,SScanSettings> m_pathsToScan;
     std::set<CStdString> m_pathsToCount;
     std::vector<long> m_pathsToClean;
+
+    // pipeline state, the queues and m_jobsPending are guarded by m_scanSection
+    CCriticalSection m_scanSection;
+    CEvent m_scrapeEvent; // an item was queued for the scrapers
+    CEvent m_thumbEvent;  // an item was queued for the thumb fetchers
+    CEvent m_resultEvent; // an item is ready to be written
+    std::deque<CVideoScanJob*> m_scrapeQueue;
+    std::deque<CVideoScanJob*> m_thumbQueue;
+    std::deque<CVideoScanJob*> m_resultQueue;
+    std::vector<CThread*> m_workers;
+    std::set<long> m_seasonThumbShows;
+    // directory -> (hash, jobs not written yet). scanner thread only, the hash of a
+    // directory is stored once all of its items are in the database
+    std::map<CStdString, std::pair<CStdString, int> > m_pendingHashes;
+    CStdString m_strHashPath; // directory the jobs being queued belong to
+    int m_jobsPending;  // queued, but not written yet
+    int m_queueLimit;
+    int m_itemsInTransaction;
+    bool m_bPipeline;
+    volatile bool m_bStopWorkers;
+    CScanWorker m_scraper;
+    CScanWorker m_thumbFetcher;
   };
 }
 
@@ -23,6 +23,7 @@
 
 #include "IAudioCallback.h"
 #include "Key.h"
+#include <vector>
 
 class IPlayerCallback
 {
@@ -133,6 +134,8 @@ public:
   virtual bool IsCaching() const {return false;};
   //Cache filled in Percent
   virtual int GetCacheLevel() const {return -1;}; 
+  // parts of the file held by a local cache, as [start, end) percentages of the file
+  virtual bool GetCachedSegments(std::vector< std::pair<float, float> >& segments) { return false; }
 
   virtual bool IsInMenu() const {return false;};
   virtual bool HasMenu() { return false; };
@@ -156,3 +156,41 @@ bool CDVDCodecUtils::CopyPicture(YV12Image* pImage, DVDVideoPicture *pSrc)
   }
   return true;
 }
+
+static void CopyPlaneRect(BYTE* d, int dstride, BYTE* s, int sstride, int x, int y, int w, int h)
+{
+  d += y * dstride + x;
+  s += y * sstride + x;
+  for (int i = 0; i < h; i++)
+  {
+    memcpy(d, s, w);
+    s += sstride;
+    d += dstride;
+  }
+}
+
+bool CDVDCodecUtils::CopyPictureRect(DVDVideoPicture* pDst, DVDVideoPicture* pSrc, const RECT& rect)
+{
+  int x = rect.left;
+  int y = rect.top;
+  int w = rect.right - rect.left;
+  int h = rect.bottom - rect.top;
+
+  CopyPlaneRect(pDst->data[0], pDst->iLineSize[0], pSrc->data[0], pSrc->iLineSize[0], x, y, w, h);
+  CopyPlaneRect(pDst->data[1], pDst->iLineSize[1], pSrc->data[1], pSrc->iLineSize[1], x >> 1, y >> 1, w >> 1, h >> 1);
+  CopyPlaneRect(pDst->data[2], pDst->iLineSize[2], pSrc->data[2], pSrc->iLineSize[2], x >> 1, y >> 1, w >> 1, h >> 1);
+  return true;
+}
+
+bool CDVDCodecUtils::CopyPictureRect(YV12Image* pImage, DVDVideoPicture* pSrc, const RECT& rect)
+{
+  int x = rect.left;
+  int y = rect.top;
+  int w = rect.right - rect.left;
+  int h = rect.bottom - rect.top;
+
+  CopyPlaneRect(pImage->plane[0], pImage->stride[0], pSrc->data[0], pSrc->iLineSize[0], x, y, w, h);
+  CopyPlaneRect(pImage->plane[1], pImage->stride[1], pSrc->data[1], pSrc->iLineSize[1], x >> 1, y >> 1, w >> 1, h >> 1);
+  CopyPlaneRect(pImage->plane[2], pImage->stride[2], pSrc->data[2], pSrc->iLineSize[2], x >> 1, y >> 1, w >> 1, h >> 1);
+  return true;
+}
@@ -32,5 +32,9 @@ public:
   static void FreePicture(DVDVideoPicture* pPicture);
   static bool CopyPicture(DVDVideoPicture* pDst, DVDVideoPicture* pSrc);
   static bool CopyPicture(YV12Image* pDst, DVDVideoPicture *pSrc);
+
+  // copy only rect, its edges must be even so it maps onto whole chroma samples
+  static bool CopyPictureRect(DVDVideoPicture* pDst, DVDVideoPicture* pSrc, const RECT& rect);
+  static bool CopyPictureRect(YV12Image* pDst, DVDVideoPicture* pSrc, const RECT& rect);
 };
 
@@ -0,0 +1,203 @@
+/*
+ *      Copyright (C) 2005-2008 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "stdafx.h"
+#include "DVDDemuxPacketPool.h"
+
+#define CLASS_UNPOOLED -1
+
+struct CDVDDemuxPacketPool::SNode
+{
+  DemuxPacket packet;    // must stay the first member, we cast between the two
+  int         iClass;
+  int         iCapacity;
+  SNode*      pNext;
+};
+
+CDVDDemuxPacketPool g_dvdDemuxPacketPool;
+
+CDVDDemuxPacketPool::CDVDDemuxPacketPool()
+{
+  for (int i = 0; i < DEMUXPACKETPOOL_CLASSES; i++)
+  {
+    m_pFree[i] = NULL;
+    m_iFree[i] = 0;
+  }
+  memset(&m_stats, 0, sizeof(m_stats));
+}
+
+CDVDDemuxPacketPool::~CDVDDemuxPacketPool()
+{
+  Trim();
+}
+
+int CDVDDemuxPacketPool::GetClass(int iBufferSize)
+{
+  if (iBufferSize <= 0)
+    return 0;
+
+  if (iBufferSize > (1 << DEMUXPACKETPOOL_MAX_SHIFT))
+    return CLASS_UNPOOLED;
+
+  int iClass = 1;
+  while ((1 << (DEMUXPACKETPOOL_MIN_SHIFT + iClass - 1)) < iBufferSize)
+    iClass++;
+  return iClass;
+}
+
+int CDVDDemuxPacketPool::GetCapacity(int iClass)
+{
+  if (iClass <= 0)
+    return 0;
+  return 1 << (DEMUXPACKETPOOL_MIN_SHIFT + iClass - 1);
+}
+
+DemuxPacket* CDVDDemuxPacketPool::Allocate(int iBufferSize)
+{
+  int iClass = GetClass(iBufferSize);
+  SNode* pNode = NULL;
+
+  {
+    CSingleLock lock(m_critSection);
+    if (iClass != CLASS_UNPOOLED && m_pFree[iClass])
+    {
+      pNode = m_pFree[iClass];
+      m_pFree[iClass] = pNode->pNext;
+      m_iFree[iClass]--;
+      m_stats.iIdle--;
+      m_stats.iBytesIdle -= pNode->iCapacity;
+      m_stats.iHits++;
+    }
+  }
+
+  if (!pNode)
+  {
+    pNode = new SNode;
+    if (!pNode)
+      return NULL;
+
+    pNode->iClass    = iClass;
+    pNode->iCapacity = iClass == CLASS_UNPOOLED ? iBufferSize : GetCapacity(iClass);
+    pNode->packet.pData = NULL;
+
+    if (pNode->iCapacity > 0)
+    {
+      pNode->packet.pData = (BYTE*)_aligned_malloc(pNode->iCapacity, 16);
+      if (!pNode->packet.pData)
+      {
+        delete pNode;
+        return NULL;
+      }
+    }
+  }
+
+  BYTE* pData = pNode->packet.pData;
+  memset(&pNode->packet, 0, sizeof(DemuxPacket));
+  pNode->packet.pData = pData;
+  pNode->pNext = NULL;
+
+  CSingleLock lock(m_critSection);
+  m_stats.iAllocations++;
+  m_stats.iInUse++;
+  m_stats.iBytesInUse += pNode->iCapacity;
+  if (m_stats.iBytesInUse + m_stats.iBytesIdle > m_stats.iBytesPeak)
+    m_stats.iBytesPeak = m_stats.iBytesInUse + m_stats.iBytesIdle;
+
+  return &pNode->packet;
+}
+
+void CDVDDemuxPacketPool::Release(DemuxPacket* pPacket)
+{
+  if (!pPacket)
+    return;
+
+  SNode* pNode = (SNode*)pPacket;
+
+  {
+    CSingleLock lock(m_critSection);
+    m_stats.iInUse--;
+    m_stats.iBytesInUse -= pNode->iCapacity;
+
+    int iClass = pNode->iClass;
+    if (iClass != CLASS_UNPOOLED
+    && (m_iFree[iClass] + 1) * (unsigned int)pNode->iCapacity <= DEMUXPACKETPOOL_MAX_IDLE)
+    {
+      pNode->pNext = m_pFree[iClass];
+      m_pFree[iClass] = pNode;
+      m_iFree[iClass]++;
+      m_stats.iIdle++;
+      m_stats.iBytesIdle += pNode->iCapacity;
+      return;
+    }
+  }
+
+  FreeNode(pNode);
+}
+
+void CDVDDemuxPacketPool::FreeNode(SNode* pNode)
+{
+  if (pNode->packet.pData)
+    _aligned_free(pNode->packet.pData);
+  delete pNode;
+}
+
+void CDVDDemuxPacketPool::Trim()
+{
+  SNode* pFree[DEMUXPACKETPOOL_CLASSES];
+
+  {
+    CSingleLock lock(m_critSection);
+    for (int i = 0; i < DEMUXPACKETPOOL_CLASSES; i++)
+    {
+      pFree[i]   = m_pFree[i];
+      m_pFree[i] = NULL;
+      m_iFree[i] = 0;
+    }
+    m_stats.iIdle      = 0;
+    m_stats.iBytesIdle = 0;
+  }
+
+  for (int i = 0; i < DEMUXPACKETPOOL_CLASSES; i++)
+  {
+    while (pFree[i])
+    {
+      SNode* pNode = pFree[i];
+      pFree[i] = pNode->pNext;
+      FreeNode(pNode);
+    }
+  }
+}
+
+void CDVDDemuxPacketPool::GetStats(DemuxPacketPoolStats& stats)
+{
+  CSingleLock lock(m_critSection);
+  stats = m_stats;
+}
+
+void CDVDDemuxPacketPool::LogStats()
+{
+  DemuxPacketPoolStats stats;
+  GetStats(stats);
+
+  int iHitRate = stats.iAllocations ? (int)(((__int64)stats.iHits * 100) / stats.iAllocations) : 0;
+  CLog::Log(LOGDEBUG, "CDVDDemuxPacketPool - allocations: %u, hit rate: %d%%, in use: %u, idle: %u, peak bytes: %"PRId64,
+                      stats.iAllocations, iHitRate, stats.iInUse, stats.iIdle, stats.iBytesPeak);
+}
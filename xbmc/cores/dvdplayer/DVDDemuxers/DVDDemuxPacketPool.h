@@ -0,0 +1,91 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2005-2008 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "DVDDemux.h"
+#include "utils/CriticalSection.h"
+
+// smallest pooled payload is 1 << DEMUXPACKETPOOL_MIN_SHIFT bytes, largest 1 << DEMUXPACKETPOOL_MAX_SHIFT.
+// anything bigger is allocated and freed directly.
+#define DEMUXPACKETPOOL_MIN_SHIFT    8
+#define DEMUXPACKETPOOL_MAX_SHIFT    22
+#define DEMUXPACKETPOOL_CLASSES      (DEMUXPACKETPOOL_MAX_SHIFT - DEMUXPACKETPOOL_MIN_SHIFT + 2) // +1 for header only packets
+
+// upper limit of idle payload bytes kept around per size class
+#define DEMUXPACKETPOOL_MAX_IDLE     (8 * 1024 * 1024)
+
+typedef struct stDemuxPacketPoolStats
+{
+  unsigned int iAllocations; // total number of packets handed out
+  unsigned int iHits;        // packets that were served from a freelist
+  unsigned int iInUse;       // packets currently handed out
+  unsigned int iIdle;        // packets waiting in the freelists
+  __int64      iBytesInUse;  // payload bytes currently handed out
+  __int64      iBytesIdle;   // payload bytes waiting in the freelists
+  __int64      iBytesPeak;   // highest value of iBytesInUse + iBytesIdle
+} DemuxPacketPoolStats;
+
+/**
+ * Size classed, thread safe recycler for DemuxPacket's.
+ * Packets are handed out with a 16 byte aligned payload buffer large enough
+ * for the requested size, and go back into the freelist of their class when
+ * released, so steady state playback does not touch the heap on the demux path.
+ */
+class CDVDDemuxPacketPool
+{
+public:
+  CDVDDemuxPacketPool();
+  ~CDVDDemuxPacketPool();
+
+  /*
+   * returns a zeroed packet, with pData pointing to at least iBufferSize bytes
+   * (pData is NULL when iBufferSize is 0). returns NULL when out of memory.
+   */
+  DemuxPacket* Allocate(int iBufferSize);
+
+  /*
+   * returns the packet to the pool, only packets from Allocate() may be passed in
+   */
+  void Release(DemuxPacket* pPacket);
+
+  /*
+   * frees all idle packets, called when playback ends
+   */
+  void Trim();
+
+  void GetStats(DemuxPacketPoolStats& stats);
+  void LogStats();
+
+protected:
+  struct SNode;
+
+  static int GetClass(int iBufferSize);
+  static int GetCapacity(int iClass);
+  void FreeNode(SNode* pNode);
+
+  SNode*           m_pFree[DEMUXPACKETPOOL_CLASSES];
+  unsigned int     m_iFree[DEMUXPACKETPOOL_CLASSES];
+  DemuxPacketPoolStats m_stats;
+  CCriticalSection m_critSection;
+};
+
+extern CDVDDemuxPacketPool g_dvdDemuxPacketPool;
@@ -21,6 +21,7 @@
  
 #include "stdafx.h"
 #include "DVDDemuxUtils.h"
+#include "DVDDemuxPacketPool.h"
 #include "DVDClock.h"
 extern "C" {
 #include "cores/ffmpeg/avcodec.h"
@@ -31,8 +32,7 @@ void CDVDDemuxUtils::FreeDemuxPacket(DemuxPacket* pPacket)
   if (pPacket)
   {
     try {
-      if (pPacket->pData) _aligned_free(pPacket->pData);    
-      delete pPacket;
+      g_dvdDemuxPacketPool.Release(pPacket);
     }
     catch(...) {
       CLog::Log(LOGERROR, "%s - Exception thrown while freeing packet", __FUNCTION__);
@@ -42,34 +42,25 @@ void CDVDDemuxUtils::FreeDemuxPacket(DemuxPacket* pPacket)
 
 DemuxPacket* CDVDDemuxUtils::AllocateDemuxPacket(int iDataSize)
 {
-  DemuxPacket* pPacket = new DemuxPacket;
-  if (!pPacket) return NULL;
+  DemuxPacket* pPacket = NULL;
 
   try
   {
-    memset(pPacket, 0, sizeof(DemuxPacket));
+    // need to allocate a few bytes more.
+    // From avcodec.h (ffmpeg)
+    /**
+      * Required number of additionally allocated bytes at the end of the input bitstream for decoding.
+      * this is mainly needed because some optimized bitstream readers read 
+      * 32 or 64 bit at once and could read over the end<br>
+      * Note, if the first 23 bits of the additional bytes are not 0 then damaged
+      * MPEG bitstreams could cause overread and segfault
+      */ 
+    pPacket = g_dvdDemuxPacketPool.Allocate(iDataSize > 0 ? iDataSize + FF_INPUT_BUFFER_PADDING_SIZE : 0);
+    if (!pPacket) return NULL;
 
+    // reset the last 8 bytes to 0;
     if (iDataSize > 0)
-    {
-      // need to allocate a few bytes more.
-      // From avcodec.h (ffmpeg)
-      /**
-        * Required number of additionally allocated bytes at the end of the input bitstream for decoding.
-        * this is mainly needed because some optimized bitstream readers read 
-        * 32 or 64 bit at once and could read over the end<br>
-        * Note, if the first 23 bits of the additional bytes are not 0 then damaged
-        * MPEG bitstreams could cause overread and segfault
-        */ 
-      pPacket->pData =(BYTE*)_aligned_malloc(iDataSize + FF_INPUT_BUFFER_PADDING_SIZE, 16);    
-      if (!pPacket->pData)
-      {
-        FreeDemuxPacket(pPacket);
-        return NULL;
-      }
-
-      // reset the last 8 bytes to 0;
       memset(pPacket->pData + iDataSize, 0, FF_INPUT_BUFFER_PADDING_SIZE);
-    }
 
     // setup defaults
     pPacket->dts       = DVD_NOPTS_VALUE;
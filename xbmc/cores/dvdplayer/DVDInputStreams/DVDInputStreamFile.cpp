@@ -23,6 +23,7 @@
 #include "DVDInputStreamFile.h"
 #include "FileItem.h"
 #include "FileSystem/File.h"
+#include "FileSystem/CacheStrategy.h"
 
 using namespace XFILE;
 
@@ -121,3 +122,11 @@ BitstreamStats CDVDInputStreamFile::GetBitstreamStats() const
   return m_pFile->GetBitstreamStats();
 }
 
+
+bool CDVDInputStreamFile::GetCachedRanges(std::vector< std::pair<__int64, __int64> >& ranges)
+{
+  if (!m_pFile || !m_pFile->GetCache())
+    return false;
+
+  return m_pFile->GetCache()->GetCachedRanges(ranges);
+}
@@ -22,6 +22,7 @@
  */
 
 #include "DVDInputStream.h"
+#include <vector>
 
 class CDVDInputStreamFile : public CDVDInputStream
 {
@@ -36,6 +37,9 @@ public:
   virtual __int64 GetLength();
   virtual BitstreamStats GetBitstreamStats() const ;
 
+  // byte ranges [start, end) of the file already held by the local cache
+  bool GetCachedRanges(std::vector< std::pair<__int64, __int64> >& ranges);
+
 protected:
   XFILE::CFile* m_pFile;
   bool m_eof;
@@ -23,6 +23,70 @@
 #include "DVDMessage.h"
 #include "DVDDemuxers/DVDDemuxUtils.h"
 #include "DVDStreamInfo.h"
+#include "DVDPerformanceCounter.h"
+
+/**
+ * CDVDMsg --- message pool
+ */
+#define DVDMSG_POOL_GRANULARITY  8
+#define DVDMSG_POOL_MAX_SIZE     256  // bigger messages go straight to the heap
+#define DVDMSG_POOL_MAX_IDLE     512  // idle messages kept per size class
+#define DVDMSG_POOL_CLASSES      (DVDMSG_POOL_MAX_SIZE / DVDMSG_POOL_GRANULARITY + 1)
+
+typedef struct stDVDMsgPoolItem
+{
+  struct stDVDMsgPoolItem* pNext;
+} DVDMsgPoolItem;
+
+static DVDMsgPoolItem*  g_dvdMsgPool[DVDMSG_POOL_CLASSES];
+static unsigned int     g_dvdMsgPoolIdle[DVDMSG_POOL_CLASSES];
+static CCriticalSection g_dvdMsgPoolSection;
+
+void* CDVDMsg::operator new(size_t size)
+{
+  if (size > DVDMSG_POOL_MAX_SIZE)
+  {
+    InterlockedIncrement(&g_dvdPerformanceCounter.m_iMsgAllocated);
+    return ::operator new(size);
+  }
+
+  unsigned int index = (size + DVDMSG_POOL_GRANULARITY - 1) / DVDMSG_POOL_GRANULARITY;
+  {
+    CSingleLock lock(g_dvdMsgPoolSection);
+    DVDMsgPoolItem* pItem = g_dvdMsgPool[index];
+    if (pItem)
+    {
+      g_dvdMsgPool[index] = pItem->pNext;
+      g_dvdMsgPoolIdle[index]--;
+      InterlockedIncrement(&g_dvdPerformanceCounter.m_iMsgRecycled);
+      return pItem;
+    }
+  }
+  InterlockedIncrement(&g_dvdPerformanceCounter.m_iMsgAllocated);
+  return ::operator new(index * DVDMSG_POOL_GRANULARITY);
+}
+
+void CDVDMsg::operator delete(void* p, size_t size)
+{
+  if (!p)
+    return;
+
+  if (size <= DVDMSG_POOL_MAX_SIZE)
+  {
+    unsigned int index = (size + DVDMSG_POOL_GRANULARITY - 1) / DVDMSG_POOL_GRANULARITY;
+
+    CSingleLock lock(g_dvdMsgPoolSection);
+    if (g_dvdMsgPoolIdle[index] < DVDMSG_POOL_MAX_IDLE)
+    {
+      DVDMsgPoolItem* pItem = (DVDMsgPoolItem*)p;
+      pItem->pNext = g_dvdMsgPool[index];
+      g_dvdMsgPool[index] = pItem;
+      g_dvdMsgPoolIdle[index]++;
+      return;
+    }
+  }
+  ::operator delete(p);
+}
 
 /**
  * CDVDMsgGeneralStreamChange --- GENERAL_STREAMCHANGE
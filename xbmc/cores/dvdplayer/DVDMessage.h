@@ -149,6 +149,13 @@ public:
     return m_references;
   }
 
+  /**
+   * messages are recycled through freelists, one per object size, so
+   * wrapping packets and sending control messages doesn't hit the heap
+   */
+  static void* operator new(size_t size);
+  static void  operator delete(void* p, size_t size);
+
 private:
   long m_references;
   Message m_message;
@@ -28,14 +28,22 @@ using namespace std;
 CDVDMessageQueue::CDVDMessageQueue(const string &owner)
 {
   m_owner = owner;
-  m_pFirstMessage = NULL;
-  m_pLastMessage  = NULL;
   m_iDataSize     = 0;
+  m_iPacketCount  = 0;
+  m_iWaiting      = 0;
   m_bAbortRequest = false;
   m_bInitialized  = false;
   m_bCaching      = false;
   m_bEmptied      = true;
   
+  for (int i = 0; i < DVDMSGQUEUE_LANES; i++)
+  {
+    m_lanes[i].pMsgs  = new CDVDMsg*[DVDMSGQUEUE_LANE_SIZE];
+    m_lanes[i].iSize  = m_lanes[i].pMsgs ? DVDMSGQUEUE_LANE_SIZE : 0;
+    m_lanes[i].iHead  = 0;
+    m_lanes[i].iCount = 0;
+  }
+
   InitializeCriticalSection(&m_critSection);
   m_hEvent = CreateEvent(NULL, true, false, NULL);
 }
@@ -43,55 +51,111 @@ CDVDMessageQueue::CDVDMessageQueue(const string &owner)
 CDVDMessageQueue::~CDVDMessageQueue()
 {
   // remove all remaining messages
-  Flush();
+  Flush(CDVDMsg::NONE);
   
+  for (int i = 0; i < DVDMSGQUEUE_LANES; i++)
+    delete[] m_lanes[i].pMsgs;
+
   DeleteCriticalSection(&m_critSection);
   CloseHandle(m_hEvent);
 }
 
 void CDVDMessageQueue::Init()
 {
-  m_pFirstMessage = NULL;
-  m_pLastMessage  = NULL;
   m_iDataSize     = 0;
+  m_iPacketCount  = 0;
   m_bAbortRequest = false;
   m_bEmptied      = true;
   m_bInitialized  = true;
 }
 
-void CDVDMessageQueue::Flush(CDVDMsg::Message type)
+bool CDVDMessageQueue::LanePush(DVDMessageLane& lane, CDVDMsg* pMsg)
 {
-  EnterCriticalSection(&m_critSection);
-
-  if (m_bInitialized)
+  if (lane.iCount == lane.iSize)
   {
-    DVDMessageListItem first;
-    first.pNext = m_pFirstMessage;
+    // lane is full, double it. this only happens until the lane has
+    // grown to the working size of the queue, after that no allocation is done
+    unsigned int iSize = lane.iSize ? lane.iSize * 2 : DVDMSGQUEUE_LANE_SIZE;
+    CDVDMsg** pMsgs = new CDVDMsg*[iSize];
+    if (!pMsgs)
+      return false;
+
+    for (unsigned int i = 0; i < lane.iCount; i++)
+      pMsgs[i] = lane.pMsgs[(lane.iHead + i) & (lane.iSize - 1)];
+
+    delete[] lane.pMsgs;
+    lane.pMsgs = pMsgs;
+    lane.iSize = iSize;
+    lane.iHead = 0;
+  }
 
-    DVDMessageListItem *pLast = &first;
-    DVDMessageListItem *pCurr; 
-    while ((pCurr = pLast->pNext))
+  lane.pMsgs[(lane.iHead + lane.iCount) & (lane.iSize - 1)] = pMsg;
+  lane.iCount++;
+  return true;
+}
+
+CDVDMsg* CDVDMessageQueue::LanePop(DVDMessageLane& lane)
+{
+  if (lane.iCount == 0)
+    return NULL;
+
+  CDVDMsg* pMsg = lane.pMsgs[lane.iHead];
+  lane.iHead = (lane.iHead + 1) & (lane.iSize - 1);
+  lane.iCount--;
+  return pMsg;
+}
+
+void CDVDMessageQueue::LaneFlush(DVDMessageLane& lane, CDVDMsg::Message type)
+{
+  // compact the lane in place, keeping the order of the messages we don't remove
+  unsigned int iKept = 0;
+  for (unsigned int i = 0; i < lane.iCount; i++)
+  {
+    CDVDMsg* pMsg = lane.pMsgs[(lane.iHead + i) & (lane.iSize - 1)];
+    if (pMsg->IsType(type) || type == CDVDMsg::NONE)
     {
-      if (pCurr->pMsg->IsType(type) ||  type == CDVDMsg::NONE)
-      {
-        pLast->pNext = pCurr->pNext;
-        pCurr->pMsg->Release();
-        delete pCurr;
-      }
-      else
-        pLast = pCurr;
+      if (pMsg->IsType(CDVDMsg::DEMUXER_PACKET))
+        m_iPacketCount--;
+      pMsg->Release();
     }
+    else
+      lane.pMsgs[(lane.iHead + iKept++) & (lane.iSize - 1)] = pMsg;
+  }
+  lane.iCount = iKept;
+}
 
-    m_pFirstMessage = first.pNext;
-    if(pLast == &first)
-      m_pLastMessage = NULL;
+void CDVDMessageQueue::UpdateDataSize(CDVDMsg* pMsg, int sign)
+{
+  if (pMsg->IsType(CDVDMsg::DEMUXER_PACKET))
+  {
+    CDVDMsgDemuxerPacket* pMsgDemuxerPacket = (CDVDMsgDemuxerPacket*)pMsg;
+    if (sign > 0)
+    {
+      m_iDataSize += pMsgDemuxerPacket->GetPacketSize();
+      m_iPacketCount++;
+    }
     else
-      m_pLastMessage = pLast;
+    {
+      m_iDataSize -= pMsgDemuxerPacket->GetPacketSize();
+      m_iPacketCount--;
+    }
+  }
+}
+
+void CDVDMessageQueue::Flush(CDVDMsg::Message type)
+{
+  EnterCriticalSection(&m_critSection);
+
+  if (m_bInitialized || type == CDVDMsg::NONE)
+  {
+    for (int i = 0; i < DVDMSGQUEUE_LANES; i++)
+      LaneFlush(m_lanes[i], type);
   }
 
   if (type == CDVDMsg::DEMUXER_PACKET ||  type == CDVDMsg::NONE)
   {
     m_iDataSize = 0;
+    m_iPacketCount = 0;
     m_bEmptied = true;
   }
 
@@ -111,13 +175,11 @@ void CDVDMessageQueue::Abort()
 
 void CDVDMessageQueue::End()
 {
-  Flush();
+  Flush(CDVDMsg::NONE);
   
   EnterCriticalSection(&m_critSection);
   
   m_bInitialized  = false;
-  m_pFirstMessage = NULL;
-  m_pLastMessage  = NULL;
   m_iDataSize     = 0;
   m_bAbortRequest = false;
   
@@ -139,55 +201,24 @@ MsgQueueReturnCode CDVDMessageQueue::Put(CDVDMsg* pMsg, int priority)
     return MSGQ_INVALID_MSG;
   }
 
-  DVDMessageListItem* msgItem = new DVDMessageListItem;
-
-  if (!msgItem)
-  {
-    CLog::Log(LOGFATAL, "CDVDMessageQueue(%s)::Put MSGQ_OUT_OF_MEMORY", m_owner.c_str());
-    return MSGQ_OUT_OF_MEMORY;
-  }
-
-  msgItem->pMsg = pMsg;
-  msgItem->pNext = NULL;
-  msgItem->priority = priority;
+  if (priority < 0)
+    priority = 0;
+  else if (priority >= DVDMSGQUEUE_LANES)
+    priority = DVDMSGQUEUE_LANES - 1;
 
   EnterCriticalSection(&m_critSection);
 
-  if(!m_pLastMessage || m_pLastMessage && m_pLastMessage->priority >= priority)
+  if (!LanePush(m_lanes[priority], pMsg))
   {
-    /* quick path to just add at the end */
-    if (!m_pFirstMessage) m_pFirstMessage = msgItem;
-    else m_pLastMessage->pNext = msgItem;
-    m_pLastMessage = msgItem;
-  }
-  else
-  {
-    /* add in prio order */
-    DVDMessageListItem* pCurr = m_pFirstMessage;
-    DVDMessageListItem* pLast = NULL;
-
-    while (pCurr && pCurr->priority >= priority)
-    {
-      pLast = pCurr;
-      pCurr = pCurr->pNext;
-    }
-
-    msgItem->pNext = pCurr;
-    if (pLast)
-      pLast->pNext = msgItem;
-    if (msgItem->pNext == NULL)
-      m_pLastMessage = msgItem;
-    if (msgItem->pNext == m_pFirstMessage)
-      m_pFirstMessage = msgItem;
+    LeaveCriticalSection(&m_critSection);
+    CLog::Log(LOGFATAL, "CDVDMessageQueue(%s)::Put MSGQ_OUT_OF_MEMORY", m_owner.c_str());
+    return MSGQ_OUT_OF_MEMORY;
   }
 
-  if (pMsg->IsType(CDVDMsg::DEMUXER_PACKET))
-  {
-    CDVDMsgDemuxerPacket* pMsgDemuxerPacket = (CDVDMsgDemuxerPacket*)pMsg;
-    m_iDataSize += pMsgDemuxerPacket->GetPacketSize();
-  }
+  UpdateDataSize(pMsg, 1);
 
-  SetEvent(m_hEvent); // inform waiter for new packet
+  if (m_iWaiting > 0)
+    SetEvent(m_hEvent); // inform waiter for new packet
 
   LeaveCriticalSection(&m_critSection);
   
@@ -198,7 +229,6 @@ MsgQueueReturnCode CDVDMessageQueue::Get(CDVDMsg** pMsg, unsigned int iTimeoutIn
 {
   *pMsg = NULL;
   
-  DVDMessageListItem* msgItem;
   int ret = 0;
 
   if (!m_bInitialized)
@@ -211,17 +241,18 @@ MsgQueueReturnCode CDVDMessageQueue::Get(CDVDMsg** pMsg, unsigned int iTimeoutIn
 
   while (!m_bAbortRequest)
   {
-    msgItem = m_pFirstMessage;
-    if (msgItem && msgItem->priority >= priority && !m_bCaching)
+    // highest non empty lane holds the message that was first in the old priority ordered list
+    int lane = DVDMSGQUEUE_LANES - 1;
+    while (lane >= 0 && m_lanes[lane].iCount == 0)
+      lane--;
+
+    if (lane >= 0 && lane >= priority && !m_bCaching)
     {
-      m_pFirstMessage = msgItem->pNext;
-      
-      if (!m_pFirstMessage) m_pLastMessage = NULL;
+      *pMsg = LanePop(m_lanes[lane]);
 
-      if (msgItem->pMsg->IsType(CDVDMsg::DEMUXER_PACKET))
+      if ((*pMsg)->IsType(CDVDMsg::DEMUXER_PACKET))
       {
-        CDVDMsgDemuxerPacket* pMsgDemuxerPacket = (CDVDMsgDemuxerPacket*)msgItem->pMsg;
-        m_iDataSize -= pMsgDemuxerPacket->GetPacketSize();
+        UpdateDataSize(*pMsg, -1);
         if(m_iDataSize == 0)
         {
           if(!m_bEmptied)
@@ -232,10 +263,6 @@ MsgQueueReturnCode CDVDMessageQueue::Get(CDVDMsg** pMsg, unsigned int iTimeoutIn
           m_bEmptied = false;
       }
 
-      *pMsg = msgItem->pMsg;
-      
-      delete msgItem; // free the list item we allocated in ::Put()
-      
       ret = MSGQ_OK;
       break;
     }
@@ -247,15 +274,19 @@ MsgQueueReturnCode CDVDMessageQueue::Get(CDVDMsg** pMsg, unsigned int iTimeoutIn
     else
     {
       ResetEvent(m_hEvent);
+      m_iWaiting++;
       LeaveCriticalSection(&m_critSection);
       
       // wait for a new message
-      if (WaitForSingleObject(m_hEvent, iTimeoutInMilliSeconds) == WAIT_TIMEOUT)
+      bool timeout = WaitForSingleObject(m_hEvent, iTimeoutInMilliSeconds) == WAIT_TIMEOUT;
+
+      EnterCriticalSection(&m_critSection);
+      m_iWaiting--;
+      if (timeout)
       {
-        // just return here directly, we have already left critical section
+        LeaveCriticalSection(&m_critSection);
         return MSGQ_TIMEOUT;
       }
-      EnterCriticalSection(&m_critSection);
     }
   }
   LeaveCriticalSection(&m_critSection);
@@ -274,12 +305,19 @@ unsigned CDVDMessageQueue::GetPacketCount(CDVDMsg::Message type)
   EnterCriticalSection(&m_critSection);
   
   unsigned count = 0;
-  DVDMessageListItem* msgItem = m_pFirstMessage;
-  while(msgItem)
+  if (type == CDVDMsg::DEMUXER_PACKET)
+    count = m_iPacketCount;
+  else
   {
-    if( msgItem->pMsg->IsType(type) )
-      count++;
-    msgItem = msgItem->pNext;
+    for (int i = 0; i < DVDMSGQUEUE_LANES; i++)
+    {
+      DVDMessageLane& lane = m_lanes[i];
+      for (unsigned int j = 0; j < lane.iCount; j++)
+      {
+        if( lane.pMsgs[(lane.iHead + j) & (lane.iSize - 1)]->IsType(type) )
+          count++;
+      }
+    }
   }
   
   LeaveCriticalSection(&m_critSection);
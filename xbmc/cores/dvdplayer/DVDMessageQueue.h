@@ -24,13 +24,20 @@
 #include "DVDMessage.h"
 #include <string>
 
-typedef struct stDVDMessageListItem
+// number of priority lanes, messages put with a higher priority end up in the top lane
+#define DVDMSGQUEUE_LANES        4
+// initial number of slots per lane, lanes double in size when they run full
+#define DVDMSGQUEUE_LANE_SIZE    256
+
+// preallocated ring of messages with the same priority
+typedef struct stDVDMessageLane
 {
-  CDVDMsg* pMsg;
-  struct stDVDMessageListItem *pNext;
-  int priority;
+  CDVDMsg** pMsgs;
+  unsigned int iSize;  // number of slots, always a power of two
+  unsigned int iHead;  // slot of the oldest message
+  unsigned int iCount; // number of messages in the lane
 }
-DVDMessageListItem;
+DVDMessageLane;
 
 enum MsgQueueReturnCode
 {
@@ -76,11 +83,17 @@ public:
   bool IsInited() const                 { return m_bInitialized; }
 private:
 
+  bool LanePush(DVDMessageLane& lane, CDVDMsg* pMsg);
+  CDVDMsg* LanePop(DVDMessageLane& lane);
+  void LaneFlush(DVDMessageLane& lane, CDVDMsg::Message type);
+  void UpdateDataSize(CDVDMsg* pMsg, int sign);
+
   HANDLE m_hEvent;
   mutable CRITICAL_SECTION m_critSection;
   
-  DVDMessageListItem* m_pFirstMessage;
-  DVDMessageListItem* m_pLastMessage;
+  DVDMessageLane m_lanes[DVDMSGQUEUE_LANES];
+  int m_iWaiting; // number of threads blocked in Get()
+  unsigned int m_iPacketCount;
   
   bool m_bAbortRequest;
   bool m_bInitialized;
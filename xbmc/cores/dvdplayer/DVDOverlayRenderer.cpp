@@ -28,6 +28,14 @@
 
 #define CLAMP(a, min, max) ((a) > (max) ? (max) : ( (a) < (min) ? (min) : a ))
 
+// x / 255, exact for 0 <= x < 65535
+#define DIV255(x) (((x) + 1 + ((x) >> 8)) >> 8)
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OVERLAYRENDERER_SSE2
+#include <emmintrin.h>
+#endif
+
 
 void CDVDOverlayRenderer::Render(DVDPictureRenderer* pPicture, CDVDOverlay* pOverlay, double pts)
 {
@@ -64,68 +72,216 @@ void CDVDOverlayRenderer::Render(DVDPictureRenderer* pPicture, CDVDOverlay* pOve
 }
 
 
-void CDVDOverlayRenderer::Render(DVDPictureRenderer* pPicture, CDVDOverlaySSA* pOverlay, double pts)
+static void AddBounds(RECT& rect, bool& bEmpty, int x, int y, int w, int h)
 {
+  if (w <= 0 || h <= 0)
+    return;
 
-  int height, width;
-  height = pPicture->height;
-  width = pPicture->width;
+  if (bEmpty)
+  {
+    rect.left   = x;
+    rect.top    = y;
+    rect.right  = x + w;
+    rect.bottom = y + h;
+    bEmpty = false;
+    return;
+  }
+  rect.left   = std::min((int)rect.left, x);
+  rect.top    = std::min((int)rect.top, y);
+  rect.right  = std::max((int)rect.right, x + w);
+  rect.bottom = std::max((int)rect.bottom, y + h);
+}
 
-  ass_image_t* img = pOverlay->m_libass->RenderImage(width, height, pts);
+// mirrors the placement done by the renderers below
+bool CDVDOverlayRenderer::GetBounds(CDVDOverlay* pOverlay, int width, int height, double pts, RECT& rect)
+{
+  bool bEmpty = true;
 
-  while(img)
+  if (pOverlay->IsOverlayType(DVDOVERLAY_TYPE_SPU))
+  {
+    CDVDOverlaySpu* pSpu = (CDVDOverlaySpu*)pOverlay;
+    int x = std::max(0, pSpu->x);
+    int y = std::max(0, pSpu->y);
+    AddBounds(rect, bEmpty, x, y, std::min(pSpu->x + pSpu->width, width) - x, std::min(pSpu->y + pSpu->height, height) - y);
+  }
+  else if (pOverlay->IsOverlayType(DVDOVERLAY_TYPE_IMAGE))
+  {
+    CDVDOverlayImage* pImage = (CDVDOverlayImage*)pOverlay;
+    int y = std::max(0,std::min(pImage->y, height-pImage->height));
+    int x = std::max(0,std::min(pImage->x, width-pImage->width));
+    AddBounds(rect, bEmpty, x, y, std::min(pImage->width, width - x), std::min(pImage->height, height - y));
+  }
+  else if (pOverlay->IsOverlayType(DVDOVERLAY_TYPE_SSA))
+  {
+    SDVDLibassLayer& layer = GetLayer((CDVDOverlaySSA*)pOverlay, width, height, pts);
+    if (layer.rect.right > layer.rect.left)
+    {
+      rect = layer.rect;
+      bEmpty = false;
+    }
+  }
+
+  return !bEmpty;
+}
+
+// pixel = premultiplied + pixel * transparency / 255, for one row of a layer
+static void BlendLayerRow(BYTE* dst, const BYTE* premultiplied, const BYTE* transparency, int count)
+{
+  int i = 0;
+#ifdef OVERLAYRENDERER_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i one  = _mm_set1_epi16(1);
+  for (; i + 16 <= count; i += 16)
+  {
+    __m128i d  = _mm_loadu_si128((const __m128i*)(dst + i));
+    __m128i t  = _mm_loadu_si128((const __m128i*)(transparency + i));
+    __m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(t, zero));
+    __m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(t, zero));
+    lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(lo, one), _mm_srli_epi16(lo, 8)), 8);
+    hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(hi, one), _mm_srli_epi16(hi, 8)), 8);
+    d  = _mm_adds_epu8(_mm_packus_epi16(lo, hi), _mm_loadu_si128((const __m128i*)(premultiplied + i)));
+    _mm_storeu_si128((__m128i*)(dst + i), d);
+  }
+#endif
+  for (; i < count; i++)
+  {
+    int value = premultiplied[i] + DIV255(dst[i] * transparency[i]);
+    dst[i] = value > 255 ? 255 : value;
+  }
+}
+
+// flattens the images of a libass frame into layer, oldest image at the bottom
+static void BuildLayer(SDVDLibassLayer& layer, ass_image_t* images, int width, int height)
+{
+  layer.valid  = true;
+  layer.width  = width;
+  layer.height = height;
+  memset(&layer.rect, 0, sizeof(layer.rect));
+
+  RECT rect;
+  bool bEmpty = true;
+  for (ass_image_t* img = images; img; img = img->next)
+  {
+    if ((img->color & 0xff) == 255)
+      continue;
+    int y = std::max(0,std::min(img->dst_y, height-img->h));
+    int x = std::max(0,std::min(img->dst_x, width-img->w));
+    AddBounds(rect, bEmpty, x, y, std::min(img->w, width - x), std::min(img->h, height - y));
+  }
+  if (bEmpty)
+    return;
+
+  rect.left   &= ~1;
+  rect.top    &= ~1;
+  rect.right  = std::min((int)(rect.right + 1) & ~1, width);
+  rect.bottom = std::min((int)(rect.bottom + 1) & ~1, height);
+  layer.rect = rect;
+
+  int w  = rect.right - rect.left;
+  int h  = rect.bottom - rect.top;
+  int cw = (w + 1) >> 1;
+  int ch = (h + 1) >> 1;
+  layer.y.assign(w * h, 0);
+  layer.yt.assign(w * h, 255);
+  layer.u.assign(cw * ch, 0);
+  layer.v.assign(cw * ch, 0);
+  layer.ct.assign(cw * ch, 255);
+
+  for (ass_image_t* img = images; img; img = img->next)
   {
     DWORD color = img->color;
     BYTE alpha = (BYTE)(color &0xff);
 
     if(alpha == 255)
-    {
-      img = img->next;
       continue;
-    }
 
     //ass_image colors are RGBA
     double b = ((color >> 24) & 0xff) / 255.0;
     double g = ((color >> 16) & 0xff) / 255.0;
     double r = ((color >> 8 ) & 0xff) / 255.0;
 
-    BYTE luma  = (BYTE)(255 * CLAMP(0.299 * r + 0.587 * g + 0.114 * b, 0.0, 1.0));
-    BYTE u     = (BYTE)(127.5 + 255 * CLAMP( 0.500 * r - 0.419 * g - 0.081 * b, -0.5, 0.5));
-    BYTE v     = (BYTE)(127.5 + 255 * CLAMP(-0.169 * r - 0.331 * g + 0.500 * b, -0.5, 0.5));
+    int luma = (BYTE)(255 * CLAMP(0.299 * r + 0.587 * g + 0.114 * b, 0.0, 1.0));
+    int u    = (BYTE)(127.5 + 255 * CLAMP( 0.500 * r - 0.419 * g - 0.081 * b, -0.5, 0.5));
+    int v    = (BYTE)(127.5 + 255 * CLAMP(-0.169 * r - 0.331 * g + 0.500 * b, -0.5, 0.5));
+    int opacity = 255 - alpha;
 
-    int y = std::max(0,std::min(img->dst_y, pPicture->height-img->h));
-    int x = std::max(0,std::min(img->dst_x, pPicture->width-img->w));
+    // the image in layer coordinates
+    int x  = std::max(0,std::min(img->dst_x, width-img->w)) - rect.left;
+    int y  = std::max(0,std::min(img->dst_y, height-img->h)) - rect.top;
+    int iw = std::min(img->w, w - x);
+    int ih = std::min(img->h, h - y);
 
-    for(int i=0; i<img->h; i++)
+    for (int i = 0; i < ih; i++)
     {
-      if(y + i >= pPicture->height)
-        break;
+      const BYTE* line = img->bitmap + img->stride * i;
+      BYTE* py = &layer.y[(y + i) * w + x];
+      BYTE* pt = &layer.yt[(y + i) * w + x];
+      for (int j = 0; j < iw; j++)
+      {
+        int k = DIV255(line[j] * opacity);
+        py[j] = DIV255(k * luma + (255 - k) * py[j]);
+        pt[j] = DIV255((255 - k) * pt[j]);
+      }
+    }
 
-      BYTE* line = img->bitmap + img->w*i;
+    // chroma takes the average coverage of its 2x2 block
+    for (int cy = y >> 1; cy <= (y + ih - 1) >> 1; cy++)
+    {
+      for (int cx = x >> 1; cx <= (x + iw - 1) >> 1; cx++)
+      {
+        int sum = 0;
+        for (int py = cy * 2; py < cy * 2 + 2; py++)
+        {
+          if (py < y || py >= y + ih)
+            continue;
+          for (int px = cx * 2; px < cx * 2 + 2; px++)
+          {
+            if (px >= x && px < x + iw)
+              sum += img->bitmap[img->stride * (py - y) + px - x];
+          }
+        }
+        int k = DIV255(((sum + 2) >> 2) * opacity);
+        int c = cy * cw + cx;
+        layer.u[c]  = DIV255(k * u + (255 - k) * layer.u[c]);
+        layer.v[c]  = DIV255(k * v + (255 - k) * layer.v[c]);
+        layer.ct[c] = DIV255((255 - k) * layer.ct[c]);
+      }
+    }
+  }
+}
 
-      BYTE* target[3];
-      target[0] = pPicture->data[0] + pPicture->stride[0]*(i + y) + x;
-      target[1] = pPicture->data[1] + pPicture->stride[1]*((i + y)>>1) + (x>>1);
-      target[2] = pPicture->data[2] + pPicture->stride[2]*((i + y)>>1) + (x>>1);
+// the flattened frame for pts, only rebuilt when libass reports a change
+SDVDLibassLayer& CDVDOverlayRenderer::GetLayer(CDVDOverlaySSA* pOverlay, int width, int height, double pts)
+{
+  int changes = 2;
+  ass_image_t* images = pOverlay->m_libass->RenderImage(width, height, pts, &changes);
 
-      for(int j=0; j<img->w; j++)
-      {
-        if(x + j >= pPicture->width)
-          break;
+  SDVDLibassLayer& layer = pOverlay->m_libass->GetLayer();
+  if (!layer.valid || changes || layer.width != width || layer.height != height)
+    BuildLayer(layer, images, width, height);
+  return layer;
+}
 
-        unsigned char index, opacity, k;
-        index = line[j];
+void CDVDOverlayRenderer::Render(DVDPictureRenderer* pPicture, CDVDOverlaySSA* pOverlay, double pts)
+{
+  SDVDLibassLayer& layer = GetLayer(pOverlay, pPicture->width, pPicture->height, pts);
 
-        //Blend the image with the underlying picture
-        opacity = 255 - alpha;
-        k = (unsigned char)index * opacity / 255;
+  int x  = layer.rect.left;
+  int y  = layer.rect.top;
+  int w  = layer.rect.right - layer.rect.left;
+  int h  = layer.rect.bottom - layer.rect.top;
+  int cw = (w + 1) >> 1;
+  if (w <= 0 || h <= 0)
+    return;
 
-        target[0][j]    = (k*luma + (255-k)*target[0][j])/255;
-        target[1][j>>1] = (k*u    + (255-k)*target[1][j>>1])/255;
-        target[2][j>>1] = (k*v    + (255-k)*target[2][j>>1])/255;
-      }
-    }
-    img = img->next;
+  for (int i = 0; i < h; i++)
+  {
+    BlendLayerRow(pPicture->data[0] + pPicture->stride[0] * (y + i) + x, &layer.y[i * w], &layer.yt[i * w], w);
+    if (i & 1)
+      continue;
+    int c = (i >> 1) * cw;
+    BlendLayerRow(pPicture->data[1] + pPicture->stride[1] * ((y + i) >> 1) + (x >> 1), &layer.u[c], &layer.ct[c], w >> 1);
+    BlendLayerRow(pPicture->data[2] + pPicture->stride[2] * ((y + i) >> 1) + (x >> 1), &layer.v[c], &layer.ct[c], w >> 1);
   }
 }
 
@@ -197,12 +353,31 @@ void CDVDOverlayRenderer::Render(DVDPictureRenderer* pPicture, CDVDOverlayImage*
     free(palette[i]);
 }
 
+// pixel = (colprecomp + pixel * destalpha) >> 4, for a run of a spu line
+static void BlendSpuSpan(BYTE* dst, int count, unsigned __int16 colprecomp, unsigned __int16 destalpha)
+{
+  int i = 0;
+#ifdef OVERLAYRENDERER_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i c    = _mm_set1_epi16(colprecomp);
+  const __m128i a    = _mm_set1_epi16(destalpha);
+  for (; i + 16 <= count; i += 16)
+  {
+    __m128i d  = _mm_loadu_si128((const __m128i*)(dst + i));
+    __m128i lo = _mm_srli_epi16(_mm_add_epi16(c, _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), a)), 4);
+    __m128i hi = _mm_srli_epi16(_mm_add_epi16(c, _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), a)), 4);
+    _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(lo, hi));
+  }
+#endif
+  for (; i < count; i++)
+    dst[i] = ((colprecomp + (unsigned __int16)dst[i] * destalpha) >> 4) & 0xFF;
+}
+
 // render the parsed sub (parsed rle) onto the yuv image
 void CDVDOverlayRenderer::Render_SPU_YUV(DVDPictureRenderer* pPicture, CDVDOverlay* pOverlaySpu, bool bCrop)
 {
   CDVDOverlaySpu* pOverlay = (CDVDOverlaySpu*)pOverlaySpu;
   
-  unsigned __int8*  p_destptr = NULL;
   unsigned __int16* p_source = (unsigned __int16*)pOverlay->pData;
   unsigned __int8*  p_dest[3];
 
@@ -281,27 +456,18 @@ void CDVDOverlayRenderer::Render_SPU_YUV(DVDPictureRenderer* pPicture, CDVDOverl
                         * (unsigned __int16)(p_alpha + 1);
           i_destalpha = 15 - p_alpha;
           
-          for (p_destptr = p_dest[0] + i_x; p_destptr < p_dest[0] + i_x + pixels_to_draw; p_destptr++)
-          {
-            *p_destptr = (( i_colprecomp + (unsigned __int16) * p_destptr * i_destalpha ) >> 4) & 0xFF;
-          }
+          BlendSpuSpan(p_dest[0] + i_x, pixels_to_draw, i_colprecomp, i_destalpha);
           
           if (!(i_y & 1)) // Only draw even lines
           {
             // now U
             i_colprecomp = (unsigned __int16)p_color[2]
                           * (unsigned __int16)(p_alpha + 1);
-            for ( p_destptr = p_dest[1] + (i_x >> 1); p_destptr < p_dest[1] + ((i_x + pixels_to_draw) >> 1); p_destptr++)
-            {
-              *p_destptr = (( i_colprecomp + (unsigned __int16) * p_destptr * i_destalpha ) >> 4) & 0xFF;
-            }
+            BlendSpuSpan(p_dest[1] + (i_x >> 1), ((i_x + pixels_to_draw) >> 1) - (i_x >> 1), i_colprecomp, i_destalpha);
             // and finally V
             i_colprecomp = (unsigned __int16)p_color[1]
                           * (unsigned __int16)(p_alpha + 1);
-            for ( p_destptr = p_dest[2] + (i_x >> 1); p_destptr < p_dest[2] + ((i_x + pixels_to_draw) >> 1); p_destptr++)
-            {
-              *p_destptr = (( i_colprecomp + (unsigned __int16) * p_destptr * i_destalpha ) >> 4) & 0xFF;
-            }
+            BlendSpuSpan(p_dest[2] + (i_x >> 1), ((i_x + pixels_to_draw) >> 1) - (i_x >> 1), i_colprecomp, i_destalpha);
           }
           break;
         }
@@ -30,6 +30,7 @@
 
 class CDVDOverlayImage;
 class CDVDOverlaySSA;
+struct SDVDLibassLayer;
 
 typedef struct stDVDPictureRenderer
 {
@@ -48,6 +49,12 @@ public:
   static void Render(DVDPictureRenderer* pPicture, CDVDOverlayImage* pOverlay);
   static void Render(DVDPictureRenderer* pPicture, CDVDOverlaySSA *pOverlay, double pts);
 
+  /*
+   * the area of a width x height picture that Render() would draw pOverlay on.
+   * returns false when the overlay draws nothing.
+   */
+  static bool GetBounds(CDVDOverlay* pOverlay, int width, int height, double pts, RECT& rect);
+
 
   static void Render(YV12Image* pImage, CDVDOverlay* pOverlay, double pts)
   {
@@ -91,5 +98,6 @@ public:
 
 private:
 
+  static SDVDLibassLayer& GetLayer(CDVDOverlaySSA* pOverlay, int width, int height, double pts);
   static void Render_SPU_YUV(DVDPictureRenderer* pPicture, CDVDOverlay* pOverlaySpu, bool bCrop);
 };
@@ -118,12 +118,26 @@ HRESULT __stdcall DVDPerformanceCounterMainPerformance(PLARGE_INTEGER numerator,
   return S_OK;
 }
 
+HRESULT __stdcall DVDPerformanceCounterMsgAllocated(PLARGE_INTEGER numerator, PLARGE_INTEGER demoninator)
+{
+  numerator->QuadPart = g_dvdPerformanceCounter.m_iMsgAllocated;
+  return S_OK;
+}
+
+HRESULT __stdcall DVDPerformanceCounterMsgRecycled(PLARGE_INTEGER numerator, PLARGE_INTEGER demoninator)
+{
+  numerator->QuadPart = g_dvdPerformanceCounter.m_iMsgRecycled;
+  return S_OK;
+}
+
 CDVDPerformanceCounter g_dvdPerformanceCounter;
 
 CDVDPerformanceCounter::CDVDPerformanceCounter()
 {
   m_pAudioQueue = NULL;
   m_pVideoQueue = NULL;
+  m_iMsgAllocated = 0;
+  m_iMsgRecycled  = 0;
   
   memset(&m_videoDecodePerformance, 0, sizeof(m_videoDecodePerformance)); // video decoding
   memset(&m_audioDecodePerformance, 0, sizeof(m_audioDecodePerformance)); // audio decoding + output to audio device
@@ -151,6 +165,8 @@ bool CDVDPerformanceCounter::Initialize()
   DmRegisterPerformanceCounter("DVDVideoDecodePerformance",   DMCOUNT_SYNC, DVDPerformanceCounterVideoDecodePerformance);
   DmRegisterPerformanceCounter("DVDAudioDecodePerformance",   DMCOUNT_SYNC, DVDPerformanceCounterAudioDecodePerformance);
   DmRegisterPerformanceCounter("DVDMainPerformance",          DMCOUNT_SYNC, DVDPerformanceCounterMainPerformance);
+  DmRegisterPerformanceCounter("DVDMsgAllocated",             DMCOUNT_SYNC, DVDPerformanceCounterMsgAllocated);
+  DmRegisterPerformanceCounter("DVDMsgRecycled",              DMCOUNT_SYNC, DVDPerformanceCounterMsgRecycled);
 
 #endif
 
@@ -66,6 +66,9 @@ public:
   ProcessPerformance        m_videoDecodePerformance;
   ProcessPerformance        m_audioDecodePerformance;
   ProcessPerformance        m_mainPerformance;
+
+  long                      m_iMsgAllocated; // messages that had to be allocated from the heap
+  long                      m_iMsgRecycled;  // messages served from the message pool
   
 private:
   CRITICAL_SECTION m_critSection;
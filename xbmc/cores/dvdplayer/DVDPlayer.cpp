@@ -26,9 +26,11 @@
 #include "DVDInputStreams/DVDFactoryInputStream.h"
 #include "DVDInputStreams/DVDInputStreamNavigator.h"
 #include "DVDInputStreams/DVDInputStreamTV.h"
+#include "DVDInputStreams/DVDInputStreamFile.h"
 
 #include "DVDDemuxers/DVDDemux.h"
 #include "DVDDemuxers/DVDDemuxUtils.h"
+#include "DVDDemuxers/DVDDemuxPacketPool.h"
 #include "DVDDemuxers/DVDDemuxVobsub.h"
 #include "DVDDemuxers/DVDFactoryDemuxer.h"
 #include "DVDDemuxers/DVDDemuxFFmpeg.h"
@@ -1659,6 +1661,12 @@ void CDVDPlayer::OnExit()
 
     m_messenger.End();
 
+    // give back the packet memory we kept around for playback
+    g_dvdDemuxPacketPool.LogStats();
+    CLog::Log(LOGDEBUG, "CDVDPlayer::OnExit() - messages allocated: %ld, recycled: %ld",
+                        g_dvdPerformanceCounter.m_iMsgAllocated, g_dvdPerformanceCounter.m_iMsgRecycled);
+    g_dvdDemuxPacketPool.Trim();
+
   }
   catch (...)
   {
@@ -3003,6 +3011,26 @@ int CDVDPlayer::GetCacheLevel() const
   return max(a, v);
 }
 
+bool CDVDPlayer::GetCachedSegments(std::vector< std::pair<float, float> >& segments)
+{
+  segments.clear();
+  if (!m_pInputStream || !m_pInputStream->IsStreamType(DVDSTREAM_TYPE_FILE))
+    return false;
+
+  __int64 length = m_pInputStream->GetLength();
+  if (length <= 0)
+    return false;
+
+  std::vector< std::pair<__int64, __int64> > ranges;
+  if (!((CDVDInputStreamFile*)m_pInputStream)->GetCachedRanges(ranges))
+    return false;
+
+  for (unsigned int i = 0; i < ranges.size(); i++)
+    segments.push_back(std::make_pair((float)(100.0 * ranges[i].first / length),
+                                      (float)(100.0 * ranges[i].second / length)));
+  return true;
+}
+
 int CDVDPlayer::GetAudioBitrate()
 {
   return m_dvdPlayerAudio.GetAudioBitrate();
@@ -210,6 +210,7 @@ public:
 
   virtual bool IsCaching() const { return m_caching; }
   virtual int GetCacheLevel() const ; 
+  virtual bool GetCachedSegments(std::vector< std::pair<float, float> >& segments);
 
   static int GetCacheSize();
 
@@ -606,15 +606,47 @@ void CDVDPlayerVideo::Flush()
   m_messageQueue.Put(new CDVDMsg(CDVDMsg::GENERAL_FLUSH));
 }
 
+// adds rect to the list of dirty areas, grown to even edges and merged with
+// any area it touches, so no overlay pixel is ever shared between two areas
+static void AddDirtyRect(std::vector<RECT>& dirty, RECT rect, int width, int height)
+{
+  rect.left   = rect.left & ~1;
+  rect.top    = rect.top & ~1;
+  rect.right  = std::min((int)(rect.right + 1) & ~1, width);
+  rect.bottom = std::min((int)(rect.bottom + 1) & ~1, height);
+  if (rect.right <= rect.left || rect.bottom <= rect.top)
+    return;
+
+  bool bMerged = true;
+  while (bMerged)
+  {
+    bMerged = false;
+    for (std::vector<RECT>::iterator it = dirty.begin(); it != dirty.end(); ++it)
+    {
+      if (it->left < rect.right && rect.left < it->right && it->top < rect.bottom && rect.top < it->bottom)
+      {
+        rect.left   = std::min(rect.left, it->left);
+        rect.top    = std::min(rect.top, it->top);
+        rect.right  = std::max(rect.right, it->right);
+        rect.bottom = std::max(rect.bottom, it->bottom);
+        dirty.erase(it);
+        bMerged = true;
+        break;
+      }
+    }
+  }
+  dirty.push_back(rect);
+}
+
 void CDVDPlayerVideo::ProcessOverlays(DVDVideoPicture* pSource, YV12Image* pDest, double pts)
 {
   // remove any overlays that are out of time
   m_pOverlayContainer->CleanUp(min(pts, pts - m_iSubtitleDelay));
 
   // rendering spu overlay types directly on video memory costs a lot of processing power.
-  // thus we allocate a temp picture, copy the original to it (needed because the same picture can be used more than once).
-  // then do all the rendering on that temp picture and finaly copy it to video memory.
-  // In almost all cases this is 5 or more times faster!.
+  // thus we copy the parts of the frame they cover to a temp picture (needed because the same picture can be used more than once),
+  // do all the rendering on that temp picture and finaly copy those parts to video memory.
+  // the rest of the frame goes straight to video memory, so a subtitle costs a few lines, not two extra frame copies.
   bool bHasSpecialOverlay = m_pOverlayContainer->ContainsOverlayType(DVDOVERLAY_TYPE_SPU) 
                          || m_pOverlayContainer->ContainsOverlayType(DVDOVERLAY_TYPE_IMAGE)
                          || m_pOverlayContainer->ContainsOverlayType(DVDOVERLAY_TYPE_SSA);
@@ -630,15 +662,13 @@ void CDVDPlayerVideo::ProcessOverlays(DVDVideoPicture* pSource, YV12Image* pDest
     if (!m_pTempOverlayPicture) m_pTempOverlayPicture = CDVDCodecUtils::AllocatePicture(pSource->iWidth, pSource->iHeight);
   }
 
-  if (bHasSpecialOverlay && m_pTempOverlayPicture) 
-    CDVDCodecUtils::CopyPicture(m_pTempOverlayPicture, pSource);
-  else 
-    CDVDCodecUtils::CopyPicture(pDest, pSource);
+  CDVDCodecUtils::CopyPicture(pDest, pSource);
   
   m_pOverlayContainer->Lock();
 
   VecOverlays* pVecOverlays = m_pOverlayContainer->GetOverlays();
   VecOverlaysIter it = pVecOverlays->begin();
+  std::vector<std::pair<CDVDOverlay*, double> > overlays;
   
   //Check all overlays and render those that should be rendered, based on time and forced
   //Both forced and subs should check timeing, pts == 0 in the stillframe case
@@ -656,16 +686,34 @@ void CDVDPlayerVideo::ProcessOverlays(DVDVideoPicture* pSource, YV12Image* pDest
     if(pOverlay->iPTSStartTime <= pts2 && (pOverlay->iPTSStopTime >= pts2 || pOverlay->iPTSStopTime == 0LL) || pts == 0)
     {
       if (bHasSpecialOverlay && m_pTempOverlayPicture) 
-        CDVDOverlayRenderer::Render(m_pTempOverlayPicture, pOverlay, pts2);
+        overlays.push_back(std::make_pair(pOverlay, pts2));
       else 
         CDVDOverlayRenderer::Render(pDest, pOverlay, pts2);
     }
   }
+
+  if (overlays.size())
+  {
+    std::vector<RECT> dirty;
+    std::vector<std::pair<CDVDOverlay*, double> >::iterator ov;
+    for (ov = overlays.begin(); ov != overlays.end(); ++ov)
+    {
+      RECT rect;
+      if (CDVDOverlayRenderer::GetBounds(ov->first, pSource->iWidth, pSource->iHeight, ov->second, rect))
+        AddDirtyRect(dirty, rect, pSource->iWidth, pSource->iHeight);
+    }
+
+    for (unsigned int i = 0; i < dirty.size(); i++)
+      CDVDCodecUtils::CopyPictureRect(m_pTempOverlayPicture, pSource, dirty[i]);
+
+    for (ov = overlays.begin(); ov != overlays.end(); ++ov)
+      CDVDOverlayRenderer::Render(m_pTempOverlayPicture, ov->first, ov->second);
+
+    for (unsigned int i = 0; i < dirty.size(); i++)
+      CDVDCodecUtils::CopyPictureRect(pDest, m_pTempOverlayPicture, dirty[i]);
+  }
   
   m_pOverlayContainer->Unlock();
-  
-  if (bHasSpecialOverlay && m_pTempOverlayPicture)
-    CDVDCodecUtils::CopyPicture(pDest, m_pTempOverlayPicture);
 }
 
 int CDVDPlayerVideo::OutputPicture(DVDVideoPicture* pPicture, double pts)
@@ -21,15 +21,13 @@
  
 #include "stdafx.h"
 #include "DVDSubtitleLineCollection.h"
+#include <algorithm>
 
 
 CDVDSubtitleLineCollection::CDVDSubtitleLineCollection()
 {
-  m_pHead = 0;
-  m_pCurrent = 0;
-  m_pTail = 0;
-  
-  m_iSize = 0;
+  m_bSorted = true;
+  m_iCurrent = 0;
   m_fLastPts = 0.0;
 }
 
@@ -40,68 +38,78 @@ CDVDSubtitleLineCollection::~CDVDSubtitleLineCollection()
 
 void CDVDSubtitleLineCollection::Add(CDVDOverlay* pOverlay)
 {
-  ListElement* pElement = new ListElement;
-  pElement->pOverlay = pOverlay;
-  pElement->pNext = 0;
+  // files are mostly in order, sorting is only needed when they're not
+  if (m_cues.size() && pOverlay->iPTSStartTime < m_cues.back()->iPTSStartTime)
+    m_bSorted = false;
 
-  if (!m_pHead)
-  {
-    m_pHead = m_pTail = pElement;
-    m_pCurrent = m_pHead;
-  }
-  else
-  {
-    m_pTail->pNext = pElement;
-    m_pTail = pElement;
-  }
-  
-  m_iSize++;
+  double maxStop = m_maxStop.size() ? std::max(m_maxStop.back(), pOverlay->iPTSStopTime) : pOverlay->iPTSStopTime;
+  m_cues.push_back(pOverlay);
+  m_maxStop.push_back(maxStop);
+}
+
+static bool CompareStartTime(const CDVDOverlay* left, const CDVDOverlay* right)
+{
+  return left->iPTSStartTime < right->iPTSStartTime;
+}
+
+void CDVDSubtitleLineCollection::Sort()
+{
+  std::stable_sort(m_cues.begin(), m_cues.end(), CompareStartTime);
+
+  for (unsigned int i = 0; i < m_cues.size(); i++)
+    m_maxStop[i] = i ? std::max(m_maxStop[i - 1], m_cues[i]->iPTSStopTime) : m_cues[i]->iPTSStopTime;
+
+  m_bSorted = true;
+  m_iCurrent = 0;
+}
+
+int CDVDSubtitleLineCollection::FindFirst(double iPts, int iFrom)
+{
+  // every cue before the first m_maxStop >= iPts has ended
+  int iFirst = std::lower_bound(m_maxStop.begin(), m_maxStop.end(), iPts) - m_maxStop.begin();
+  int i = std::max(iFirst, iFrom);
+
+  // after that, cues that ended early may still sit between ones that haven't
+  while (i < (int)m_cues.size() && m_cues[i]->iPTSStopTime < iPts)
+    i++;
+  return i;
 }
 
 CDVDOverlay* CDVDSubtitleLineCollection::Get(double iPts)
 {
   CDVDOverlay* pOverlay = NULL;
 
+  if (!m_bSorted)
+    Sort();
+
   // If we're suddenly asked to get a subtitle for the past, reset.
   if (iPts < m_fLastPts)
     Reset();
   
-  if (m_pCurrent)
+  m_iCurrent = FindFirst(iPts, m_iCurrent);
+  if (m_iCurrent < (int)m_cues.size())
   {
-    while (m_pCurrent && m_pCurrent->pOverlay->iPTSStopTime < iPts)
-    {
-      m_pCurrent = m_pCurrent->pNext;
-    }
-    
-    if (m_pCurrent)
-    {
-      pOverlay = m_pCurrent->pOverlay;
-
-      // advance to the next overlay
-      m_pCurrent = m_pCurrent->pNext;
-      m_fLastPts = iPts;
-    }
+    pOverlay = m_cues[m_iCurrent];
+
+    // advance to the next overlay
+    m_iCurrent++;
+    m_fLastPts = iPts;
   }
   return pOverlay;
 }
 
 void CDVDSubtitleLineCollection::Reset()
 {
-  m_pCurrent = m_pHead;
+  m_iCurrent = 0;
 }
 
 void CDVDSubtitleLineCollection::Clear()
 {
-  ListElement* pElement = NULL;
-  
-  while (m_pHead)
-  {
-    pElement = m_pHead;
-    m_pHead = pElement->pNext;
+  for (unsigned int i = 0; i < m_cues.size(); i++)
+    m_cues[i]->Release();
 
-    pElement->pOverlay->Release();
-    delete pElement;
-  }
-  
-  m_iSize = 0;
+  m_cues.clear();
+  m_maxStop.clear();
+  m_bSorted = true;
+  m_iCurrent = 0;
 }
@@ -22,14 +22,13 @@
  */
 
 #include "DVDCodecs/Overlay/DVDOverlay.h"
+#include <vector>
 
-typedef struct stListElement
-{
-  CDVDOverlay* pOverlay;
-  struct stListElement* pNext;
-  
-} ListElement;
-
+/*
+ * The cues of a subtitle file, ordered by start time. Next to the cues we keep
+ * the running maximum of their stop times, which only ever grows, so the first
+ * cue still showing at a pts can be found with a binary search on a seek.
+ */
 class CDVDSubtitleLineCollection
 {
 public:
@@ -41,21 +40,23 @@ public:
 
   void Add(CDVDOverlay* pSubtitle);
   
-  CDVDOverlay* Get(double iPts = 0LL); // get the first overlay in this fifo
+  CDVDOverlay* Get(double iPts = 0LL); // get the next overlay that hasn't ended at iPts
 
   void Reset();
 
   void Remove();
   void Clear();
-  int GetSize() { return m_iSize; }
+  int GetSize() { return (int)m_cues.size(); }
   
 private:
-  ListElement* m_pHead;
-  ListElement* m_pTail;
-  ListElement* m_pCurrent;
-  
-  int m_iSize;
+  void Sort();
+  int FindFirst(double iPts, int iFrom); // first cue at or after iFrom that ends at or after iPts
+
+  std::vector<CDVDOverlay*> m_cues;
+  std::vector<double> m_maxStop; // m_maxStop[i] is the latest stop time of cues 0..i
+  bool m_bSorted;
+  int m_iCurrent;
+
   double m_fLastPts;
   //CRITICAL_SECTION m_critSection;
 };
-
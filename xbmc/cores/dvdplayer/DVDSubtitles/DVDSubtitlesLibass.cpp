@@ -155,7 +155,7 @@ long CDVDSubtitlesLibass::GetNrOfReferences()
   return m_references;
 }
 
-ass_image_t* CDVDSubtitlesLibass::RenderImage(int imageWidth, int imageHeight, double pts)
+ass_image_t* CDVDSubtitlesLibass::RenderImage(int imageWidth, int imageHeight, double pts, int* changes)
 {
   if(!m_renderer || !m_track)
   {
@@ -164,7 +164,7 @@ ass_image_t* CDVDSubtitlesLibass::RenderImage(int imageWidth, int imageHeight, d
   }
 
   m_dll.ass_set_frame_size(m_renderer, imageWidth, imageHeight);
-  return m_dll.ass_render_frame(m_renderer, m_track, DVD_TIME_TO_MSEC(pts), NULL);
+  return m_dll.ass_render_frame(m_renderer, m_track, DVD_TIME_TO_MSEC(pts), changes);
 }
 
 ass_event_t* CDVDSubtitlesLibass::GetEvents()
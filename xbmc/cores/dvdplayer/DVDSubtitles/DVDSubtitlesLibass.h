@@ -22,11 +22,30 @@
  */
 
 #include "DllLibass.h"
+#include <vector>
 
 extern "C"{
   #include "../../../lib/libass/ass.h"
 }
 
+/*
+ * The images of the last rendered frame flattened into one layer over their
+ * even aligned bounding box, ready to be blended onto a YV12 picture as
+ *   pixel = premultiplied + pixel * transparency / 255
+ * Chroma is kept at half resolution. Built and blended by CDVDOverlayRenderer.
+ */
+struct SDVDLibassLayer
+{
+  SDVDLibassLayer() : valid(false), width(0), height(0) { memset(&rect, 0, sizeof(rect)); }
+
+  bool valid;
+  int  width;  // frame size it was built for
+  int  height;
+  RECT rect;   // empty when nothing is visible
+  std::vector<BYTE> y, yt;    // premultiplied luma and its transparency, rect sized
+  std::vector<BYTE> u, v, ct; // premultiplied chroma and its transparency, half size
+};
+
 /** Wrapper for Libass **/
 
 class CDVDSubtitlesLibass
@@ -35,7 +54,12 @@ public:
   CDVDSubtitlesLibass();
   ~CDVDSubtitlesLibass();
 
-  ass_image_t* RenderImage(int imageWidth, int imageHeight, double pts);
+  /*
+   * changes, when given, is set as libass' detect_change: 0 when the images
+   * are identical to the previous call, 1 when only moved, 2 when different
+   */
+  ass_image_t* RenderImage(int imageWidth, int imageHeight, double pts, int* changes = NULL);
+  SDVDLibassLayer& GetLayer() { return m_layer; }
   ass_event_t* GetEvents();
 
   int GetNrOfEvents();
@@ -54,5 +78,6 @@ private:
   ass_library_t* m_library;
   ass_track_t* m_track;
   ass_renderer_t* m_renderer;
+  SDVDLibassLayer m_layer;
 };
 
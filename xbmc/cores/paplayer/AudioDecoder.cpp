@@ -24,6 +24,7 @@
 #include "CodecFactory.h"
 #include "GUISettings.h"
 #include "FileItem.h"
+#include "utils/PCMAmplifier.h"
 
 #define INTERNAL_BUFFER_LENGTH  sizeof(float)*2*44100       // float samples, 2 channels, 44100 samples per sec = 1 second
 
@@ -257,14 +258,7 @@ void CAudioDecoder::ProcessAudio(float *data, int numsamples)
 {
   if (g_guiSettings.m_replayGain.iType != REPLAY_GAIN_NONE)
   {
-    float gainFactor = GetReplayGain();
-    for (int i = 0; i < numsamples; i++)
-    {
-      data[i] *= gainFactor;
-      // check the range (is this needed here?)
-      if (data[i] > 1.0f) data[i] = 1.0f;
-      if (data[i] < -1.0f) data[i] = -1.0f;
-    }
+    CPCMAmplifier::GainFloat32(data, numsamples, GetReplayGain());
   }
 }
 
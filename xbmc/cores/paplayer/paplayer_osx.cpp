@@ -934,7 +934,7 @@ bool PAPlayer::AddPacketsToStream(int stream, CAudioDecoder &dec)
 			StreamCallback(&m_packet[stream][0]);			
 			
 			// Handle volume de-amp
-			m_amp[stream].DeAmplifyFloat32(pcmPtr, PACKET_SIZE / currentStream->mChannelsPerFrame);
+			m_amp[stream].DeAmplifyFloat32(pcmPtr, amount);
 			
 			// Write the data.
 			m_pStream[stream]->WriteStream((uint8_t *)pcmPtr, PACKET_SIZE/currentStream->mBytesPerFrame);
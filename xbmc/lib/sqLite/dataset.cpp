@@ -302,9 +302,7 @@ bool Dataset::set_field_value(const char *f_name, const field_value &value) {
 }
 
 
-const field_value Dataset::get_field_value(const char *f_name) {
-  const char* name=strstr(f_name, ".");
-  if (name) name++;
+const field_value &Dataset::get_field_value(const char *f_name) {
   if (ds_state != dsInactive) {
     if (ds_state == dsEdit || ds_state == dsInsert){
       for (unsigned int i=0; i < edit_object->size(); i++)
@@ -313,30 +311,24 @@ const field_value Dataset::get_field_value(const char *f_name) {
 			}
       throw DbErrors("Field not found: %s",f_name);
        }
-    else
-      for (unsigned int i=0; i < fields_object->size(); i++) 
-			if (str_compare((*fields_object)[i].props.name.c_str(), f_name)==0 || (name && str_compare((*fields_object)[i].props.name.c_str(), name)==0)) {
-	  			return (*fields_object)[i].val;
-			}
-      throw DbErrors("Field not found: %s",f_name);
+    int index = fieldIndex(f_name);
+    if (index >= 0)
+      return (*fields_object)[index].val;
+    throw DbErrors("Field not found: %s",f_name);
        }
   throw DbErrors("Dataset state is Inactive");
   //field_value fv;
   //return fv;
 }
 
-const field_value Dataset::get_field_value(int index) {
+const field_value &Dataset::get_field_value(int index) {
   if (ds_state != dsInactive) {
-    if (ds_state == dsEdit || ds_state == dsInsert){
-      if (index <0 || index >field_count())
-        throw DbErrors("Field index not found: %d",index);
+    if (index < 0 || index >= field_count())
+      throw DbErrors("Field index not found: %d",index);
 
+    if (ds_state == dsEdit || ds_state == dsInsert)
       return (*edit_object)[index].val;
-    }
     else
-      if (index <0 || index >field_count())
-        throw DbErrors("Field index not found: %d",index);
-
       return (*fields_object)[index].val;
   }
   throw DbErrors("Dataset state is Inactive");
@@ -354,18 +346,13 @@ const field_value Dataset::f_old(const char *f_name) {
 }
 
 int Dataset::str_compare(const char * s1, const char * s2) {
- 	string ts1 = s1; 
- 	string ts2 = s2;
- 	string::const_iterator p = ts1.begin();
- 	string::const_iterator p2 = ts2.begin();
- 	while (p!=ts1.end() && p2 != ts2.end()) {
- 	if (toupper(*p)!=toupper(*p2))
- 		return (toupper(*p)<toupper(*p2)) ? -1 : 1;
- 		++p;
- 		++p2;		
- 	}	
- 	return (ts2.size() == ts1.size())? 0:
- 		(ts1.size()<ts2.size())? -1 : 1;
+  for (; *s1 && *s2; ++s1, ++s2) {
+    int c1 = toupper((unsigned char)*s1);
+    int c2 = toupper((unsigned char)*s2);
+    if (c1 != c2)
+      return (c1 < c2) ? -1 : 1;
+  }
+  return (*s1 == *s2) ? 0 : (*s1 ? 1 : -1);
  }
 
 
@@ -477,9 +464,14 @@ int Dataset::fieldSize(int n) {
 }
 
 int Dataset::fieldIndex(const char *fn) {
-for (unsigned int i=0; i < fields_object->size(); i++)
-      if ((*fields_object)[i].props.name == fn)
-	return i;
+  // "table.field" also matches a column that is just named "field"
+  const char* name=strstr(fn, ".");
+  if (name) name++;
+  for (unsigned int i=0; i < fields_object->size(); i++) {
+    const char *field = (*fields_object)[i].props.name.c_str();
+    if (str_compare(field, fn)==0 || (name && str_compare(field, name)==0))
+      return i;
+  }
   return -1;
 }
 
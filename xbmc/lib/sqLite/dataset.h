@@ -265,6 +265,15 @@ public:
   virtual const void* getExecRes()=0;
 /* as open, but with our query exept Sql */
   virtual bool query(const char *sql) = 0;
+/* as query, with params bound in order to the ? placeholders of sql */
+  virtual bool query(const char *sql, const sql_record &params) = 0;
+/* forward only query: rows are read from the database as next() moves on instead of
+   all being fetched up front. num_rows() only counts the rows read so far (0 still
+   means an empty result), prev(), last() and seek() are not possible */
+  virtual bool query_forward(const char *sql) = 0;
+  virtual bool query_forward(const char *sql, const sql_record &params) = 0;
+/* as exec, with params bound in order to the ? placeholders of sql */
+  virtual int  exec (const std::string &sql, const sql_record &params) = 0;
 /* Close SQL Query*/
   virtual void close();
 /* This function looks for field Field_name with value equal Field_value
@@ -319,7 +328,8 @@ public:
   virtual int fieldCount();
 /* func. retrieves a field name with 'n' index */
   virtual const char *fieldName(int n);
-/* func. retrieves a field index with 'fn' field name,return -1 when field name not found */
+/* func. retrieves a field index with 'fn' field name,return -1 when field name not found.
+   looking the index up once is cheaper than calling fv() by name for every row */
   virtual int  fieldIndex(const char *fn);
 /* func. retrieves a field size */
   virtual int  fieldSize(int n);
@@ -336,11 +346,11 @@ public:
 //  virtual char *field_name(int f_index) { return field_by_index(f_index)->get_field_name(); };
 
 /* Getting value of field for current record */
-  virtual const field_value get_field_value(const char *f_name);
-  virtual const field_value get_field_value(int index);
+  virtual const field_value &get_field_value(const char *f_name);
+  virtual const field_value &get_field_value(int index);
 /* Alias to get_field_value */
-  const field_value fv(const char *f) { return get_field_value(f); }
-  const field_value fv(int index) { return get_field_value(index); }
+  const field_value &fv(const char *f) { return get_field_value(f); }
+  const field_value &fv(int index) { return get_field_value(index); }
 
 /* ------------ for transaction ------------------- */
   void set_autocommit(bool v) { autocommit = v; }
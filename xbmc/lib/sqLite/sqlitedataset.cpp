@@ -80,6 +80,51 @@ int callback(void* res_ptr,int ncol, char** reslt,char** cols)
   return 0;  
 }
 
+static void get_column(sqlite3_stmt *stmt, int i, field_value &v)
+{
+  switch (sqlite3_column_type(stmt, i))
+  {
+  case SQLITE_INTEGER:
+    v.set_asInt64(sqlite3_column_int64(stmt, i));
+    break;
+  case SQLITE_FLOAT:
+    v.set_asDouble(sqlite3_column_double(stmt, i));
+    break;
+  case SQLITE_TEXT:
+    v.set_asString((const char *)sqlite3_column_text(stmt, i));
+    break;
+  case SQLITE_BLOB:
+    v.set_asString((const char *)sqlite3_column_text(stmt, i));
+    break;
+  case SQLITE_NULL:
+  default:
+    // the null flag isn't carried over to the fields, and would stick to a reused field_value
+    v.set_asString("");
+    break;
+  }
+}
+
+static int bind_param(sqlite3_stmt *stmt, int i, const field_value &v)
+{
+  if (v.get_isNull())
+    return sqlite3_bind_null(stmt, i);
+
+  switch (v.get_fType())
+  {
+  case ft_String:
+  {
+    std::string str = v.get_asString();
+    return sqlite3_bind_text(stmt, i, str.c_str(), str.size(), SQLITE_TRANSIENT);
+  }
+  case ft_Float:
+  case ft_Double:
+  case ft_LongDouble:
+    return sqlite3_bind_double(stmt, i, v.get_asDouble());
+  default:
+    return sqlite3_bind_int64(stmt, i, v.get_asInt64());
+  }
+}
+
 static int busy_callback(void*, int busyCount)
 {
 	Sleep(100);
@@ -93,6 +138,8 @@ SqliteDatabase::SqliteDatabase() {
 
   active = false;	
   _in_transaction = false;		// for transaction
+  conn = NULL;
+  stmt_clock = 0;
 
   error = "Unknown database error";//S_NO_CONNECTION;
   host = "localhost";
@@ -199,6 +246,7 @@ int SqliteDatabase::connect() {
 
 void SqliteDatabase::disconnect(void) {
   if (active == false) return;
+  clear_statements();
   sqlite3_close(conn);
   active = false;
 }
@@ -267,6 +315,77 @@ void SqliteDatabase::rollback_transaction() {
 
 
 
+// prepared statement cache
+// ---------------------------------------------
+sqlite3_stmt *SqliteDatabase::prepare(const char *sql) {
+  if (!active) throw DbErrors("No Database Connection");
+
+  StmtCache::iterator it = stmt_cache.find(sql);
+  if (it != stmt_cache.end() && !it->second.in_use) {
+    it->second.in_use = true;
+    it->second.last_used = ++stmt_clock;
+    return it->second.stmt;
+  }
+
+  sqlite3_stmt *stmt = NULL;
+#ifdef __APPLE__
+  if (setErr(sqlite3_prepare(conn,sql,-1,&stmt, NULL),sql) != SQLITE_OK)
+#else
+  if (setErr(sqlite3_prepare_v2(conn,sql,-1,&stmt, NULL),sql) != SQLITE_OK)
+#endif
+    throw DbErrors(getErrorMsg());
+
+  // sql without parameters is mostly formatted for one use, caching it would only push
+  // out the statements that are reused. the same sql running in a second dataset at the
+  // same time isn't cached either, release() finalizes those
+  if (sqlite3_bind_parameter_count(stmt) == 0 || it != stmt_cache.end())
+    return stmt;
+
+  if (stmt_cache.size() >= SQLITE_STATEMENT_CACHE_SIZE) {
+    StmtCache::iterator oldest = stmt_cache.end();
+    for (StmtCache::iterator i = stmt_cache.begin(); i != stmt_cache.end(); i++)
+      if (!i->second.in_use && (oldest == stmt_cache.end() || i->second.last_used < oldest->second.last_used))
+        oldest = i;
+    if (oldest == stmt_cache.end())
+      return stmt;
+    sqlite3_finalize(oldest->second.stmt);
+    stmt_cache.erase(oldest);
+  }
+
+  cached_stmt entry;
+  entry.stmt = stmt;
+  entry.in_use = true;
+  entry.last_used = ++stmt_clock;
+  stmt_cache.insert(make_pair(string(sql), entry));
+  return stmt;
+}
+
+void SqliteDatabase::release(const char *sql, sqlite3_stmt *stmt, bool discard) {
+  StmtCache::iterator it = stmt_cache.find(sql);
+  if (it == stmt_cache.end() || it->second.stmt != stmt) {
+    sqlite3_finalize(stmt);
+    return;
+  }
+
+  if (discard) {
+    sqlite3_finalize(stmt);
+    stmt_cache.erase(it);
+  }
+  else {
+    // drops the read lock the statement holds, keeps the compiled program
+    sqlite3_reset(stmt);
+    it->second.in_use = false;
+  }
+}
+
+void SqliteDatabase::clear_statements() {
+  for (StmtCache::iterator it = stmt_cache.begin(); it != stmt_cache.end(); it++)
+    sqlite3_finalize(it->second.stmt);
+  stmt_cache.clear();
+}
+
+
+
 //************* SqliteDataset implementation ***************
 
 SqliteDataset::SqliteDataset():Dataset() {
@@ -274,6 +393,8 @@ SqliteDataset::SqliteDataset():Dataset() {
   db = NULL;
   errmsg = NULL;
   autorefresh = false;
+  cursor = NULL;
+  forward_only = false;
 }
 
 
@@ -282,9 +403,12 @@ SqliteDataset::SqliteDataset(SqliteDatabase *newDb):Dataset(newDb) {
   db = newDb;
   errmsg = NULL;
   autorefresh = false;
+  cursor = NULL;
+  forward_only = false;
 }
 
  SqliteDataset::~SqliteDataset(){
+   close_cursor();
    if (errmsg) sqlite3_free(errmsg);
  }
 
@@ -304,6 +428,52 @@ sqlite3* SqliteDataset::handle(){
   else return NULL;
 }
 
+void SqliteDataset::open_cursor(const char *sql, const sql_record &params) {
+  close_cursor();
+  cursor = sqlite_db()->prepare(sql);
+  cursor_sql = sql;
+
+  if (sqlite3_bind_parameter_count(cursor) != (int)params.size()) {
+    close_cursor();
+    throw DbErrors("Query needs %d parameters, %d given: %s", sqlite3_bind_parameter_count(cursor), (int)params.size(), sql);
+  }
+  for (unsigned int i = 0; i < params.size(); i++) {
+    if (db->setErr(bind_param(cursor, i + 1, params[i]), sql) != SQLITE_OK) {
+      close_cursor();
+      throw DbErrors(db->getErrorMsg());
+    }
+  }
+}
+
+void SqliteDataset::close_cursor(bool discard) {
+  if (!cursor) return;
+  // statements are finalized along with the connection
+  if (db && db->isActive())
+    sqlite_db()->release(cursor_sql.c_str(), cursor, discard);
+  cursor = NULL;
+}
+
+int SqliteDataset::step_cursor(const sql_record *params) {
+  int res = sqlite3_step(cursor);
+  if (res == SQLITE_ROW || res == SQLITE_DONE)
+    return res;
+
+  // the legacy interface only has the real error after the reset
+  res = sqlite3_reset(cursor);
+  if (res == SQLITE_SCHEMA && params) {
+    // a cached statement compiled before the schema changed, compile it again
+    string sql = cursor_sql;
+    close_cursor(true);
+    open_cursor(sql.c_str(), *params);
+    return step_cursor();
+  }
+
+  string sql = cursor_sql;
+  close_cursor(true);
+  db->setErr(res == SQLITE_OK ? SQLITE_ERROR : res, sql.c_str());
+  throw DbErrors(db->getErrorMsg());
+}
+
 void SqliteDataset::make_query(StringList &_sql) {
   string query;
 
@@ -377,14 +547,12 @@ void SqliteDataset::fill_fields() {
     const sql_record *row = result.records[frecno];
     if (row)
     {
+      // edit_object only gets the values once edit() is called
       const unsigned int ncols = row->size();
       fields_object->resize(ncols);
       edit_object->resize(ncols);
       for (unsigned int i = 0; i < ncols; i++)
-      {
         (*fields_object)[i].val = row->at(i);
-        (*edit_object)[i].val = row->at(i);
-      }
       return;
     }
   }
@@ -413,6 +581,31 @@ int SqliteDataset::exec(const string &sql) {
     }
 }
 
+int SqliteDataset::exec(const string &sql, const sql_record &params) {
+  if (!handle()) throw DbErrors("No Database Connection");
+  exec_res.clear();
+
+  // runs on its own statement so an open forward only query is not disturbed
+  sqlite3_stmt *save_cursor = cursor;
+  string save_sql = cursor_sql;
+  cursor = NULL;
+  try {
+    open_cursor(sql.c_str(), params);
+    int res = step_cursor(&params);
+    while (res == SQLITE_ROW)
+      res = step_cursor();
+    close_cursor();
+  }
+  catch (...) {
+    cursor = save_cursor;
+    cursor_sql = save_sql;
+    throw;
+  }
+  cursor = save_cursor;
+  cursor_sql = save_sql;
+  return SQLITE_OK;
+}
+
 int SqliteDataset::exec() {
 	return exec(sql);
 }
@@ -422,7 +615,7 @@ const void* SqliteDataset::getExecRes() {
 }
 
 
-bool SqliteDataset::query(const char *query) {
+bool SqliteDataset::run_query(const char *query, const sql_record &params, bool forward) {
     if(!handle()) throw DbErrors("No Database Connection");
     std::string qry = query;
     int fs = qry.find("select");
@@ -432,68 +625,77 @@ bool SqliteDataset::query(const char *query) {
 
   close();
 
-  sqlite3_stmt *stmt = NULL;
-#ifdef __APPLE__
-  if (db->setErr(sqlite3_prepare(handle(),query,-1,&stmt, NULL),query) != SQLITE_OK)
-#else
-  if (db->setErr(sqlite3_prepare_v2(handle(),query,-1,&stmt, NULL),query) != SQLITE_OK)
-#endif
-    throw DbErrors(db->getErrorMsg());
+  open_cursor(query, params);
+  int res = step_cursor(&params);
 
   // column headers
-  const unsigned int numColumns = sqlite3_column_count(stmt);
+  const unsigned int numColumns = sqlite3_column_count(cursor);
   result.record_header.resize(numColumns);
   for (unsigned int i = 0; i < numColumns; i++)
-    result.record_header[i].name = sqlite3_column_name(stmt, i);
+    result.record_header[i].name = sqlite3_column_name(cursor, i);
 
-  // returned rows
-  while (sqlite3_step(stmt) == SQLITE_ROW)
-  { // have a row of data
-    sql_record *res = new sql_record;
-    res->resize(numColumns);
+  active = true;
+  ds_state = dsSelect;
+
+  if (forward)
+  {
+    // rows are filled straight from the statement as the dataset moves
+    forward_only = true;
+    fields_object->resize(numColumns);
+    edit_object->resize(numColumns);
     for (unsigned int i = 0; i < numColumns; i++)
     {
-      field_value &v = res->at(i);
-      switch (sqlite3_column_type(stmt, i))
-      {
-      case SQLITE_INTEGER:
-        v.set_asInt64(sqlite3_column_int64(stmt, i));
-        break;
-      case SQLITE_FLOAT:
-        v.set_asDouble(sqlite3_column_double(stmt, i));
-        break;
-      case SQLITE_TEXT:
-        v.set_asString((const char *)sqlite3_column_text(stmt, i));
-        break;
-      case SQLITE_BLOB:
-        v.set_asString((const char *)sqlite3_column_text(stmt, i));
-        break;
-      case SQLITE_NULL:
-      default:
-        v.set_asString("");
-        v.set_isNull();
-        break;
-      }
+      (*fields_object)[i].props = result.record_header[i];
+      (*edit_object)[i].props = result.record_header[i];
     }
-    result.records.push_back(res);
-  }
-  if (db->setErr(sqlite3_finalize(stmt),query) == SQLITE_OK)
-  {
-    active = true;
-    ds_state = dsSelect;
-    this->first();
+    frecno = 0;
+    fbof = feof = (res != SQLITE_ROW);
+    if (res == SQLITE_ROW)
+    {
+      for (unsigned int i = 0; i < numColumns; i++)
+        get_column(cursor, i, (*fields_object)[i].val);
+    }
+    else
+      close_cursor();
     return true;
   }
-  else
-  {
-    throw DbErrors(db->getErrorMsg());
-  }  
+
+  // returned rows
+  while (res == SQLITE_ROW)
+  { // have a row of data
+    sql_record *rec = new sql_record;
+    rec->resize(numColumns);
+    for (unsigned int i = 0; i < numColumns; i++)
+      get_column(cursor, i, rec->at(i));
+    result.records.push_back(rec);
+    res = step_cursor();
+  }
+  close_cursor();
+
+  this->first();
+  return true;
+}
+
+bool SqliteDataset::query(const char *query) {
+  return run_query(query, sql_record(), false);
 }
 
 bool SqliteDataset::query(const string &q){
   return query(q.c_str());
 }
 
+bool SqliteDataset::query(const char *query, const sql_record &params) {
+  return run_query(query, params, false);
+}
+
+bool SqliteDataset::query_forward(const char *query) {
+  return run_query(query, sql_record(), true);
+}
+
+bool SqliteDataset::query_forward(const char *query, const sql_record &params) {
+  return run_query(query, params, true);
+}
+
 void SqliteDataset::open(const string &sql) {
 	set_select_sql(sql);
 	open();
@@ -510,6 +712,8 @@ void SqliteDataset::open() {
 
 
 void SqliteDataset::close() {
+  close_cursor();
+  forward_only = false;
   Dataset::close();
   result.clear();
   edit_object->clear();
@@ -527,6 +731,8 @@ void SqliteDataset::cancel() {
 
 
 int SqliteDataset::num_rows() {
+  if (forward_only)
+    return feof ? frecno : frecno + 1;
   return result.records.size();
 }
 
@@ -542,21 +748,43 @@ bool SqliteDataset::bof() {
 
 
 void SqliteDataset::first() {
+  if (forward_only) {
+    if (frecno > 0) throw DbErrors("Forward only query can't move back to the first row");
+    return;
+  }
   Dataset::first();
   this->fill_fields();
 }
 
 void SqliteDataset::last() {
+  if (forward_only) throw DbErrors("Forward only query can't move to the last row");
   Dataset::last();
   fill_fields();
 }
 
 void SqliteDataset::prev(void) {
+  if (forward_only) throw DbErrors("Forward only query can't move back");
   Dataset::prev();
   fill_fields();
 }
 
 void SqliteDataset::next(void) {
+  if (forward_only) {
+    if (feof) return;
+    fbof = false;
+    frecno++;
+    if (step_cursor() == SQLITE_ROW) {
+      const unsigned int ncols = fields_object->size();
+      for (unsigned int i = 0; i < ncols; i++)
+        get_column(cursor, i, (*fields_object)[i].val);
+    }
+    else {
+      // done, hand the statement back right away
+      feof = true;
+      close_cursor();
+    }
+    return;
+  }
 #ifdef _XBOX
   free_row();
 #endif
@@ -579,6 +807,7 @@ void SqliteDataset::free_row(void)
 }
 
 bool SqliteDataset::seek(int pos) {
+  if (forward_only) throw DbErrors("Forward only query can't seek");
   if (ds_state == dsSelect) {
     Dataset::seek(pos);
     fill_fields();
@@ -30,6 +30,7 @@
 #define _SQLITEDATASET_H
 
 #include <stdio.h>
+#include <map>
 #include "dataset.h"
 #ifndef _LINUX
 #include "sqlite3.h"
@@ -38,6 +39,9 @@
 #endif
 
 namespace dbiplus {
+/* upper limit of prepared statements kept per connection */
+#define SQLITE_STATEMENT_CACHE_SIZE 32
+
 /***************** Class SqliteDatabase definition ******************
 
        class 'SqliteDatabase' connects with Sqlite-server
@@ -50,6 +54,16 @@ protected:
   bool _in_transaction;
   int last_err;
 
+/* prepared statements by their sql text */
+  struct cached_stmt {
+    sqlite3_stmt *stmt;
+    bool in_use;
+    unsigned int last_used;
+  };
+  typedef std::map<std::string, cached_stmt> StmtCache;
+  StmtCache stmt_cache;
+  unsigned int stmt_clock;
+
 public:
 /* default constructor */
   SqliteDatabase();
@@ -85,6 +99,15 @@ public:
 
   bool in_transaction() {return _in_transaction;}; 	
 
+/* returns a prepared statement for sql. statements with ? parameters are cached, so
+   they are compiled only the first time sql is seen. each statement must be handed
+   back with release() when done */
+  sqlite3_stmt *prepare(const char *sql);
+/* resets the statement for the next prepare(), discard drops it from the cache */
+  void release(const char *sql, sqlite3_stmt *stmt, bool discard = false);
+/* finalizes all cached statements */
+  void clear_statements();
+
 };
 
 
@@ -102,8 +125,22 @@ protected:
   result_set exec_res;
   bool autorefresh;
   char* errmsg;
+
+/* statement being stepped, stays open while a forward only query has rows left */
+  sqlite3_stmt *cursor;
+  std::string cursor_sql;
+  bool forward_only;
   
   sqlite3* handle();
+  SqliteDatabase* sqlite_db() { return static_cast<SqliteDatabase*>(db); }
+
+/* prepares sql as the cursor and binds params */
+  void open_cursor(const char *sql, const sql_record &params);
+  void close_cursor(bool discard = false);
+/* steps the cursor, returns SQLITE_ROW or SQLITE_DONE and throws on errors.
+   with params set the statement is compiled again if the schema changed */
+  int step_cursor(const sql_record *params = NULL);
+  bool run_query(const char *sql, const sql_record &params, bool forward);
 
 /* Makes direct queries to database */
   virtual void make_query(StringList &_sql);
@@ -140,10 +177,14 @@ or insert() operations default = false) */
 /* func. executes a query without results to return */
   virtual int  exec ();
   virtual int  exec (const std::string &sql);
+  virtual int  exec (const std::string &sql, const sql_record &params);
   virtual const void* getExecRes();
 /* as open, but with our query exept Sql */
   virtual bool query(const char *query);
   virtual bool query(const std::string &query);
+  virtual bool query(const char *query, const sql_record &params);
+  virtual bool query_forward(const char *query);
+  virtual bool query_forward(const char *query, const sql_record &params);
 /* func. closes a query */
   virtual void close(void);
 /* Cancel changes, made in insert or edit states of dataset */
@@ -36,6 +36,22 @@ CArchive::CArchive(CFile* pFile, int mode)
   memset(m_pBuffer, 0, sizeof(m_pBuffer));
 
   m_BufferPos = 0;
+
+  m_pReadBuffer = NULL;
+  m_iReadSize = 0;
+  m_iReadPos = 0;
+}
+
+CArchive::CArchive(const BYTE* pBuffer, unsigned int iSize)
+{
+  m_pFile = NULL;
+  m_iMode = load;
+  m_pBuffer = NULL;
+  m_BufferPos = 0;
+
+  m_pReadBuffer = pBuffer;
+  m_iReadSize = iSize;
+  m_iReadPos = 0;
 }
 
 CArchive::~CArchive()
@@ -227,66 +243,65 @@ CArchive& CArchive::operator<<(ISerializable& obj)
 
 CArchive& CArchive::operator>>(float& f)
 {
-  m_pFile->Read((void*)&f, sizeof(float));
+  ReadBytes((void*)&f, sizeof(float));
 
   return *this;
 }
 
 CArchive& CArchive::operator>>(double& d)
 {
-  m_pFile->Read((void*)&d, sizeof(double));
+  ReadBytes((void*)&d, sizeof(double));
 
   return *this;
 }
 
 CArchive& CArchive::operator>>(int& i)
 {
-  m_pFile->Read((void*)&i, sizeof(int));
+  ReadBytes((void*)&i, sizeof(int));
 
   return *this;
 }
 
 CArchive& CArchive::operator>>(unsigned int& i)
 {
-  m_pFile->Read((void*)&i, sizeof(unsigned int));
+  ReadBytes((void*)&i, sizeof(unsigned int));
 
   return *this;
 }
 
 CArchive& CArchive::operator>>(__int64& i64)
 {
-  m_pFile->Read((void*)&i64, sizeof(__int64));
+  ReadBytes((void*)&i64, sizeof(__int64));
 
   return *this;
 }
 
 CArchive& CArchive::operator>>(long& l)
 {
-  m_pFile->Read((void*)&l, sizeof(long));
+  ReadBytes((void*)&l, sizeof(long));
 
   return *this;
 }
 
 CArchive& CArchive::operator>>(bool& b)
 {
-  m_pFile->Read((void*)&b, sizeof(bool));
+  ReadBytes((void*)&b, sizeof(bool));
 
   return *this;
 }
 
 CArchive& CArchive::operator>>(char& c)
 {
-  m_pFile->Read((void*)&c, sizeof(char));
+  ReadBytes((void*)&c, sizeof(char));
 
   return *this;
 }
 
 CArchive& CArchive::operator>>(CStdString& str)
 {
-  int iLength = 0;
-  *this >> iLength;
+  int iLength = ReadLength();
 
-  m_pFile->Read((void*)str.GetBufferSetLength(iLength), iLength);
+  ReadBytes((void*)str.GetBufferSetLength(iLength), iLength);
   str.ReleaseBuffer();
 
 
@@ -295,10 +310,9 @@ CArchive& CArchive::operator>>(CStdString& str)
 
 CArchive& CArchive::operator>>(CStdStringW& str)
 {
-  int iLength = 0;
-  *this >> iLength;
+  int iLength = ReadLength();
 
-  m_pFile->Read((void*)str.GetBufferSetLength(iLength), iLength);
+  ReadBytes((void*)str.GetBufferSetLength(iLength), iLength);
   str.ReleaseBuffer();
 
 
@@ -307,7 +321,7 @@ CArchive& CArchive::operator>>(CStdStringW& str)
 
 CArchive& CArchive::operator>>(SYSTEMTIME& time)
 {
-  m_pFile->Read((void*)&time, sizeof(SYSTEMTIME));
+  ReadBytes((void*)&time, sizeof(SYSTEMTIME));
 
   return *this;
 }
@@ -319,9 +333,41 @@ CArchive& CArchive::operator>>(ISerializable& obj)
   return *this;
 }
 
+int CArchive::ReadLength()
+{
+  int iLength = 0;
+  *this >> iLength;
+
+  // a damaged archive can hold any length, never allocate more than is left in the buffer
+  if (iLength < 0)
+    iLength = 0;
+  if (m_pReadBuffer && (unsigned int)iLength > m_iReadSize - m_iReadPos)
+    iLength = m_iReadSize - m_iReadPos;
+  return iLength;
+}
+
+void CArchive::ReadBytes(void* pBuf, unsigned int iSize)
+{
+  if (!m_pReadBuffer)
+  {
+    m_pFile->Read(pBuf, iSize);
+    return;
+  }
+
+  unsigned int iAvail = m_iReadSize - m_iReadPos;
+  if (iSize > iAvail)
+  {
+    // truncated archive, hand out zeroes rather than reading past the buffer
+    memset((BYTE*)pBuf + iAvail, 0, iSize - iAvail);
+    iSize = iAvail;
+  }
+  memcpy(pBuf, m_pReadBuffer + m_iReadPos, iSize);
+  m_iReadPos += iSize;
+}
+
 void CArchive::FlushBuffer()
 {
-  if (m_BufferPos > 0)
+  if (m_BufferPos > 0 && m_pFile)
   {
     m_pFile->Write(m_pBuffer, m_BufferPos);
     m_BufferPos = 0;
@@ -41,6 +41,8 @@ class CArchive
 {
 public:
   CArchive(XFILE::CFile* pFile, int mode);
+  // loads from a buffer already in memory, which must outlive the archive
+  CArchive(const BYTE* pBuffer, unsigned int iSize);
   ~CArchive();
   // storing
   CArchive& operator<<(float f);
@@ -79,9 +81,15 @@ public:
 
 protected:
   void FlushBuffer();
+  int ReadLength();
+  void ReadBytes(void* pBuf, unsigned int iSize);
   XFILE::CFile* m_pFile;
   int m_iMode;
   LPBYTE m_pBuffer;
   int m_BufferPos;
+
+  const BYTE* m_pReadBuffer;
+  unsigned int m_iReadSize;
+  unsigned int m_iReadPos;
 };
 
@@ -95,6 +95,8 @@ void CGUIInfoManager::CCombinedValue::operator =(const CGUIInfoManager::CCombine
   this->m_info = mSrc.m_info;
   this->m_id = mSrc.m_id;
   this->m_postfix = mSrc.m_postfix;
+  this->m_code = mSrc.m_code;
+  this->m_listItem = mSrc.m_listItem;
 }
 
 CGUIInfoManager::CGUIInfoManager(void)
@@ -1735,6 +1737,10 @@ int CGUIInfoManager::GetInt(int info, DWORD contextWindow) const
 // for toggle button controls and visibility of images.
 bool CGUIInfoManager::GetBool(int condition1, DWORD dwContextWindow, const CGUIListItem *item)
 {
+  // conditions that don't look at the item are the same for all items, so they can be cached
+  if (item && !DependsOnItem(condition1))
+    item = NULL;
+
   // check our cache
   bool bReturn = false;
   if (!item && IsCached(condition1, dwContextWindow, bReturn)) // never use cache for list items
@@ -3445,43 +3451,133 @@ int CGUIInfoManager::GetOperator(const char ch)
     return 0;
 }
 
-bool CGUIInfoManager::EvaluateBooleanExpression(const CCombinedValue &expression, bool &result, DWORD dwContextWindow, const CGUIListItem *item)
+// instructions of a compiled boolean expression, each is an opcode followed by one argument.
+// the expression is evaluated into a single result, so no stack is needed.
+#define BOOL_OP_LOAD           0  // result = GetBool(argument)
+#define BOOL_OP_NOT            1  // result = !result
+#define BOOL_OP_JUMP_IF_FALSE  2  // continue at instruction argument if result is false
+#define BOOL_OP_JUMP_IF_TRUE   3  // continue at instruction argument if result is true
+
+// node of the expression tree built from the postfix form while compiling
+struct SBoolNode
+{
+  int op;     // -OPERATOR_* or the condition of an operand
+  int left;   // operand nodes, -1 if none
+  int right;
+};
+
+static void EmitBooleanExpression(const vector<SBoolNode> &nodes, int index, vector<int> &code)
+{
+  const SBoolNode &node = nodes[index];
+  if (node.op == -OPERATOR_NOT)
+  { // not folded into a negative condition, GetBool() doesn't negate every range exactly once
+    EmitBooleanExpression(nodes, node.left, code);
+    code.push_back(BOOL_OP_NOT);
+    code.push_back(0);
+  }
+  else if (node.op == -OPERATOR_AND || node.op == -OPERATOR_OR)
+  { // the right side is skipped once the left side decides the result
+    EmitBooleanExpression(nodes, node.left, code);
+    code.push_back(node.op == -OPERATOR_AND ? BOOL_OP_JUMP_IF_FALSE : BOOL_OP_JUMP_IF_TRUE);
+    code.push_back(0);
+    unsigned int jump = code.size() - 1;
+    EmitBooleanExpression(nodes, node.right, code);
+    code[jump] = code.size();
+  }
+  else
+  {
+    code.push_back(BOOL_OP_LOAD);
+    code.push_back(node.op);
+  }
+}
+
+bool CGUIInfoManager::CompileBooleanExpression(CCombinedValue &expression)
 {
-  // stack to save our bool state as we go
-  stack<bool> save;
+  expression.m_code.clear();
+  expression.m_listItem = false;
 
+  vector<SBoolNode> nodes;
+  stack<int> operands;
   for (list<int>::const_iterator it = expression.m_postfix.begin(); it != expression.m_postfix.end(); ++it)
   {
-    int expr = *it;
-    if (expr == -OPERATOR_NOT)
-    { // NOT the top item on the stack
-      if (save.size() < 1) return false;
-      bool expr = save.top();
-      save.pop();
-      save.push(!expr);
+    SBoolNode node = { *it, -1, -1 };
+    if (node.op == -OPERATOR_NOT)
+    {
+      if (operands.size() < 1) return false;
+      node.left = operands.top(); operands.pop();
     }
-    else if (expr == -OPERATOR_AND)
-    { // AND the top two items on the stack
-      if (save.size() < 2) return false;
-      bool right = save.top(); save.pop();
-      bool left = save.top(); save.pop();
-      save.push(left && right);
+    else if (node.op == -OPERATOR_AND || node.op == -OPERATOR_OR)
+    {
+      if (operands.size() < 2) return false;
+      node.right = operands.top(); operands.pop();
+      node.left = operands.top(); operands.pop();
     }
-    else if (expr == -OPERATOR_OR)
-    { // OR the top two items on the stack
-      if (save.size() < 2) return false;
-      bool right = save.top(); save.pop();
-      bool left = save.top(); save.pop();
-      save.push(left || right);
+    else if (DependsOnItem(node.op))
+      expression.m_listItem = true;
+
+    nodes.push_back(node);
+    operands.push(nodes.size() - 1);
+  }
+  if (operands.size() != 1) return false;
+
+  EmitBooleanExpression(nodes, operands.top(), expression.m_code);
+  return true;
+}
+
+bool CGUIInfoManager::EvaluateBooleanExpression(const CCombinedValue &expression, bool &result, DWORD dwContextWindow, const CGUIListItem *item)
+{
+  if (expression.m_code.empty()) return false;
+
+  const int *code = &expression.m_code[0];
+  unsigned int size = expression.m_code.size();
+  unsigned int pc = 0;
+  bool value = false;
+  while (pc < size)
+  {
+    switch (code[pc])
+    {
+    case BOOL_OP_LOAD:
+      value = GetBool(code[pc + 1], dwContextWindow, item);
+      break;
+    case BOOL_OP_NOT:
+      value = !value;
+      break;
+    case BOOL_OP_JUMP_IF_FALSE:
+      if (!value)
+      {
+        pc = code[pc + 1];
+        continue;
+      }
+      break;
+    case BOOL_OP_JUMP_IF_TRUE:
+      if (value)
+      {
+        pc = code[pc + 1];
+        continue;
+      }
+      break;
     }
-    else  // operator
-      save.push(GetBool(expr, dwContextWindow, item));
+    pc += 2;
   }
-  if (save.size() != 1) return false;
-  result = save.top();
+  result = value;
   return true;
 }
 
+bool CGUIInfoManager::DependsOnItem(int condition) const
+{
+  condition = abs(condition);
+  if (condition >= COMBINED_VALUES_START && (condition - COMBINED_VALUES_START) < (int)m_CombinedValues.size())
+    return m_CombinedValues[condition - COMBINED_VALUES_START].m_listItem;
+  if (condition >= LISTITEM_START && condition < LISTITEM_END)
+    return true;
+  if (condition >= MULTI_INFO_START && condition <= MULTI_INFO_END && (condition - MULTI_INFO_START) < (int)m_multiInfo.size())
+  { // only String.IsEmpty() of a listitem label looks at the item, see GetMultiInfoBool()
+    const GUIInfo &info = m_multiInfo[condition - MULTI_INFO_START];
+    return abs(info.m_info) == STRING_IS_EMPTY && info.GetData1() >= LISTITEM_START && info.GetData1() < LISTITEM_END;
+  }
+  return false;
+}
+
 int CGUIInfoManager::TranslateBooleanExpression(const CStdString &expression)
 {
   CCombinedValue comb;
@@ -3551,9 +3647,9 @@ int CGUIInfoManager::TranslateBooleanExpression(const CStdString &expression)
     save.pop();
   }
 
-  // test evaluate
+  // compile and test evaluate
   bool test;
-  if (!EvaluateBooleanExpression(comb, test, WINDOW_INVALID))
+  if (!CompileBooleanExpression(comb) || !EvaluateBooleanExpression(comb, test, WINDOW_INVALID))
     CLog::Log(LOGERROR, "Error evaluating boolean expression %s", expression.c_str());
   // success - add to our combined values
   m_CombinedValues.push_back(comb);
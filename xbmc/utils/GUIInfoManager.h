@@ -688,12 +688,16 @@ protected:
     CStdString m_info;    // the text expression
     int m_id;             // the id used to identify this expression
     std::list<int> m_postfix;  // the postfix binary expression
+    std::vector<int> m_code;   // m_postfix compiled for evaluation, see CompileBooleanExpression()
+    bool m_listItem;           // true if an operand looks at the list item
     void operator=(const CCombinedValue& mSrc);
   };
 
   int GetOperator(const char ch);
   int TranslateBooleanExpression(const CStdString &expression);
+  bool CompileBooleanExpression(CCombinedValue &expression);
   bool EvaluateBooleanExpression(const CCombinedValue &expression, bool &result, DWORD dwContextWindow, const CGUIListItem *item=NULL);
+  bool DependsOnItem(int condition) const;
 
   std::vector<CCombinedValue> m_CombinedValues;
 
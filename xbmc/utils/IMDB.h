@@ -67,6 +67,7 @@ public:
   bool ScrapeFilename(const CStdString& strFileName, CVideoInfoTag& details);
 
   void SetScraperInfo(const SScraperInfo& info) { m_info = info; }
+  const SScraperInfo& GetScraperInfo() const { return m_info; }
 protected:
   void RemoveAllAfter(char* szMovie, const char* szSearch);
   void ConvertToUTF8(CStdStringA& xml_);
@@ -22,6 +22,11 @@
 #include "stdafx.h"
 #include "PCMAmplifier.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PCMAMPLIFIER_SSE2
+#include <emmintrin.h>
+#endif
+
 CPCMAmplifier::CPCMAmplifier() : m_nVolume(VOLUME_MAXIMUM), m_dFactor(0)
 {
 	m_intMax = 0;
@@ -50,40 +55,85 @@ int  CPCMAmplifier::GetVolume()
   return m_nVolume;
 }
 
+// gain is applied in 2.14 fixed point, so the SSE2 and C paths give identical samples
+#define GAIN_SHIFT 14
+#define GAIN_UNITY (1 << GAIN_SHIFT)
+
+static int16_t PeakInt16(const int16_t *pcm, int nSamples, int16_t peak)
+{
+  int nSample = 0;
+#ifdef PCMAMPLIFIER_SSE2
+  if (nSamples >= 8)
+  {
+    __m128i max = _mm_set1_epi16(peak);
+    for (; nSample + 8 <= nSamples; nSample += 8)
+      max = _mm_max_epi16(max, _mm_loadu_si128((const __m128i *)(pcm + nSample)));
+
+    int16_t lanes[8];
+    _mm_storeu_si128((__m128i *)lanes, max);
+    for (int i = 0; i < 8; i++)
+      peak = MAX(peak, lanes[i]);
+  }
+#endif
+  for (; nSample < nSamples; nSample++)
+    peak = MAX(peak, pcm[nSample]);
+  return peak;
+}
+
+static void GainInt16(int16_t *pcm, int nSamples, int gain)
+{
+  int nSample = 0;
+#ifdef PCMAMPLIFIER_SSE2
+  const __m128i g     = _mm_set1_epi16((int16_t)gain);
+  const __m128i round = _mm_set1_epi32(1 << (GAIN_SHIFT - 1));
+  for (; nSample + 8 <= nSamples; nSample += 8)
+  {
+    __m128i v  = _mm_loadu_si128((const __m128i *)(pcm + nSample));
+    __m128i lo = _mm_mullo_epi16(v, g);
+    __m128i hi = _mm_mulhi_epi16(v, g);
+    __m128i p0 = _mm_srai_epi32(_mm_add_epi32(_mm_unpacklo_epi16(lo, hi), round), GAIN_SHIFT);
+    __m128i p1 = _mm_srai_epi32(_mm_add_epi32(_mm_unpackhi_epi16(lo, hi), round), GAIN_SHIFT);
+    _mm_storeu_si128((__m128i *)(pcm + nSample), _mm_packs_epi32(p0, p1)); // packs saturates
+  }
+#endif
+  for (; nSample < nSamples; nSample++)
+  {
+    int value = (pcm[nSample] * gain + (1 << (GAIN_SHIFT - 1))) >> GAIN_SHIFT;
+    if (value > SHRT_MAX)
+      value = SHRT_MAX;
+    else if (value < SHRT_MIN)
+      value = SHRT_MIN;
+    pcm[nSample] = (int16_t)value;
+  }
+}
+
 // 16 bit integer de-amplifier
 void CPCMAmplifier::DeAmplifyInt16(int16_t *pcm, int nSamples, bool normalise, bool deamp)
 {
-	if (m_dFactor >= 1.0 && !normalise)
-	{
-		// no process required. using >= to make sure no amp is ever done (only de-amp)
-		return;
-	}
-	
-	if (normalise)
-	{
-		for (int16_t nSample=0; nSample<nSamples; nSample++)
-		{
-			// scan buffer and store maximum level encountered
-			m_intMax = MAX(m_intMax, pcm[nSample]);
-		}
-		// adjust power factor to normalise to 98% (-0.3dB) - only change once per buffer to prevent distortion
-		m_PowerFactor = (double)m_intMax / SHRT_MAX * 0.98;
-		if (m_PowerFactor) m_PowerFactor = 1 / m_PowerFactor;
-		if (m_PowerFactor > 1.5) m_PowerFactor = 1.5;
-	}
-	else m_PowerFactor = 1.0;
-	
-	double volFactor = deamp ? m_dFactor : 1.0;
-	
-	// apply the (possibly new) power factor to the buffer
-	double scale = volFactor * m_PowerFactor;
-	
-	for (int16_t nSample=0; nSample<nSamples; nSample++)
-	{
-		int16_t nSampleValue = pcm[nSample];
-		pcm[nSample] = nSampleValue * scale;
-	}
-	
+  if (m_dFactor >= 1.0 && !normalise)
+  {
+    // no process required. using >= to make sure no amp is ever done (only de-amp)
+    return;
+  }
+
+  if (normalise)
+  {
+    // scan buffer and store maximum level encountered
+    m_intMax = PeakInt16(pcm, nSamples, m_intMax);
+
+    // adjust power factor to normalise to 98% (-0.3dB) - only change once per buffer to prevent distortion
+    m_PowerFactor = (double)m_intMax / SHRT_MAX * 0.98;
+    if (m_PowerFactor) m_PowerFactor = 1 / m_PowerFactor;
+    if (m_PowerFactor > 1.5) m_PowerFactor = 1.5;
+  }
+  else m_PowerFactor = 1.0;
+
+  double volFactor = deamp ? m_dFactor : 1.0;
+
+  // apply the (possibly new) power factor to the buffer
+  int gain = (int)(volFactor * m_PowerFactor * GAIN_UNITY + 0.5);
+  if (gain != GAIN_UNITY)
+    GainInt16(pcm, nSamples, gain);
 }
 
 
@@ -96,11 +146,35 @@ void CPCMAmplifier::DeAmplifyFloat32(float *pcm, int nSamples)
     return;
   }
 
-  for (int nSample=0; nSample<nSamples; nSample++)
-  {
-    float nSampleValue = pcm[nSample];
-    nSampleValue *= m_dFactor;
+  float factor = (float)m_dFactor;
+  int nSample = 0;
+#ifdef PCMAMPLIFIER_SSE2
+  const __m128 f = _mm_set1_ps(factor);
+  for (; nSample + 4 <= nSamples; nSample += 4)
+    _mm_storeu_ps(pcm + nSample, _mm_mul_ps(_mm_loadu_ps(pcm + nSample), f));
+#endif
+  for (; nSample < nSamples; nSample++)
+    pcm[nSample] *= factor;
+}
 
-    pcm[nSample] = nSampleValue;
+void CPCMAmplifier::GainFloat32(float *pcm, int nSamples, float gain)
+{
+  int nSample = 0;
+#ifdef PCMAMPLIFIER_SSE2
+  const __m128 g   = _mm_set1_ps(gain);
+  const __m128 max = _mm_set1_ps(1.0f);
+  const __m128 min = _mm_set1_ps(-1.0f);
+  for (; nSample + 4 <= nSamples; nSample += 4)
+  {
+    __m128 v = _mm_mul_ps(_mm_loadu_ps(pcm + nSample), g);
+    _mm_storeu_ps(pcm + nSample, _mm_max_ps(_mm_min_ps(v, max), min));
+  }
+#endif
+  for (; nSample < nSamples; nSample++)
+  {
+    float value = pcm[nSample] * gain;
+    if (value > 1.0f) value = 1.0f;
+    if (value < -1.0f) value = -1.0f;
+    pcm[nSample] = value;
   }
 }
@@ -31,11 +31,16 @@ public:
 
   void SetVolume(int nVolume);
   int  GetVolume();
-	
-	
+
+  // scales by the volume, saturating. normalise additionally boosts quiet
+  // material towards full scale (by at most 1.5x).
   void DeAmplifyInt16(int16_t *pcm, int nSamples, bool normalise, bool deamp);
+  void DeAmplify(short *pcm, int nSamples) { DeAmplifyInt16(pcm, nSamples, false, true); }
   void DeAmplifyFloat32(float *pcm, int nSamples);
 
+  // multiplies by gain and clamps to [-1, 1]
+  static void GainFloat32(float *pcm, int nSamples, float gain);
+
 protected:
   int m_nVolume;
   double m_dFactor;
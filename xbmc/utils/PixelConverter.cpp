@@ -0,0 +1,104 @@
+/*
+ *      Copyright (C) 2005-2008 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "stdafx.h"
+#include "PixelConverter.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PIXELCONVERTER_SSE2
+#include <emmintrin.h>
+#endif
+
+void CPixelConverter::BGRToBGRA(const BYTE *src, const BYTE *alpha, BYTE *dst, unsigned int width)
+{
+  unsigned int x = 0;
+
+#ifdef PIXELCONVERTER_SSE2
+  // 4 pixels a step. each of the 4 BGR triplets of a 16 byte load is shifted up
+  // into its own 32 bit lane and the alpha byte is or'ed on top.
+  const __m128i mask0  = _mm_set_epi32(0, 0, 0, 0x00ffffff);
+  const __m128i mask1  = _mm_set_epi32(0, 0, 0x00ffffff, 0);
+  const __m128i mask2  = _mm_set_epi32(0, 0x00ffffff, 0, 0);
+  const __m128i mask3  = _mm_set_epi32(0x00ffffff, 0, 0, 0);
+  const __m128i opaque = _mm_set1_epi32(0xff000000);
+  const __m128i zero   = _mm_setzero_si128();
+
+  // the load reads 4 bytes past the 4 pixels, so keep 2 pixels back for the tail
+  for (; x + 6 <= width; x += 4)
+  {
+    __m128i bgr = _mm_loadu_si128((const __m128i *)(src + x * 3));
+    __m128i out = _mm_or_si128(_mm_or_si128(_mm_and_si128(bgr, mask0),
+                                            _mm_and_si128(_mm_slli_si128(bgr, 1), mask1)),
+                               _mm_or_si128(_mm_and_si128(_mm_slli_si128(bgr, 2), mask2),
+                                            _mm_and_si128(_mm_slli_si128(bgr, 3), mask3)));
+    if (alpha)
+    {
+      int a4;
+      memcpy(&a4, alpha + x, 4);
+      __m128i a = _mm_cvtsi32_si128(a4);
+      a = _mm_unpacklo_epi8(zero, a);   // alpha << 8 in 16 bit lanes
+      a = _mm_unpacklo_epi16(zero, a);  // alpha << 24 in 32 bit lanes
+      out = _mm_or_si128(out, a);
+    }
+    else
+      out = _mm_or_si128(out, opaque);
+
+    _mm_storeu_si128((__m128i *)(dst + x * 4), out);
+  }
+#endif
+
+  src += x * 3;
+  dst += x * 4;
+  if (alpha)
+  {
+    for (alpha += x; x < width; x++)
+    {
+      dst[0] = src[0];
+      dst[1] = src[1];
+      dst[2] = src[2];
+      dst[3] = *alpha++;
+      src += 3;
+      dst += 4;
+    }
+  }
+  else
+  {
+    for (; x < width; x++)
+    {
+      dst[0] = src[0];
+      dst[1] = src[1];
+      dst[2] = src[2];
+      dst[3] = 0xff;
+      src += 3;
+      dst += 4;
+    }
+  }
+}
+
+void CPixelConverter::BGRToBGRA(const BYTE *src, unsigned int srcPitch, const BYTE *alpha, unsigned int alphaPitch,
+                                BYTE *dst, unsigned int dstPitch, unsigned int width, unsigned int height, bool flip)
+{
+  for (unsigned int y = 0; y < height; y++)
+  {
+    unsigned int row = flip ? height - 1 - y : y;
+    BGRToBGRA(src + row * srcPitch, alpha ? alpha + row * alphaPitch : NULL, dst + y * dstPitch, width);
+  }
+}
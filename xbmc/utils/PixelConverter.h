@@ -0,0 +1,45 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2005-2008 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+/*
+ * Row converters used when handing decoded images to the renderer.
+ *
+ * The SSE2 versions are picked at compile time (always there on Intel macs and
+ * x86_64), other builds get the plain C versions, which produce identical output.
+ */
+class CPixelConverter
+{
+public:
+  /*
+   * packed 24 bit BGR to 32 bit BGRA for one row of width pixels.
+   * alpha is an optional 8 bit plane, when NULL the pixels are made opaque.
+   */
+  static void BGRToBGRA(const BYTE *src, const BYTE *alpha, BYTE *dst, unsigned int width);
+
+  /*
+   * BGRToBGRA for a whole image. with flip set, source rows are bottom up
+   * (as CxImage hands them out) and are written top down.
+   */
+  static void BGRToBGRA(const BYTE *src, unsigned int srcPitch, const BYTE *alpha, unsigned int alphaPitch,
+                        BYTE *dst, unsigned int dstPitch, unsigned int width, unsigned int height, bool flip);
+};
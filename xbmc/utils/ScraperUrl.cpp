@@ -30,6 +30,7 @@
 #include "FileSystem/FileZip.h"
 #include "Picture.h"
 #include "Util.h"
+#include "Crc32.h"
 
 #include <cstring>
 #include <sstream>
@@ -183,8 +184,32 @@ const CScraperUrl::SUrlEntry CScraperUrl::GetSeasonThumb(int season) const
   return result;
 }
 
+// zipped responses (eg. episode guides) are handed to the scraper unpacked
+static void UnpackZip(const CScraperUrl::SUrlEntry& scrURL, string& strHTML)
+{
+  if (scrURL.m_url.Find(".zip") > -1)
+  {
+    XFILE::CFileZip file;
+    CStdString strBuffer;
+    int iSize = file.UnpackFromMemory(strBuffer,strHTML);
+    if (iSize)
+    {
+      strHTML.clear();
+      strHTML.append(strBuffer.c_str(),strBuffer.data()+iSize);
+    }
+  }
+}
+
 bool CScraperUrl::Get(const SUrlEntry& scrURL, string& strHTML, CHTTP& http)
 {
+  if (!g_advancedSettings.m_scraperFixturePath.IsEmpty())
+  {
+    if (!GetFixture(scrURL, strHTML))
+      return false;
+    UnpackZip(scrURL, strHTML);
+    return true;
+  }
+
   CURL url(scrURL.m_url);
   http.SetReferer(scrURL.m_spoof);
   CStdString strCachePath;
@@ -220,30 +245,56 @@ bool CScraperUrl::Get(const SUrlEntry& scrURL, string& strHTML, CHTTP& http)
     if (!http.Get(scrURL.m_url, strHTML))
       return false;
 
-  if (scrURL.m_url.Find(".zip") > -1)
-  {
-    XFILE::CFileZip file;
-    CStdString strBuffer;
-    int iSize = file.UnpackFromMemory(strBuffer,strHTML);
-    if (iSize)
-    {
-      strHTML.clear();
-      strHTML.append(strBuffer.c_str(),strBuffer.data()+iSize);
-    }
-  }
+  UnpackZip(scrURL, strHTML);
 
   if (!scrURL.m_cache.IsEmpty())
   {
     CStdString strCachePath;
     CUtil::AddFileToFolder(g_advancedSettings.m_cachePath,"scrapers\\"+scrURL.m_cache,strCachePath);
+
+    // several scraper threads share the cache, so it's written under a name of its
+    // own and renamed into place - readers never see a half written file
+    CStdString strTempPath;
+    strTempPath.Format("%s.%u.tmp", strCachePath.c_str(), (unsigned int)GetCurrentThreadId());
     XFILE::CFile file;
-    if (file.OpenForWrite(strCachePath,true,true))
-      file.Write(strHTML.data(),strHTML.size());
+    bool bWritten = false;
+    if (file.OpenForWrite(strTempPath,true,true))
+      bWritten = file.Write(strHTML.data(),strHTML.size()) == (int)strHTML.size();
     file.Close();
+    if (!bWritten || !XFILE::CFile::Rename(strTempPath, strCachePath))
+      XFILE::CFile::Delete(strTempPath); // another thread got there first, or the write failed
   }
   return true;
 }
 
+// with <scraperfixtures> set, scrapers run against local files only: every request
+// is answered with <crc of the lower case url>.html from that folder, so a scraper
+// can be checked against saved pages without going online
+bool CScraperUrl::GetFixture(const SUrlEntry& scrURL, string& strHTML)
+{
+  Crc32 crc;
+  crc.ComputeFromLowerCase(scrURL.m_url);
+  CStdString strFile;
+  strFile.Format("%08x.html", (unsigned __int32) crc);
+  CStdString strPath;
+  CUtil::AddFileToFolder(g_advancedSettings.m_scraperFixturePath, strFile, strPath);
+
+  XFILE::CFile file;
+  if (!file.Open(strPath))
+  {
+    CLog::Log(LOGWARNING, "%s - no fixture %s for %s", __FUNCTION__, strPath.c_str(), scrURL.m_url.c_str());
+    return false;
+  }
+  CLog::Log(LOGDEBUG, "%s - using fixture %s for %s", __FUNCTION__, strPath.c_str(), scrURL.m_url.c_str());
+
+  char buffer[4096];
+  unsigned int iRead;
+  while ((iRead = file.Read(buffer, sizeof(buffer))) > 0)
+    strHTML.append(buffer, iRead);
+  file.Close();
+  return true;
+}
+
 bool CScraperUrl::DownloadThumbnail(const CStdString &thumb, const CScraperUrl::SUrlEntry& entry)
 {
   if (entry.m_url.IsEmpty())
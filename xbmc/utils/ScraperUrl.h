@@ -62,6 +62,7 @@ public:
   const SUrlEntry GetSeasonThumb(int) const;
   void Clear();
   static bool Get(const SUrlEntry&, std::string&, CHTTP& http);
+  static bool GetFixture(const SUrlEntry&, std::string&);
   static bool DownloadThumbnail(const CStdString &thumb, const SUrlEntry& entry);
   static void ClearCache();
 
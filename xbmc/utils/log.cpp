@@ -29,14 +29,341 @@
 #include "StdString.h"
 #include "Settings.h"
 #include "Util.h"
+#include "Thread.h"
+#include "Event.h"
+#include "FileSystem/SPSCRingBuffer.h"
+#include <algorithm>
+
+#define LOG_BUFFER_SIZE     (64 * 1024)           // per thread queue
+#define LOG_MAX_RECORD      (LOG_BUFFER_SIZE / 2) // anything bigger is written synchronously
+#define LOG_MAX_BUFFERS     64                    // threads beyond this write synchronously
+#define LOG_WRITER_INTERVAL 100                   // ms between writer passes
 
 FILE* CLog::fd = NULL;
 
-static CCriticalSection critSec;
+static CCriticalSection critSec; // guards fd and everything written to it
+static CCriticalSection stopSec; // held while the writer drains on stop, taken before critSec
 
 static char levelNames[][8] =
 {"DEBUG", "INFO", "NOTICE", "WARNING", "ERROR", "SEVERE", "FATAL", "NONE"};
 
+static __int64       logFileSize = 0;
+static LONG          logSequence = 0;
+static MEMORYSTATUS  logMemory; // sampled by the writer on every pass
+
+// every queued message starts with this, the text follows without terminator
+struct SLogRecordHeader
+{
+  unsigned int iSeq;    // global order of the messages across threads
+  unsigned int iLength;
+};
+
+struct SLogBuffer
+{
+  CSPSCRingBuffer       ring;
+  volatile unsigned int iDropped;     // only written by the owning thread
+  unsigned int          iDroppedSeen; // only used by the writer
+  volatile bool         bRetired;     // owning thread has exited
+#ifndef _LINUX
+  HANDLE                hThread;
+#endif
+};
+
+/**
+ * Background writer of the log.
+ * Every logging thread gets its own single producer, single consumer queue of
+ * formatted messages, so Log() neither waits for a lock nor for the disk. The
+ * writer merges the queues in message order and writes them out in batches.
+ */
+class CLogWriter : public CThread
+{
+public:
+  CLogWriter();
+
+  // returns false if the message has to be written by the caller
+  bool Queue(int loglevel, CStdString& strRecord);
+  void Stop();
+
+protected:
+  virtual void Process();
+  bool QueueRecord(int loglevel, CStdString& strRecord);
+  void Drain();
+  SLogBuffer* GetBuffer();
+
+  std::vector<SLogBuffer*> m_buffers;
+  CCriticalSection         m_section; // guards m_buffers
+  CEvent                   m_wake;
+  LONG                     m_iProducers; // threads inside Queue()
+};
+
+// the writer is never deleted, threads may still hold on to it while logging on exit
+static CLogWriter* volatile logWriter = NULL;
+static bool logWriterStopped = false;
+
+#ifdef _LINUX
+static pthread_once_t logKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t  logBufferKey;
+
+static void RetireBuffer(void* pBuffer)
+{
+  SPSC_MEMORY_BARRIER();
+  ((SLogBuffer*)pBuffer)->bRetired = true;
+}
+
+static void MakeLogBufferKey()
+{
+  pthread_key_create(&logBufferKey, RetireBuffer);
+}
+#else
+static DWORD logBufferKey = TlsAlloc();
+#endif
+
+static void FormatPrefix(int loglevel, CStdString& strPrefix)
+{
+  SYSTEMTIME time;
+  GetLocalTime(&time);
+
+  // querying the memory status costs several syscalls, use the writer's sample when it runs
+  MEMORYSTATUS stat;
+  if (logWriter)
+    stat = logMemory;
+  else
+    GlobalMemoryStatus(&stat);
+
+#ifdef __APPLE__
+  strPrefix.Format("%02.2d:%02.2d:%02.2d T:%lu M:%9ju %7s: ", time.wHour, time.wMinute, time.wSecond, GetCurrentThreadId(), stat.dwAvailPhys, levelNames[loglevel]);
+#else
+  strPrefix.Format("%02.2d:%02.2d:%02.2d T:%lu M:%9u %7s: ", time.wHour, time.wMinute, time.wSecond, GetCurrentThreadId(), stat.dwAvailPhys, levelNames[loglevel]);
+#endif
+}
+
+// caller holds critSec
+static FILE* OpenLogFile()
+{
+  // g_stSettings.m_logFolder is initialized in the CSettings constructor to Q:
+  // and if we are running from DVD, it's changed to T: in CApplication::Create()
+  CStdString strLogFile, strLogFileOld;
+
+#ifdef __APPLE__
+  strLogFile.Format("%sPlex.log", _P(g_stSettings.m_logFolder).c_str());
+  strLogFileOld.Format("%sPlex.old.log", _P(g_stSettings.m_logFolder).c_str());
+#else
+  strLogFile.Format("%sxbmc.log", _P(g_stSettings.m_logFolder).c_str());
+  strLogFileOld.Format("%sxbmc.old.log", _P(g_stSettings.m_logFolder).c_str());
+#endif
+
+#ifndef _LINUX
+  ::DeleteFile(strLogFileOld.c_str());
+  ::MoveFile(strLogFile.c_str(), strLogFileOld.c_str());
+#else
+  ::unlink(strLogFileOld.c_str());
+  ::rename(strLogFile.c_str(), strLogFileOld.c_str());
+#endif
+
+  logFileSize = 0;
+#ifndef _LINUX
+  return _fsopen(strLogFile, "a+", _SH_DENYWR);
+#else
+  return fopen(strLogFile, "a+");
+#endif
+}
+
+// caller holds critSec
+static void WriteLogFile(FILE*& fd, const char* pData, unsigned int iSize)
+{
+  if (!fd)
+    fd = OpenLogFile();
+  if (!fd)
+    return;
+
+  fwrite(pData, iSize, 1, fd);
+  fflush(fd);
+
+  logFileSize += iSize;
+  if (g_advancedSettings.m_logRotateSize > 0 && logFileSize >= (__int64)g_advancedSettings.m_logRotateSize * 1024)
+  {
+    fclose(fd);
+    fd = OpenLogFile();
+  }
+}
+
+CLogWriter::CLogWriter() : m_iProducers(0)
+{
+#ifdef _LINUX
+  pthread_once(&logKeyOnce, MakeLogBufferKey);
+#endif
+  GlobalMemoryStatus(&logMemory);
+}
+
+SLogBuffer* CLogWriter::GetBuffer()
+{
+#ifdef _LINUX
+  SLogBuffer* pBuffer = (SLogBuffer*)pthread_getspecific(logBufferKey);
+#else
+  SLogBuffer* pBuffer = (SLogBuffer*)TlsGetValue(logBufferKey);
+#endif
+  if (pBuffer)
+    return pBuffer;
+
+  CSingleLock lock(m_section);
+  if (m_buffers.size() >= LOG_MAX_BUFFERS)
+    return NULL;
+
+  pBuffer = new SLogBuffer;
+  if (!pBuffer->ring.Create(LOG_BUFFER_SIZE))
+  {
+    delete pBuffer;
+    return NULL;
+  }
+  pBuffer->iDropped     = 0;
+  pBuffer->iDroppedSeen = 0;
+  pBuffer->bRetired     = false;
+#ifdef _LINUX
+  pthread_setspecific(logBufferKey, pBuffer);
+#else
+  // no destructors for tls values, the writer watches the thread instead
+  DuplicateHandle(GetCurrentProcess(), GetCurrentThread(), GetCurrentProcess(), &pBuffer->hThread, SYNCHRONIZE, FALSE, 0);
+  TlsSetValue(logBufferKey, pBuffer);
+#endif
+  m_buffers.push_back(pBuffer);
+  return pBuffer;
+}
+
+bool CLogWriter::Queue(int loglevel, CStdString& strRecord)
+{
+  // counted before m_bStop is looked at, so Stop() can wait for everyone that got past it
+  InterlockedIncrement(&m_iProducers);
+  bool bQueued = QueueRecord(loglevel, strRecord);
+  InterlockedDecrement(&m_iProducers);
+  return bQueued;
+}
+
+bool CLogWriter::QueueRecord(int loglevel, CStdString& strRecord)
+{
+  if (m_bStop || strRecord.size() > LOG_MAX_RECORD)
+    return false;
+
+  SLogBuffer* pBuffer = GetBuffer();
+  if (!pBuffer)
+    return false;
+
+  while (pBuffer->ring.GetMaxWriteSize() < strRecord.size())
+  {
+    // the writer itself must never wait for its own queue
+    if (!g_advancedSettings.m_logBlockOnOverflow || GetCurrentThreadId() == ThreadId())
+    {
+      pBuffer->iDropped++;
+      return true;
+    }
+    if (m_bStop)
+      return false;
+
+    m_wake.Set();
+    ::Sleep(1);
+  }
+
+  SLogRecordHeader header;
+  header.iSeq    = (unsigned int)InterlockedIncrement(&logSequence);
+  header.iLength = strRecord.size() - sizeof(SLogRecordHeader);
+  memcpy(&strRecord[0], &header, sizeof(header));
+  pBuffer->ring.WriteBinary(strRecord.c_str(), strRecord.size());
+
+  // errors go out right away, everything else with the next pass
+  if (loglevel >= LOGERROR || pBuffer->ring.GetMaxReadSize() > LOG_BUFFER_SIZE / 2)
+    m_wake.Set();
+  return true;
+}
+
+static bool SortBySequence(const std::pair<unsigned int, CStdString>& lhs, const std::pair<unsigned int, CStdString>& rhs)
+{
+  return lhs.first < rhs.first;
+}
+
+void CLogWriter::Drain()
+{
+  std::vector<std::pair<unsigned int, CStdString> > records;
+
+  {
+    CSingleLock lock(m_section);
+    for (std::vector<SLogBuffer*>::iterator it = m_buffers.begin(); it != m_buffers.end();)
+    {
+      SLogBuffer* pBuffer = *it;
+#ifdef _LINUX
+      bool bRetired = pBuffer->bRetired;
+#else
+      bool bRetired = WaitForSingleObject(pBuffer->hThread, 0) == WAIT_OBJECT_0;
+#endif
+      SPSC_MEMORY_BARRIER();
+
+      SLogRecordHeader header;
+      while (pBuffer->ring.PeekBinary((char*)&header, sizeof(header)))
+      {
+        pBuffer->ring.SkipBytes(sizeof(header));
+        records.push_back(std::make_pair(header.iSeq, CStdString()));
+        CStdString& strLine = records.back().second;
+        strLine.resize(header.iLength);
+        pBuffer->ring.ReadBinary(&strLine[0], header.iLength);
+      }
+
+      unsigned int iDropped = pBuffer->iDropped;
+      if (iDropped != pBuffer->iDroppedSeen)
+      {
+        CStdString strLine;
+        FormatPrefix(LOGWARNING, strLine);
+        strLine.AppendFormat("CLog - %u messages dropped, the log queue of a thread was full\n", iDropped - pBuffer->iDroppedSeen);
+        records.push_back(std::make_pair((unsigned int)logSequence, strLine));
+        pBuffer->iDroppedSeen = iDropped;
+      }
+
+      if (bRetired)
+      {
+#ifndef _LINUX
+        CloseHandle(pBuffer->hThread);
+#endif
+        delete pBuffer;
+        it = m_buffers.erase(it);
+      }
+      else
+        ++it;
+    }
+  }
+
+  if (records.empty())
+    return;
+
+  std::stable_sort(records.begin(), records.end(), SortBySequence);
+
+  CStdString strBatch;
+  for (unsigned int i = 0; i < records.size(); i++)
+    strBatch += records[i].second;
+
+  CSingleLock lock(critSec);
+  WriteLogFile(CLog::fd, strBatch.c_str(), strBatch.size());
+}
+
+void CLogWriter::Process()
+{
+  while (!m_bStop)
+  {
+    m_wake.WaitMSec(LOG_WRITER_INTERVAL);
+    GlobalMemoryStatus(&logMemory);
+    Drain();
+  }
+  Drain();
+}
+
+void CLogWriter::Stop()
+{
+  m_bStop = true;
+  m_wake.Set();
+  StopThread();
+
+  // a producer that saw m_bStop unset may still be writing its record, later
+  // ones write synchronously. the interlocked read orders it after m_bStop.
+  while (InterlockedCompareExchange(&m_iProducers, 0, 0) > 0)
+    ::Sleep(1);
+  Drain(); // anything queued while we were stopping
+}
 
 CLog::CLog()
 {}
@@ -46,6 +373,8 @@ CLog::~CLog()
 
 void CLog::Close()
 {
+  StopAsync();
+
   CSingleLock waitLock(critSec);
   if (fd)
   {
@@ -54,58 +383,51 @@ void CLog::Close()
   }
 }
 
+void CLog::StopAsync()
+{
+  // synchronous writes wait for the drain, or they would pass the same thread's queued messages
+  CSingleLock stopLock(stopSec);
+  CLogWriter* pWriter;
+  {
+    CSingleLock waitLock(critSec);
+    pWriter = logWriter;
+    logWriter = NULL;
+    logWriterStopped = true;
+  }
+
+  if (pWriter)
+    pWriter->Stop();
+}
 
 void CLog::Log(int loglevel, const char *format, ... )
 {
   if (g_advancedSettings.m_logLevel > LOG_LEVEL_NORMAL ||
      (g_advancedSettings.m_logLevel > LOG_LEVEL_NONE && loglevel >= LOGNOTICE))
   {
-    CSingleLock waitLock(critSec);
-    if (!fd)
+    // once the writer runs, nothing here takes a lock
+    CLogWriter* pWriter = logWriter;
+    if (!pWriter)
     {
-      // g_stSettings.m_logFolder is initialized in the CSettings constructor to Q:
-      // and if we are running from DVD, it's changed to T: in CApplication::Create()
-      CStdString strLogFile, strLogFileOld;
+      CSingleLock waitLock(critSec);
+      if (!fd)
+        fd = OpenLogFile();
 
-#ifdef __APPLE__
-      strLogFile.Format("%sPlex.log", _P(g_stSettings.m_logFolder).c_str());
-      strLogFileOld.Format("%sPlex.old.log", _P(g_stSettings.m_logFolder).c_str());
-#else
-      strLogFile.Format("%sxbmc.log", _P(g_stSettings.m_logFolder).c_str());
-      strLogFileOld.Format("%sxbmc.old.log", _P(g_stSettings.m_logFolder).c_str());
-#endif
+      if (!fd)
+        return ;
 
-#ifndef _LINUX
-      ::DeleteFile(strLogFileOld.c_str());
-      ::MoveFile(strLogFile.c_str(), strLogFileOld.c_str());
-#else
-      ::unlink(strLogFileOld.c_str());
-      ::rename(strLogFile.c_str(), strLogFileOld.c_str());
-#endif
-
-#ifndef _LINUX
-      fd = _fsopen(strLogFile, "a+", _SH_DENYWR);
-#else
-      fd = fopen(strLogFile, "a+");
-#endif
+      if (!logWriter && !logWriterStopped)
+      {
+        logWriter = new CLogWriter;
+        logWriter->Create();
+      }
+      pWriter = logWriter;
     }
 
-    if (!fd)
-      return ;
-
-    SYSTEMTIME time;
-    GetLocalTime(&time);
-
-    MEMORYSTATUS stat;
-    GlobalMemoryStatus(&stat);
-
+    // the record gets its header when it is queued
+    CStdString strRecord;
+    strRecord.append(sizeof(SLogRecordHeader), '\0');
     CStdString strPrefix, strData;
-
-#ifdef __APPLE__
-    strPrefix.Format("%02.2d:%02.2d:%02.2d T:%lu M:%9ju %7s: ", time.wHour, time.wMinute, time.wSecond, GetCurrentThreadId(), stat.dwAvailPhys, levelNames[loglevel]);
-#else
-    strPrefix.Format("%02.2d:%02.2d:%02.2d T:%lu M:%9u %7s: ", time.wHour, time.wMinute, time.wSecond, GetCurrentThreadId(), stat.dwAvailPhys, levelNames[loglevel]);
-#endif
+    FormatPrefix(loglevel, strPrefix);
 
     strData.reserve(16384);
     va_list va;
@@ -132,9 +454,15 @@ void CLog::Log(int loglevel, const char *format, ... )
     strData.Replace("\n", "\n                             ");
     strData += "\n";
 
-    fwrite(strPrefix.c_str(), strPrefix.size(), 1, fd);
-    fwrite(strData.c_str(), strData.size(), 1, fd);
-    fflush(fd);
+    strRecord += strPrefix;
+    strRecord += strData;
+
+    if (!pWriter || !pWriter->Queue(loglevel, strRecord))
+    {
+      CSingleLock stopLock(stopSec);
+      CSingleLock waitLock(critSec);
+      WriteLogFile(fd, strRecord.c_str() + sizeof(SLogRecordHeader), strRecord.size() - sizeof(SLogRecordHeader));
+    }
   }
 #ifndef _LINUX
 #if defined(_DEBUG) || defined(PROFILE)
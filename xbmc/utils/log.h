@@ -48,11 +48,15 @@
 
 class CLog
 {
+  friend class CLogWriter;
   static FILE* fd;
 public:
   CLog();
   virtual ~CLog(void);
   static void Close();
+  // writes out everything queued and stops the background writer,
+  // messages logged afterwards are written by the calling thread
+  static void StopAsync();
   static void Log(int loglevel, const char *format, ... ) ATTRIB_LOG_FORMAT;
   static void DebugLog(const char *format, ...);
   static void MemDump(BYTE *pData, int length);